@@ -105,6 +105,140 @@ const std::string& rfind(int tag)
 	return null_str;
 }
 
+namespace {
+// value of template's attribute, split into literal text and symbol slots.
+struct tslot
+{
+	tslot()
+		: generic(false)
+		, text()
+		, parts()
+	{}
+
+	// use syntax that slot doesn't support, interpolate text at instance.
+	bool generic;
+	std::string text;
+	// first: true is symbol name, false is literal text.
+	std::vector<std::pair<bool, std::string> > parts;
+};
+
+struct tnode
+{
+	std::string key;
+	std::vector<std::pair<std::string, tslot> > attrs;
+	std::vector<tnode> children;
+};
+
+// compiled template, one root node per [anim] of the template id.
+std::map<std::string, std::vector<tnode> > tpl_programs;
+
+bool is_symbol_char(char c)
+{
+	return (c & ~0x7f) == 0 && (isalnum(c) || c == '_');
+}
+
+void compile_slot(const std::string& value, tslot& slot)
+{
+	std::string literal;
+	const size_t size = value.size();
+	size_t at = 0;
+	while (at < size) {
+		if (value[at] != '$') {
+			literal.push_back(value[at ++]);
+			continue;
+		}
+		size_t end = at + 1;
+		while (end < size && is_symbol_char(value[end])) {
+			end ++;
+		}
+		const char next = end < size? value[end]: '\0';
+		if (next == '$' || next == '.' || next == '[' || next == ']' || next == '(') {
+			// formula, array, nested or pointer symbol. result of
+			// interpolate_variables_into_string depends on symbol's value.
+			slot.generic = true;
+			slot.text = value;
+			slot.parts.clear();
+			return;
+		}
+		const std::string name = value.substr(at + 1, end - at - 1);
+		if (next == '|') {
+			end ++;
+		}
+		if (name.empty()) {
+			// "$|" and "$" not followed by name are "$".
+			literal.push_back('$');
+		} else {
+			if (!literal.empty()) {
+				slot.parts.push_back(std::make_pair(false, literal));
+				literal.clear();
+			}
+			slot.parts.push_back(std::make_pair(true, name));
+		}
+		at = end;
+	}
+	if (!literal.empty()) {
+		slot.parts.push_back(std::make_pair(false, literal));
+	}
+}
+
+void compile_node(const config& cfg, tnode& node)
+{
+	BOOST_FOREACH (const config::attribute &i, cfg.attribute_range()) {
+		node.attrs.push_back(std::make_pair(i.first, tslot()));
+		compile_slot(i.second, node.attrs.back().second);
+	}
+	BOOST_FOREACH (const config::any_child& c, cfg.all_children_range()) {
+		node.children.push_back(tnode());
+		node.children.back().key = c.key;
+		compile_node(c.cfg, node.children.back());
+	}
+}
+
+void bind_node(const tnode& node, config& dst, const utils::string_map& symbols)
+{
+	std::string value;
+	for (std::vector<std::pair<std::string, tslot> >::const_iterator it = node.attrs.begin(); it != node.attrs.end(); ++ it) {
+		const tslot& slot = it->second;
+		if (slot.generic) {
+			dst[it->first] = utils::interpolate_variables_into_string(slot.text, &symbols);
+			continue;
+		}
+		value.clear();
+		for (std::vector<std::pair<bool, std::string> >::const_iterator it2 = slot.parts.begin(); it2 != slot.parts.end(); ++ it2) {
+			if (it2->first) {
+				utils::string_map::const_iterator find_it = symbols.find(it2->second);
+				if (find_it != symbols.end()) {
+					value.append(find_it->second);
+				}
+			} else {
+				value.append(it2->second);
+			}
+		}
+		dst[it->first] = value;
+	}
+	for (std::vector<tnode>::const_iterator it = node.children.begin(); it != node.children.end(); ++ it) {
+		bind_node(*it, dst.add_child(it->key), symbols);
+	}
+}
+
+const std::vector<tnode>& tpl_program(const std::string& tpl_id)
+{
+	std::map<std::string, std::vector<tnode> >::iterator find_it = tpl_programs.find(tpl_id);
+	if (find_it != tpl_programs.end()) {
+		return find_it->second;
+	}
+	std::vector<tnode>& program = tpl_programs[tpl_id];
+
+	typedef std::multimap<std::string, const config>::const_iterator Itor;
+	std::pair<Itor, Itor> its = instance->utype_anim_tpls().equal_range(tpl_id);
+	for (; its.first != its.second; ++ its.first) {
+		program.push_back(tnode());
+		compile_node(its.first->second, program.back());
+	}
+	return program;
+}
+}
+
 void fill_anims(const config& cfg)
 {
 	if (!instance) {
@@ -114,6 +248,7 @@ void fill_anims(const config& cfg)
 
 	fill_tags();
 	instance->clear_anims();
+	tpl_programs.clear();
 
 	utils::string_map symbols;
 	std::stringstream ss;
@@ -156,22 +291,11 @@ const animation* anim(int at)
 	return instance->anim(at);
 }
 
-static void utype_anim_replace_cfg_inernal(const config& src, config& dst, const utils::string_map& symbols)
-{
-	BOOST_FOREACH (const config::any_child& c, src.all_children_range()) {
-		config& adding = dst.add_child(c.key);
-		BOOST_FOREACH (const config::attribute &i, c.cfg.attribute_range()) {
-			adding[i.first] = utils::interpolate_variables_into_string(i.second, &symbols);
-		}
-		utype_anim_replace_cfg_inernal(c.cfg, adding, symbols);
-	}
-}
-
 void utype_anim_create_cfg(const std::string& anim_renamed_key, const std::string& tpl_id, config& dst, const utils::string_map& symbols)
 {
-	typedef std::multimap<std::string, const config>::const_iterator Itor;
-	std::pair<Itor, Itor> its = instance->utype_anim_tpls().equal_range(tpl_id);
-	while (its.first != its.second) {
+	// template is compiled at first use, instance only binds symbols.
+	const std::vector<tnode>& program = tpl_program(tpl_id);
+	for (std::vector<tnode>::const_iterator it = program.begin(); it != program.end(); ++ it) {
 		// tpl          animation instance
 		// [anim] ----> [anim_renamed_key]
 		config& sub_cfg = dst.add_child(anim_renamed_key);
@@ -181,13 +305,7 @@ void utype_anim_create_cfg(const std::string& anim_renamed_key, const std::strin
 		if (symbols.count("offset_y")) {
 			sub_cfg["offset_y"] = symbols.find("offset_y")->second;
 		}
-		const config& anim_cfg = its.first->second;
-		// replace
-		BOOST_FOREACH (const config::attribute &i, anim_cfg.attribute_range()) {
-			sub_cfg[i.first] = utils::interpolate_variables_into_string(i.second, &symbols);
-		}
-		utype_anim_replace_cfg_inernal(anim_cfg, sub_cfg, symbols);
-		++ its.first;
+		bind_node(*it, sub_cfg, symbols);
 	}
 }
 
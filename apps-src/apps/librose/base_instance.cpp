@@ -40,7 +40,6 @@ base_instance* instance = nullptr;
 void base_instance::regenerate_heros(hero_map& heros, bool allow_empty)
 {
 	const std::string hero_data_path = game_config::path + "/xwml/" + "hero.dat";
-	heros.map_from_file(hero_data_path);
 	if (!heros.map_from_file(hero_data_path)) {
 		if (allow_empty) {
 			// allow no hero.dat
@@ -243,6 +242,7 @@ base_instance::base_instance(int argc, char** argv, int sample_rate, size_t soun
 
 base_instance::~base_instance()
 {
+	get_frame_profiler().save_spike_trace();
 	close();
 
 	if (icon_) {
@@ -379,6 +379,8 @@ void base_instance::handle_app_event(Uint32 type)
 	if (type == SDL_APP_TERMINATING || type == SDL_QUIT) {
 		posix_print("handle_app_event, SDL_APP_TERMINATING(0x%x)\n", type);
 		app_terminating();
+		// app may be killed at any time from now, don't leave scheduled write in memory.
+		preferences::flush_preferences();
 
 		terminating_ = true;
 #ifdef ANDROID
@@ -393,6 +395,7 @@ void base_instance::handle_app_event(Uint32 type)
 	} else if (type == SDL_APP_WILLENTERBACKGROUND) {
 		posix_print("handle_app_event, SDL_APP_WILLENTERBACKGROUND\n");
 		app_willenterbackground();
+		preferences::flush_preferences();
 		// FIX SDL BUG! normally DIDENTERBACKGROUND should be called after WILLENTERBACKGROUND.
 		// but on iOS, because SDL event queue, SDL-DIDENTERBACKGROUND is called, but app-DIDENTERBACKGROUND not!
 		// app-DIDENTERBACKGROUND is call when WILLENTERFOREGROUND.
@@ -583,10 +586,12 @@ void base_instance::load_game_cfg(const bool force)
 		// set_unit_data(game_config_.child("units"));
 		// game_config_.clear_children("units");
 
-		anim2::fill_anims(game_config_.child("units"));
+		// read through a const reference, a non-const child handed out is never shared with core_cfg_.
+		const config& game_cfg = game_config_;
+		anim2::fill_anims(game_cfg.child("units"));
 	
 
-		const config::const_child_itors& terrains = game_config_.child_range("terrain_type");
+		const config::const_child_itors& terrains = game_cfg.child_range("terrain_type");
 		BOOST_FOREACH (const config &t, terrains) {
 			tmap::terrain_types.add_child("terrain_type", t);
 		}
@@ -612,7 +617,7 @@ void base_instance::load_game_cfg(const bool force)
 		// game_config_.splice_children(core_terrain_rules, "terrain_graphics");
 
 		config& hashes = game_config_.add_child("multiplayer_hashes");
-		BOOST_FOREACH (const config &ch, game_config_.child_range("multiplayer")) {
+		BOOST_FOREACH (const config &ch, game_cfg.child_range("multiplayer")) {
 			hashes[ch["id"]] = ch.hash();
 		}
 
@@ -751,6 +756,8 @@ void base_instance::initialize()
 	if (!res) {
 		throw twml_exception("could not initialize display");
 	}
+	// "show_fps" in preferences.cfg enables it on device without ui.
+	get_frame_profiler().set_enabled(preferences::show_fps());
 
 	cursor_manager_ = new cursor::manager;
 	cursor::set(cursor::WAIT);
@@ -828,6 +835,7 @@ tlobby* base_instance::create_lobby()
 
 void base_instance::pump()
 {
+	tasks_.pump();
 	sdl_thread_.pump();
 	lobby->pump();
 }
\ No newline at end of file
@@ -27,6 +27,7 @@
 #include "cursor.hpp"
 #include "loadscreen.hpp"
 #include "lobby.hpp"
+#include "thread.hpp"
 
 #include "webrtc/base/thread.h"
 #include "webrtc/base/physicalsocketserver.h"
@@ -130,6 +131,7 @@ public:
 	gui2::tchat_* chat() const { return chat_; }
 
 	rtc::SDLThread& sdl_thread() { return sdl_thread_; }
+	ttask_queue& tasks() { return tasks_; }
 	void pump();
 
 protected:
@@ -187,6 +189,8 @@ protected:
 
 	gui2::tchat_* chat_;
 	rtc::SDLThread sdl_thread_;
+	// posted by worker threads, run in pump.
+	ttask_queue tasks_;
 };
 
 extern base_instance* instance;
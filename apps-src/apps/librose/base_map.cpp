@@ -20,6 +20,8 @@
 #include "wml_exception.hpp"
 #include "base_controller.hpp"
 
+#include <algorithm>
+
 #define index(x, y)  (w_ * (y) + (x))
 
 base_map::base_map(base_controller& controller, const tmap& gmap, bool consistent) 
@@ -33,6 +35,10 @@ base_map::base_map(base_controller& controller, const tmap& gmap, bool consisten
 	, coor_map_(nullptr)
 	, consistent_(consistent)
 	, place_unsort_(false)
+	, click_cells_()
+	, click_cols_(0)
+	, click_rows_(0)
+	, ext_free_()
 {}
 
 base_map &base_map::operator=(const base_map &that)
@@ -79,6 +85,7 @@ void base_map::create_coor_map(int w, int h)
 
 	coor_map_ = (loc_cookie*)malloc(w * h * sizeof(loc_cookie));
 	memset(coor_map_, 0, w * h * sizeof(loc_cookie));
+	ext_free_.assign(h, 0);
 
 	// remember this size
 	w_ = w;
@@ -105,44 +112,129 @@ void base_map::move(const map_location src, const map_location& dst)
 }
 
 // u must be existed in map_.
+// except u, map_ is kept sorted by sort_compare, so binary search the place.
 void base_map::sort_map(base_unit& u)
 {
 	VALIDATE(u.map_index_ != UNIT_NO_INDEX, null_str);
 
-	int i;
-	for (i = 0; i < map_vsize_; i ++) {
-		const base_unit* that = map_[i];
-		if (that == &u) {
-			continue;
-		}
-
+	const int from = u.map_index_;
+	// search in map_ without u, find first unit that u should be before.
+	int i = 0, last = map_vsize_ - 1;
+	while (i < last) {
+		int mid = (i + last) / 2;
+		const base_unit* that = map_[mid < from? mid: mid + 1];
 		if (u.sort_compare(*that)) {
-			break;
+			last = mid;
+		} else {
+			i = mid + 1;
 		}
 	}
-	if (u.map_index_ == i - 1) {
+	if (i == from) {
 		return;
 	}
 
-	// if u require from middle to last, i will equal to map_vsize_
-	
-	if (i > u.map_index_) {
-		i --;
-		for (int i2 = u.map_index_; i2 < i; i2 ++) {
-			map_[i2] = map_[i2 + 1];
-			map_[i2]->map_index_ = i2;
+	int first;
+	if (i > from) {
+		memmove(map_ + from, map_ + from + 1, (i - from) * sizeof(base_unit*));
+		first = from;
+		last = i;
+	} else {
+		memmove(map_ + i + 1, map_ + i, (from - i) * sizeof(base_unit*));
+		first = i;
+		last = from;
+	}
+	map_[i] = &u;
+	for (int i2 = first; i2 <= last; i2 ++) {
+		map_[i2]->map_index_ = i2;
+	}
+}
 
+void base_map::click_index_insert(base_unit& u)
+{
+	const SDL_Rect& rect = u.rect_;
+	if (u.base_ || SDL_RectEmpty(&rect)) {
+		return;
+	}
+	const int xmin = std::max(0, rect.x) >> click_cell_shift;
+	const int ymin = std::max(0, rect.y) >> click_cell_shift;
+	const int xmax = std::max(0, rect.x + rect.w - 1) >> click_cell_shift;
+	const int ymax = std::max(0, rect.y + rect.h - 1) >> click_cell_shift;
+
+	if (xmax >= click_cols_ || ymax >= click_rows_) {
+		// grow geometrically, move existed cells into new pitch.
+		const int cols = std::max(xmax + 1, click_cols_ * 2);
+		const int rows = std::max(ymax + 1, click_rows_ * 2);
+		std::vector<std::vector<base_unit*> > cells(cols * rows);
+		for (int y = 0; y < click_rows_; y ++) {
+			for (int x = 0; x < click_cols_; x ++) {
+				cells[y * cols + x].swap(click_cells_[y * click_cols_ + x]);
+			}
 		}
-	} else {
-		for (int i2 = u.map_index_; i2 > i; i2 --) {
-			map_[i2] = map_[i2 - 1];
-			map_[i2]->map_index_ = i2;
+		click_cells_.swap(cells);
+		click_cols_ = cols;
+		click_rows_ = rows;
+	}
 
+	for (int y = ymin; y <= ymax; y ++) {
+		for (int x = xmin; x <= xmax; x ++) {
+			click_cells_[y * click_cols_ + x].push_back(&u);
 		}
 	}
+	u.indexed_rect_ = rect;
+}
 
-	map_[i] = &u;
-	u.map_index_ = i;
+void base_map::click_index_erase(base_unit& u)
+{
+	const SDL_Rect& rect = u.indexed_rect_;
+	if (SDL_RectEmpty(&rect)) {
+		return;
+	}
+	const int xmin = std::max(0, rect.x) >> click_cell_shift;
+	const int ymin = std::max(0, rect.y) >> click_cell_shift;
+	const int xmax = std::min(click_cols_ - 1, std::max(0, rect.x + rect.w - 1) >> click_cell_shift);
+	const int ymax = std::min(click_rows_ - 1, std::max(0, rect.y + rect.h - 1) >> click_cell_shift);
+
+	for (int y = ymin; y <= ymax; y ++) {
+		for (int x = xmin; x <= xmax; x ++) {
+			std::vector<base_unit*>& cell = click_cells_[y * click_cols_ + x];
+			// order in cell isn't matter.
+			std::vector<base_unit*>::iterator it = std::find(cell.begin(), cell.end(), &u);
+			if (it != cell.end()) {
+				*it = cell.back();
+				cell.pop_back();
+			}
+		}
+	}
+	u.indexed_rect_ = empty_rect;
+}
+
+void base_map::zero_units()
+{
+	for (int i = 0; i < map_vsize_; i ++) {
+		map_[i]->indexed_rect_ = empty_rect;
+	}
+	if (map_) {
+		memset(map_, 0, map_size_ * sizeof(base_unit*));
+		map_vsize_ = 0;
+	}
+	if (coor_map_) {
+		memset(coor_map_, 0, w_ * h_ * sizeof(loc_cookie));
+	}
+	for (std::vector<std::vector<base_unit*> >::iterator it = click_cells_.begin(); it != click_cells_.end(); ++ it) {
+		it->clear();
+	}
+	ext_free_.assign(h_, 0);
+}
+
+void base_map::release_ext_locs(const base_unit& u)
+{
+	const int w = gmap_.w();
+	const std::set<map_location>& touch_locs = u.get_touch_locations();
+	for (std::set<map_location>::const_iterator itor = touch_locs.begin(); itor != touch_locs.end(); ++ itor) {
+		if (itor->x >= w && itor->x < ext_free_[itor->y]) {
+			ext_free_[itor->y] = itor->x;
+		}
+	}
 }
 
 void base_map::insert(const map_location loc, base_unit* u)
@@ -189,6 +281,7 @@ void base_map::insert(const map_location loc, base_unit* u)
 	if (u->require_sort()) {
 		sort_map(*u);
 	}
+	click_index_insert(*u);
 }
 
 void base_map::expand_coor_map(int w)
@@ -224,19 +317,20 @@ map_location base_map::conflict_calculate_loc(const base_unit& u)
 	map_location loc = disp.map_2_loc(rect.x, rect.y);
 	int pitch = w_ * loc.y;
 	if (coor_map_[pitch + loc.x].overlay) {
-		int w = gmap_.w();
-		for (int x = w; x < w_; x ++) {
+		const int w = gmap_.w();
+		int x = std::max(w, ext_free_[loc.y]);
+		for (; x < w_; x ++) {
 			if (!coor_map_[pitch + x].overlay) {
-				loc.x = x;
 				break;
 			}
 		}
-		if (loc.x < w) {
-			// requrie extend.
+		if (x == w_) {
+			// requrie extend. double extended columns, so copy cost is amortized.
 			const int expand_factor = 2;
-			expand_coor_map(w_ + expand_factor);
-			loc.x = w_ - expand_factor;
+			expand_coor_map(w_ + std::max(expand_factor, w_ - w));
 		}
+		ext_free_[loc.y] = x;
+		loc.x = x;
 	}
 	return loc;
 }
@@ -249,53 +343,32 @@ void base_map::insert2(const display& disp, base_unit* u)
 	insert(loc, u);
 }
 
-base_unit* base_map::unit_clicked_on(const int xclick, const int yclick, const map_location& mloc) const
+base_unit* base_map::unit_clicked_on(const int xclick, const int yclick) const
 {
-	const int w = gmap_.w();
 	const display& disp = get_controller().get_display();
 	int xmap = xclick, ymap = yclick;
 	disp.screen_2_map(xmap, ymap);
+	if (xmap < 0 || ymap < 0) {
+		return NULL;
+	}
+	const int x = xmap >> click_cell_shift;
+	const int y = ymap >> click_cell_shift;
+	if (x >= click_cols_ || y >= click_rows_) {
+		return NULL;
+	}
 
-	base_unit* u;
-	for (int y = mloc.y; y >= 0; y --) {
-		int pitch = y * w_;
-		int max_x = 0;
-		int min_y = INT_MAX;
-		for (int x = mloc.x; x >= 0; x --) {
-			u = coor_map_[pitch + x].overlay;
-			if (u && !u->hidden_) {
-				const SDL_Rect& rect = u->get_rect();
-				if (point_in_rect(xmap, ymap, rect)) {
-					return u;
-				}
-				if (max_x < rect.x + rect.w) {
-					max_x = rect.x + rect.w;
-				}
-				if (min_y > rect.y) {
-					min_y = rect.y;
-				}
-			}
-			if (min_y <= ymap) {
-				break;
-			}
-		}
-		for (int x1 = w; x1 < w_; x1 ++) {
-			u = coor_map_[pitch + x1].overlay;
-			if (u && !u->hidden_) {
-				const SDL_Rect& rect = u->get_rect();
-				if (point_in_rect(xmap, ymap, rect)) {
-					return u;
-				}
-				if (max_x < rect.x + rect.w) {
-					max_x = rect.x + rect.w;
-				}
+	// units are drawn in map_ order, the last one is topmost.
+	base_unit* result = NULL;
+	const std::vector<base_unit*>& cell = click_cells_[y * click_cols_ + x];
+	for (std::vector<base_unit*>::const_iterator it = cell.begin(); it != cell.end(); ++ it) {
+		base_unit* u = *it;
+		if (!u->hidden_ && point_in_rect(xmap, ymap, u->rect_)) {
+			if (!result || u->map_index_ > result->map_index_) {
+				result = u;
 			}
 		}
-		if (y != mloc.y && max_x >= xmap) {
-			break;
-		}
 	}
-	return NULL;
+	return result;
 }
 
 bool base_map::valid2(const map_location& loc, bool overlay) const
@@ -338,6 +411,11 @@ void base_map::clear()
 	}
 	map_size_ = 0;
 	map_vsize_ = 0;
+
+	click_cells_.clear();
+	click_cols_ = 0;
+	click_rows_ = 0;
+	ext_free_.clear();
 }
 
 // extract/place pair only use in overlay layer.
@@ -356,6 +434,8 @@ base_unit* base_map::extract(const map_location &loc)
 	for (std::set<map_location>::const_iterator itor = touch_locs.begin(); itor != touch_locs.end(); ++ itor) {
 		coor_map_[index(itor->x, itor->y)].overlay = NULL;
 	}
+	release_ext_locs(*u);
+	click_index_erase(*u);
 
 	if (!place_unsort_) {
 		VALIDATE(u->get_map_index() != UNIT_NO_INDEX, null_str);
@@ -373,13 +453,16 @@ void base_map::place(const map_location loc, base_unit* u)
 	for (std::set<map_location>::const_iterator itor = touch_locs.begin(); itor != touch_locs.end(); ++ itor) {
 		coor_map_[index(itor->x, itor->y)].overlay = u;
 	}
+	click_index_insert(*u);
 
 	if (!place_unsort_) {
 		VALIDATE(u->get_map_index() != UNIT_NO_INDEX, null_str);
 		if (u->require_sort()) {
 			sort_map(*u);
 		}
+#ifdef _DEBUG
 		verify_map_index();
+#endif
 	}
 }
 
@@ -408,8 +491,8 @@ bool base_map::erase2(base_unit* u, bool delete_unit)
 	VALIDATE(u->map_index_ != UNIT_NO_INDEX, "unit must be in map_!");
 
 	map_vsize_ --;
+	memmove(map_ + u->map_index_, map_ + u->map_index_ + 1, (map_vsize_ - u->map_index_) * sizeof(base_unit*));
 	for (int i = u->map_index_; i < map_vsize_; i ++) {
-		map_[i] = map_[i + 1];
 		map_[i]->map_index_ = i;
 	}
 	map_[map_vsize_] = nullptr;
@@ -426,6 +509,10 @@ bool base_map::erase2(base_unit* u, bool delete_unit)
 		}
 		invalid_locs.insert(loc);
 	}
+	if (!base) {
+		release_ext_locs(*u);
+		click_index_erase(*u);
+	}
 
 	display* disp = display::get_singleton();
 	if (disp) {
@@ -437,8 +524,9 @@ bool base_map::erase2(base_unit* u, bool delete_unit)
 	} else {
 		u->map_index_ = UNIT_NO_INDEX;
 	}
-
+#ifdef _DEBUG
 	verify_map_index();
+#endif
 
 	return true;
 }
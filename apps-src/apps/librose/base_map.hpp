@@ -22,6 +22,7 @@
 #include "terrain_translation.hpp"
 
 #include <cassert>
+#include <vector>
 
 class tmap;
 class display;
@@ -221,7 +222,7 @@ public:
 	virtual void sort_map(base_unit& u);
 
 	virtual void insert2(const display& disp, base_unit* u);
-	base_unit* unit_clicked_on(const int xclick, const int yclick, const map_location& mloc) const;
+	base_unit* unit_clicked_on(const int xclick, const int yclick) const;
 	map_location conflict_calculate_loc(const base_unit& u);
 
 	/**
@@ -258,8 +259,15 @@ public:
 	base_unit* find_base_unit(const map_location& loc, bool overlay) const;
 	base_unit* find_base_unit(int i) { return map_[i]; }
 
+protected:
+	void click_index_insert(base_unit& u);
+	void click_index_erase(base_unit& u);
+	// forget every unit, but don't delete them. map keeps its size.
+	void zero_units();
+
 private:
 	void expand_coor_map(int w);
+	void release_ext_locs(const base_unit& u);
 
 protected:
 	const tmap& gmap_;
@@ -283,6 +291,15 @@ protected:
 
 private:
 	base_controller& controller_;
+
+	// overlay units bucketed by rect, for unit_clicked_on. cell is (1 << click_cell_shift) pixels.
+	enum {click_cell_shift = 6};
+	std::vector<std::vector<base_unit*> > click_cells_;
+	int click_cols_;
+	int click_rows_;
+
+	// every extended column before ext_free_[y] is occupied on row y.
+	std::vector<int> ext_free_;
 };
 
 // define allowed conversions.
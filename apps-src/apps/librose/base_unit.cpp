@@ -29,6 +29,7 @@ base_unit::base_unit(base_map& units)
 	, refreshing_(false)
 	, redraw_counter_(0)
 	, rect_(empty_rect)
+	, indexed_rect_(empty_rect)
 	, hidden_(false)
 	, anim_(NULL)
 	, next_idling_(0)
@@ -50,6 +51,7 @@ base_unit::base_unit(const base_unit& that)
 	, refreshing_(that.refreshing_)
 	, redraw_counter_(that.redraw_counter_)
 	, rect_(that.rect_)
+	, indexed_rect_(empty_rect)
 	, hidden_(that.hidden_)
 	, anim_(NULL) // important!!
 	, next_idling_(that.next_idling_)
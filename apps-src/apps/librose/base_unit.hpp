@@ -111,6 +111,8 @@ protected:
 	size_t redraw_counter_;
 
 	SDL_Rect rect_;
+	// rect that base_map's click index holds this unit under.
+	SDL_Rect indexed_rect_;
 	bool hidden_;
 
 	// Animations:
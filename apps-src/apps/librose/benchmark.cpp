@@ -0,0 +1,836 @@
+/*
+   Copyright (C) 2003 - 2010 by David White <dave@whitevine.net>
+   Part of the Battle for Wesnoth Project http://www.wesnoth.org/
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY.
+
+   See the COPYING file for more details.
+*/
+
+#include "global.hpp"
+
+#include "benchmark.hpp"
+#include "base_instance.hpp"
+#include "builder.hpp"
+#include "config.hpp"
+#include "filesystem.hpp"
+#include "integrate.hpp"
+#include "loadscreen.hpp"
+#include "rose_config.hpp"
+#include "gui/auxiliary/window_builder.hpp"
+#include "gui/dialogs/chat.hpp"
+#include "gui/widgets/label.hpp"
+#include "gui/widgets/window.hpp"
+#include "sdl_utils.hpp"
+#include "terrain_translation.hpp"
+#include "unit_frame.hpp"
+#include "serialization/parser.hpp"
+#include "serialization/preprocessor.hpp"
+#include "serialization/string_utils.hpp"
+#include "wml_exception.hpp"
+
+#include <iterator>
+#include <new>
+#include <set>
+#include <sstream>
+#include <string.h>
+
+#include <boost/foreach.hpp>
+#include <cmath>
+#include <ctime>
+
+#include "libyuv/convert_argb.h"
+#include "webrtc/api/video/i420_buffer.h"
+
+extern terrain_builder::building_rule* wml_building_rules_from_file(const std::string& fname, uint32_t* rules_size_ptr);
+
+namespace benchmark {
+
+// operator new calls while a tallocation_counter is alive.
+static SDL_atomic_t new_calls;
+static bool count_allocations = false;
+
+class tallocation_counter
+{
+public:
+	tallocation_counter()
+		: start_(SDL_AtomicGet(&new_calls))
+	{
+		count_allocations = true;
+	}
+
+	~tallocation_counter()
+	{
+		count_allocations = false;
+	}
+
+	int allocations() const { return SDL_AtomicGet(&new_calls) - start_; }
+
+private:
+	int start_;
+};
+
+}
+
+// replaced so that allocation benchmarks count heap allocations instead of estimating them.
+void* operator new(size_t size)
+{
+	if (benchmark::count_allocations) {
+		SDL_AtomicIncRef(&benchmark::new_calls);
+	}
+	void* ptr = malloc(size? size: 1);
+	if (!ptr) {
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* ptr) throw()
+{
+	free(ptr);
+}
+
+void operator delete[](void* ptr) throw()
+{
+	free(ptr);
+}
+
+namespace benchmark {
+
+// recursive copy that shares nothing, what copying a config did before subtrees were shared.
+static void deep_copy(const config& from, config& to)
+{
+	to.merge_attributes(from);
+	BOOST_FOREACH(const config::any_child& value, from.all_children_range()) {
+		deep_copy(value.cfg, to.add_child(value.key));
+	}
+}
+
+// approximate heap usage of config trees. a subtree shared by several trees is counted once.
+class tconfig_usage
+{
+public:
+	tconfig_usage()
+		: nodes(0)
+		, attributes(0)
+		, bytes(0)
+		, seen_()
+	{}
+
+	void add(const config& cfg)
+	{
+		if (!seen_.insert(&cfg).second) {
+			return;
+		}
+		nodes ++;
+		bytes += sizeof(config);
+		BOOST_FOREACH(const config::attribute& attr, cfg.attribute_range()) {
+			attributes ++;
+			bytes += sizeof(config::attribute) + attr.first.size() + attr.second.str().size();
+		}
+		BOOST_FOREACH(const config::any_child& value, cfg.all_children_range()) {
+			// child_list entry and ordered_children entry.
+			bytes += sizeof(config*) + sizeof(config::child_pos);
+			add(value.cfg);
+		}
+	}
+
+	size_t nodes;
+	size_t attributes;
+	size_t bytes;
+
+private:
+	std::set<const config*> seen_;
+};
+
+/**
+ * Replays the copies load_game_cfg makes after reading data.bin (terrain_type
+ * extraction, core_cfg_ = game_config_, the multiplayer hashes) and reports the
+ * memory held by game_config_, core_cfg_ and terrain_types afterwards.
+ */
+static void replay_startup(const std::string& data, bool share)
+{
+	config game, core, terrains;
+	wml_config_from_file(data, game);
+
+	ttimer timer;
+	const config& const_game = game;
+	BOOST_FOREACH(const config& t, const_game.child_range("terrain_type")) {
+		if (share) {
+			terrains.add_child("terrain_type", t);
+		} else {
+			deep_copy(t, terrains.add_child("terrain_type"));
+		}
+	}
+	game.clear_children("terrain_type");
+
+	if (share) {
+		core = game;
+	} else {
+		deep_copy(game, core);
+	}
+	game.clear_children("lua");
+
+	config& hashes = game.add_child("multiplayer_hashes");
+	BOOST_FOREACH(const config& ch, game.child_range("multiplayer")) {
+		hashes[ch["id"]] = ch.hash();
+	}
+	const double ms = timer.elapsed();
+
+	tconfig_usage usage;
+	usage.add(game);
+	usage.add(core);
+	usage.add(terrains);
+	posix_print("  %s: %u nodes, %u attributes, %u KB, copies took %.2f ms\n", share? "shared": "deep  ",
+		(unsigned)usage.nodes, (unsigned)usage.attributes, (unsigned)(usage.bytes / 1024), ms);
+}
+
+static void config_cow()
+{
+	const std::string data = game_config::path + "/xwml/data.bin";
+	if (!file_exists(data)) {
+		posix_print("  %s not found, skipped\n", data.c_str());
+		return;
+	}
+	replay_startup(data, false);
+	replay_startup(data, true);
+}
+
+typedef void (*tparse)(config& cfg, const std::string& source);
+
+static void parse_wml(config& cfg, const std::string& text)
+{
+	read(cfg, text);
+}
+
+static void parse_bin(config& cfg, const std::string& file)
+{
+	wml_config_from_file(file, cfg);
+}
+
+static void compare_arena(const std::string& name, tparse parse, const std::string& source, int times)
+{
+	int heap_allocations = 0;
+	ttimer timer;
+	for (int n = 0; n < times; n ++) {
+		tallocation_counter counter;
+		{
+			config cfg;
+			parse(cfg, source);
+		}
+		heap_allocations = counter.allocations();
+	}
+	const double heap_ms = timer.elapsed();
+
+	int arena_allocations = 0;
+	size_t blocks = 0;
+	timer.reset();
+	for (int n = 0; n < times; n ++) {
+		tallocation_counter counter;
+		{
+			tconfig_arena arena;
+			{
+				config cfg(arena);
+				parse(cfg, source);
+			}
+			blocks = arena.blocks();
+		}
+		arena_allocations = counter.allocations();
+	}
+	const double arena_ms = timer.elapsed();
+
+	posix_print("  %s, %i times\n", name.c_str(), times);
+	posix_print("    heap:  %i allocations, %.2f ms\n", heap_allocations, heap_ms);
+	// arena blocks come from malloc, so operator new did not see them.
+	posix_print("    arena: %i allocations (%i of them arena blocks), %.2f ms\n",
+		arena_allocations + (int)blocks, (int)blocks, arena_ms);
+}
+
+static std::string preprocessed(const std::string& file)
+{
+	scoped_istream stream = preprocess_file(get_wml_location(file));
+	return std::string(std::istreambuf_iterator<char>(*stream), std::istreambuf_iterator<char>());
+}
+
+// transient trees that are built in a tconfig_arena.
+static void config_arena()
+{
+	compare_arena("hardwired/fonts.cfg", parse_wml, preprocessed("hardwired/fonts.cfg"), 100);
+	compare_arena("hardwired/english.cfg", parse_wml, preprocessed("hardwired/english.cfg"), 100);
+	compare_arena("xwml/language.bin", parse_bin, game_config::path + "/xwml/language.bin", 10);
+}
+
+// what tintegrate did before parse_markup: split with to_cfgs, then parse every tag as WML.
+static int markup_by_wml(const std::string& src)
+{
+	std::map<int, std::string> items;
+	try {
+		items = utils::to_cfgs(src);
+	} catch (twml_exception&) {
+		return 0;
+	}
+	int tags = 0;
+	for (std::map<int, std::string>::const_iterator it = items.begin(); it != items.end(); ++ it) {
+		if (utils::is_single_cfg(it->second)) {
+			config cfg;
+			read(cfg, it->second);
+			tags ++;
+		}
+	}
+	return tags;
+}
+
+static int markup_in_one_pass(const std::string& src)
+{
+	std::vector<tintegrate::tmarkup> markups;
+	if (!tintegrate::parse_markup(src, markups)) {
+		return 0;
+	}
+	int tags = 0;
+	for (std::vector<tintegrate::tmarkup>::const_iterator it = markups.begin(); it != markups.end(); ++ it) {
+		tags += it->name.empty()? 0: 1;
+	}
+	return tags;
+}
+
+static void compare_markup(const std::string& name, const std::vector<std::string>& sources, int times)
+{
+	size_t bytes = 0;
+	for (std::vector<std::string>::const_iterator it = sources.begin(); it != sources.end(); ++ it) {
+		bytes += it->size();
+	}
+
+	int old_tags = 0, new_tags = 0;
+	ttimer timer;
+	for (int n = 0; n < times; n ++) {
+		for (std::vector<std::string>::const_iterator it = sources.begin(); it != sources.end(); ++ it) {
+			old_tags += markup_by_wml(*it);
+		}
+	}
+	const double old_ms = timer.elapsed();
+
+	timer.reset();
+	for (int n = 0; n < times; n ++) {
+		for (std::vector<std::string>::const_iterator it = sources.begin(); it != sources.end(); ++ it) {
+			new_tags += markup_in_one_pass(*it);
+		}
+	}
+	const double new_ms = timer.elapsed();
+
+	posix_print("  %s: %u strings, %u KB, %i times\n", name.c_str(), (unsigned)sources.size(), (unsigned)(bytes / 1024), times);
+	posix_print("    to_cfgs + WML parser: %.2f ms, %i tags\n", old_ms, old_tags);
+	posix_print("    parse_markup:         %.2f ms, %i tags\n", new_ms, new_tags);
+}
+
+static void integrate_markup()
+{
+	// chat lines as the lobby formats them: mostly plain text, some nick colors and images.
+	std::vector<std::string> chat;
+	for (int n = 0; n < 2000; n ++) {
+		std::stringstream line;
+		line << tintegrate::generate_format("player" + str_cast(n % 37), "green") << ": ";
+		if (n % 3 == 0) {
+			line << "see " << tintegrate::generate_img("misc/ok.png") << " and " << tintegrate::generate_format(n, "red", 0, true);
+		} else {
+			line << "message number " << n << " with some ordinary text in it, and an escaped \\<tag\\>";
+		}
+		chat.push_back(line.str());
+	}
+	compare_markup("chat log", chat, 10);
+
+	std::vector<std::string> topics;
+	BOOST_FOREACH(const config& book, instance->game_config().child_range("book")) {
+		BOOST_FOREACH(const config& topic, book.child_range("topic")) {
+			topics.push_back(topic["text"].str());
+		}
+	}
+	if (topics.empty()) {
+		posix_print("  no help topics in game config, skipped\n");
+		return;
+	}
+	compare_markup("help topics", topics, 10);
+}
+
+// a fake capturer thread delivers 720p frames, the way a phone camera does (rotated 90 degrees),
+// and main thread shows them, either by the former ARGB path or by tframe_handoff and an IYUV texture.
+class tvideo_loopback
+{
+public:
+	static const int width = 1280;
+	static const int height = 720;
+	static const int frames = 120;
+	static const int interval_ms = 33;
+
+	explicit tvideo_loopback(bool argb)
+		: argb_(argb)
+		, handoff_()
+		, mutex_()
+		, pixels_(NULL)
+		, fresh_(false)
+		, done_(false)
+		, capture_ms_(0)
+	{}
+
+	void run();
+
+private:
+	static int capture(void* param);
+	void capture_frames();
+
+private:
+	const bool argb_;
+	gui2::tframe_handoff handoff_;
+
+	// former path: capturer writes ARGB into the locked texture under mutex_.
+	threading::mutex mutex_;
+	uint8_t* pixels_;
+	bool fresh_;
+
+	volatile bool done_;
+	double capture_ms_;
+};
+
+int tvideo_loopback::capture(void* param)
+{
+	static_cast<tvideo_loopback*>(param)->capture_frames();
+	return 0;
+}
+
+void tvideo_loopback::capture_frames()
+{
+	for (int n = 0; n < frames; n ++) {
+		// camera's work, not measured.
+		rtc::scoped_refptr<webrtc::I420Buffer> frame = webrtc::I420Buffer::Create(width, height);
+		for (int y = 0; y < height; y ++) {
+			memset(frame->MutableDataY() + y * frame->StrideY(), (y + n * 4) & 0xff, width);
+		}
+		memset(frame->MutableDataU(), 128, frame->StrideU() * height / 2);
+		memset(frame->MutableDataV(), 128, frame->StrideV() * height / 2);
+
+		ttimer timer;
+		if (argb_) {
+			// what OnFrame did: rotate and convert on this thread, holding the lock.
+			rtc::scoped_refptr<webrtc::I420Buffer> rotated = webrtc::I420Buffer::Rotate(*frame, webrtc::kVideoRotation_90);
+			threading::lock lock(mutex_);
+			if (pixels_) {
+				libyuv::I420ToARGB(rotated->DataY(), rotated->StrideY(), rotated->DataU(), rotated->StrideU(),
+					rotated->DataV(), rotated->StrideV(), pixels_, rotated->width() * 4, rotated->width(), rotated->height());
+				fresh_ = true;
+			}
+		} else {
+			handoff_.put(frame, webrtc::kVideoRotation_90);
+		}
+		capture_ms_ += timer.elapsed();
+
+		SDL_Delay(interval_ms);
+	}
+	done_ = true;
+}
+
+void tvideo_loopback::run()
+{
+	SDL_Renderer* renderer = get_renderer();
+	SDL_Texture* tex;
+	if (argb_) {
+		tex = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, height, width);
+		int pitch = 0;
+		SDL_LockTexture(tex, NULL, (void**)&pixels_, &pitch);
+	} else {
+		tex = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_IYUV, SDL_TEXTUREACCESS_STREAMING, width, height);
+	}
+	// portrait area, as the remote video of a phone.
+	const SDL_Rect dst = ::create_rect(0, 0, height / 2, width / 2);
+
+	const clock_t start = clock();
+	SDL_Thread* thread = SDL_CreateThread(capture, "capturer", this);
+	double ui_ms = 0;
+	int shown = 0;
+	while (!done_) {
+		ttimer timer;
+		if (argb_) {
+			threading::lock lock(mutex_);
+			if (fresh_) {
+				SDL_UnlockTexture(tex);
+				SDL_RenderCopy(renderer, tex, NULL, &dst);
+				int pitch = 0;
+				SDL_LockTexture(tex, NULL, (void**)&pixels_, &pitch);
+				fresh_ = false;
+				shown ++;
+			}
+		} else {
+			webrtc::VideoRotation rotation;
+			rtc::scoped_refptr<webrtc::VideoFrameBuffer> buffer = handoff_.take(rotation);
+			if (buffer) {
+				SDL_UpdateYUVTexture(tex, NULL, buffer->DataY(), buffer->StrideY(),
+					buffer->DataU(), buffer->StrideU(), buffer->DataV(), buffer->StrideV());
+				SDL_Rect rect = ::create_rect(dst.x + (dst.w - dst.h) / 2, dst.y + (dst.h - dst.w) / 2, dst.h, dst.w);
+				SDL_RenderCopyEx(renderer, tex, NULL, &rect, rotation, NULL, SDL_FLIP_NONE);
+				shown ++;
+			}
+		}
+		ui_ms += timer.elapsed();
+		SDL_Delay(5);
+	}
+	SDL_WaitThread(thread, NULL);
+	const double cpu_ms = (clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+
+	if (argb_) {
+		SDL_UnlockTexture(tex);
+		pixels_ = NULL;
+	}
+	SDL_DestroyTexture(tex);
+
+	posix_print("  %s: capturer thread %.2f ms/frame, UI thread %.2f ms/frame (%i of %i shown), process CPU %.2f ms/frame\n",
+		argb_? "ARGB (former)": "I420 handoff ", capture_ms_ / frames, shown? ui_ms / shown: 0.0, shown, frames, cpu_ms / frames);
+}
+
+static void chat_video()
+{
+	posix_print("  %ix%i, %i frames every %i ms, process CPU includes the fake capturer filling frames\n",
+		tvideo_loopback::width, tvideo_loopback::height, tvideo_loopback::frames, tvideo_loopback::interval_ms);
+	{
+		tvideo_loopback loopback(true);
+		loopback.run();
+	}
+	{
+		tvideo_loopback loopback(false);
+		loopback.run();
+	}
+}
+
+// what twindow::draw does before rendering: relayout dirty subtrees, or a full layout.
+class twindow_layout
+{
+public:
+	static void layout(gui2::twindow& window)
+	{
+		if (!window.need_layout_ && !window.relayout_widgets_.empty()) {
+			window.relayout();
+		}
+		if (window.need_layout_) {
+			window.layout();
+		} else {
+			window.layout_children();
+		}
+	}
+};
+
+static void window_relayout()
+{
+	const int updates = 500;
+	const int total = 64 * 1024 * 1024;
+
+	// network_transmission updates its progress label every percent.
+	gui2::twindow* window = gui2::build(instance->video(), "network_transmission", 0, 0);
+	twindow_layout::layout(*window);
+	gui2::tlabel& label = gui2::find_widget<gui2::tlabel>(window, "_numeric_progress", false);
+
+	for (int local = 0; local < 2; local ++) {
+		ttimer timer;
+		for (int n = 0; n < updates; n ++) {
+			const int received = (int64_t)total * n / updates;
+			label.set_label(utils::si_string(received, true, "B") + "/" + utils::si_string(total, true, "B"));
+			if (local) {
+				window->invalidate_layout(label);
+			} else {
+				window->invalidate_layout();
+			}
+			twindow_layout::layout(*window);
+		}
+		posix_print("  %s: %.3f ms/update\n", local? "invalidate_layout(label)": "invalidate_layout()   ", timer.elapsed() / updates);
+	}
+	delete window;
+}
+
+// the former file_replace_string: one whole-file pass of tfile::replace_string per key.
+static void replace_by_passes(const std::string& src_file, const std::vector<std::pair<std::string, std::string> >& replaces)
+{
+	tfile file(src_file,  GENERIC_WRITE, OPEN_EXISTING);
+	int fsize = file.read_2_data();
+	if (!fsize) {
+		return;
+	}
+
+	bool dirty = false;
+	fsize = file.replace_string(fsize, replaces, &dirty);
+
+	if (dirty) {
+		posix_fseek(file.fp, 0);
+		posix_fwrite(file.fp, file.data, fsize);
+		file.truncate(fsize);
+	}
+}
+
+static void file_replace()
+{
+	// what studio does when it renames an app: a handful of identifiers in a source file.
+	std::vector<std::pair<std::string, std::string> > replaces;
+	replaces.push_back(std::make_pair("studio", "kingdom"));
+	replaces.push_back(std::make_pair("STUDIO", "KINGDOM"));
+	replaces.push_back(std::make_pair("com.leagor.", "com.kingdom."));
+	replaces.push_back(std::make_pair("rose_app", "kingdom_app"));
+
+	std::stringstream strstr;
+	for (int n = 0; strstr.tellp() < 8 * 1024 * 1024; n ++) {
+		strstr << "\tint var" << n << " = get_value(\"key" << n % 97 << "\"); // plain line without key\n";
+		if (n % 50 == 0) {
+			strstr << "#include \"studio/library" << n << ".hpp\" // STUDIO com.leagor.rose_app\n";
+		}
+	}
+	const std::string source = strstr.str();
+	const std::string file = game_config::preferences_dir + "/benchmark_replace.txt";
+
+	std::string results[2];
+	for (int passes = 0; passes < 2; passes ++) {
+		double ms = 0;
+		const int times = 5;
+		for (int n = 0; n < times; n ++) {
+			write_file(file, source.c_str(), source.size());
+			ttimer timer;
+			if (passes) {
+				replace_by_passes(file, replaces);
+			} else {
+				file_replace_string(file, replaces);
+			}
+			ms += timer.elapsed();
+		}
+		tfile result(file, GENERIC_READ, OPEN_EXISTING);
+		const int fsize = result.read_2_data();
+		results[passes].assign(result.data, fsize);
+		posix_print("  %s: %.2f ms for %i KB, %i keys\n", passes? "tfile::replace_string, a pass per key": "tmulti_replacer, one streaming pass ",
+			ms / times, (int)source.size() / 1024, (int)replaces.size());
+	}
+	SDL_DeleteFiles(file.c_str());
+	VALIDATE(results[0] == results[1], "file_replace_string differs from tfile::replace_string!");
+}
+
+static void map_load()
+{
+	// about the largest map read_game_map accepts, terrain changes every few hexes as a hand-made map does.
+	const int size = t_translation::max_map_size();
+	const t_translation::t_terrain terrains[] = {t_translation::GRASS_LAND, t_translation::FOREST, t_translation::HILL,
+		t_translation::MOUNTAIN, t_translation::SHALLOW_WATER, t_translation::DEEP_WATER, t_translation::CAVE, t_translation::HUMAN_CASTLE};
+	const int terrain_count = sizeof(terrains) / sizeof(terrains[0]);
+
+	t_translation::t_grid grid(size, size);
+	for (int y = 0; y < size; y ++) {
+		for (int x = 0; x < size; x ++) {
+			grid(x, y) = terrains[((x / 6) * 7 + (y / 4) * 13 + (x * y) % 5 / 4) % terrain_count];
+		}
+	}
+	std::map<int, t_translation::coordinate> positions;
+	for (int side = 1; side <= 9; side ++) {
+		positions[side] = t_translation::coordinate(side * 100, side * 100);
+	}
+
+	const std::string text = t_translation::write_game_map(grid, positions);
+
+	const int times = 5;
+	t_translation::t_grid result;
+	ttimer timer;
+	for (int n = 0; n < times; n ++) {
+		std::map<int, t_translation::coordinate> starting_positions;
+		result = t_translation::read_game_map(text.c_str(), text.size(), starting_positions);
+	}
+	posix_print("  read_game_map: %.2f ms for %ix%i, %i KB\n", timer.elapsed() / times, size, size, (int)text.size() / 1024);
+	VALIDATE(result.tiles() == grid.tiles(), "read_game_map differs from written map!");
+}
+
+// former progressive_string/progressive_double: walk (value, duration) from the start every lookup.
+class tlinear_progressive
+{
+public:
+	void push_string(const std::string& value, int duration) { strings_.push_back(std::make_pair(value, duration)); }
+	void push_number(double from, double to, int duration) { numbers_.push_back(std::make_pair(std::make_pair(from, to), duration)); }
+
+	const std::string& string_at(int current_time) const
+	{
+		int time = 0;
+		unsigned int sub_halo = 0;
+		while (time < current_time && sub_halo < strings_.size()) {
+			time += strings_[sub_halo].second;
+			++ sub_halo;
+		}
+		if (sub_halo) sub_halo --;
+		return strings_[sub_halo].first;
+	}
+
+	double number_at(int current_time) const
+	{
+		int duration = 0;
+		for (std::vector<std::pair<std::pair<double, double>, int> >::const_iterator it = numbers_.begin(); it != numbers_.end(); ++ it) {
+			duration += it->second;
+		}
+		int searched_time = current_time;
+		if (searched_time < 0) searched_time = 0;
+		if (searched_time > duration) searched_time = duration;
+
+		int time = 0;
+		unsigned int sub_halo = 0;
+		while (time < searched_time && sub_halo < numbers_.size()) {
+			time += numbers_[sub_halo].second;
+			++ sub_halo;
+		}
+		if (sub_halo != 0) {
+			sub_halo --;
+			time -= numbers_[sub_halo].second;
+		}
+		const double first = numbers_[sub_halo].first.first;
+		const double second = numbers_[sub_halo].first.second;
+		return (static_cast<double>(searched_time - time) / static_cast<double>(numbers_[sub_halo].second)) * (second - first) + first;
+	}
+
+private:
+	std::vector<std::pair<std::string, int> > strings_;
+	std::vector<std::pair<std::pair<double, double>, int> > numbers_;
+};
+
+static void unit_frames()
+{
+	// every unit plays a halo of 12 images and 6 numeric parameters (offset, alpha, blend...) of 8 segments.
+	const int units = 400;
+	const int numbers = 6;
+	const int frames = 600;
+	const int frame_ms = 16;
+
+	std::stringstream halo;
+	tlinear_progressive linear_halo;
+	for (int n = 0; n < 12; n ++) {
+		halo << (n? ",": "") << "halo/misc/halo" << n << ".png:" << 40 + n * 5;
+		linear_halo.push_string("halo/misc/halo" + str_cast(n) + ".png", 40 + n * 5);
+	}
+	std::vector<std::string> number_data;
+	std::vector<tlinear_progressive> linear_numbers(numbers);
+	for (int param = 0; param < numbers; param ++) {
+		std::stringstream strstr;
+		for (int n = 0; n < 8; n ++) {
+			const double from = (n % 2)? 1.0: 0.0;
+			const int duration = 50 + param * 10 + n * 5;
+			strstr << (n? ",": "") << from << "~" << 1.0 - from << ":" << duration;
+			linear_numbers[param].push_number(from, 1.0 - from, duration);
+		}
+		number_data.push_back(strstr.str());
+	}
+
+	// every unit has its own parameters, as frame_parsed_parameters does.
+	std::vector<progressive_string> halos(units, progressive_string(halo.str()));
+	std::vector<progressive_double> params;
+	for (int unit = 0; unit < units; unit ++) {
+		for (int param = 0; param < numbers; param ++) {
+			params.push_back(progressive_double(number_data[param]));
+		}
+	}
+	const int halo_duration = halos[0].duration();
+	std::vector<int> number_durations;
+	for (int param = 0; param < numbers; param ++) {
+		number_durations.push_back(params[param].duration());
+	}
+
+	double sums[2] = {0, 0};
+	for (int indexed = 0; indexed < 2; indexed ++) {
+		ttimer timer;
+		double& sum = sums[indexed];
+		for (int frame = 0; frame < frames; frame ++) {
+			for (int unit = 0; unit < units; unit ++) {
+				// units are in different phases of their looping animations.
+				const int time = frame * frame_ms + unit * 37;
+				if (indexed) {
+					sum += halos[unit].get_current_element(time % halo_duration).size();
+					for (int param = 0; param < numbers; param ++) {
+						sum += params[unit * numbers + param].get_current_element(time % number_durations[param]);
+					}
+				} else {
+					sum += linear_halo.string_at(time % halo_duration).size();
+					for (int param = 0; param < numbers; param ++) {
+						sum += linear_numbers[param].number_at(time % number_durations[param]);
+					}
+				}
+			}
+		}
+		posix_print("  %s: %.3f ms/frame for %i units\n", indexed? "progressive_timeline": "linear walk         ", timer.elapsed() / frames, units);
+	}
+	VALIDATE(fabs(sums[0] - sums[1]) < 1e-6 * fabs(sums[0]) + 1e-6, "progressive_timeline differs from linear walk!");
+}
+
+static void tb_dat_load()
+{
+	const std::string dir = game_config::path + "/xwml";
+	std::vector<std::string> files;
+	get_files_in_dir(dir, &files);
+
+	const int times = 10;
+	for (std::vector<std::string>::const_iterator it = files.begin(); it != files.end(); ++ it) {
+		const std::string& name = *it;
+		if (name.find(terrain_builder::tb_dat_prefix) || file_ext_name(name) != "dat") {
+			continue;
+		}
+		const std::string file = dir + "/" + name;
+
+		// reading the bytes is the floor of any loader.
+		ttimer timer;
+		int64_t fsize = 0;
+		for (int n = 0; n < times; n ++) {
+			tfile lock(file, GENERIC_READ, OPEN_EXISTING);
+			fsize = lock.read_2_data();
+		}
+		const double read_ms = timer.elapsed() / times;
+
+		timer.reset();
+		uint32_t rules = 0;
+		for (int n = 0; n < times; n ++) {
+			terrain_builder::building_rule* result = wml_building_rules_from_file(file, &rules);
+			VALIDATE(result, name + " require regenerate!");
+			delete [] result;
+		}
+		const double load_ms = timer.elapsed() / times;
+
+		posix_print("  %s: %u rules, %i KB, read %.2f ms, read and build rules %.2f ms\n", name.c_str(), rules, (int)(fsize / 1024), read_ms, load_ms);
+	}
+}
+
+struct tcase
+{
+	const char* name;
+	void (*fn)();
+};
+
+static const tcase cases[] = {
+	{"config_cow", config_cow},
+	{"config_arena", config_arena},
+	{"integrate_markup", integrate_markup},
+	{"chat_video", chat_video},
+	{"window_relayout", window_relayout},
+	{"file_replace", file_replace},
+	{"map_load", map_load},
+	{"unit_frames", unit_frames},
+	{"tb_dat_load", tb_dat_load},
+};
+
+int run(const std::string& filter)
+{
+	int ran = 0;
+	for (size_t n = 0; n < sizeof(cases) / sizeof(cases[0]); n ++) {
+		const tcase& c = cases[n];
+		if (!filter.empty() && strncmp(c.name, filter.c_str(), filter.size())) {
+			continue;
+		}
+		posix_print("benchmark %s\n", c.name);
+		ttimer timer;
+		c.fn();
+		posix_print("benchmark %s, %.1f ms\n", c.name, timer.elapsed());
+		ran ++;
+	}
+	return ran;
+}
+
+}
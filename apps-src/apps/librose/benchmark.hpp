@@ -0,0 +1,53 @@
+/*
+   Copyright (C) 2003 - 2010 by David White <dave@whitevine.net>
+   Part of the Battle for Wesnoth Project http://www.wesnoth.org/
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY.
+
+   See the COPYING file for more details.
+*/
+
+#ifndef LIBROSE_BENCHMARK_HPP_INCLUDED
+#define LIBROSE_BENCHMARK_HPP_INCLUDED
+
+#include "SDL_timer.h"
+#include <string>
+
+namespace benchmark {
+
+class ttimer
+{
+public:
+	ttimer()
+		: start_(SDL_GetPerformanceCounter())
+	{}
+
+	void reset() { start_ = SDL_GetPerformanceCounter(); }
+
+	// milliseconds since construction or the last reset.
+	double elapsed() const
+	{
+		return (SDL_GetPerformanceCounter() - start_) * 1000.0 / SDL_GetPerformanceFrequency();
+	}
+
+private:
+	Uint64 start_;
+};
+
+/**
+ * Runs every benchmark whose name starts with @a filter (all of them if it is empty)
+ * and prints the results. It expects an initialized instance, so that game_config
+ * and the resource paths are set. Returns the number of benchmarks run.
+ *
+ * studio runs it for "--benchmark[=filter]" on the command line.
+ */
+int run(const std::string& filter);
+
+}
+
+#endif
@@ -40,6 +40,16 @@ static lg::log_domain log_config("config");
 
 struct tconfig_implementation
 {
+	static const config& first_child(const config* cfg, const std::string& key)
+	{
+		return *cfg->children.find(key)->second.front();
+	}
+
+	static config& first_child(config* cfg, const std::string& key)
+	{
+		return *config::reference(config::detach(cfg->children.find(key)->second, 0));
+	}
+
 	/**
 	 * Implementation for the wrappers for
 	 * [const] config& child(const std::string& key, const std::string& parent);
@@ -60,7 +70,7 @@ struct tconfig_implementation
 		assert(parent[parent.size() - 1] == ']');
 
 		if(config->has_child(key)) {
-			return *(config->children.find(key)->second.front());
+			return first_child(config, key);
 		}
 
 		/**
@@ -425,6 +435,50 @@ std::ostream &operator<<(std::ostream &os, const config::attribute_value &v)
 }
 
 
+/* ** arena implementation ** */
+
+
+tconfig_arena::tconfig_arena(size_t block_size)
+	: blocks_()
+	, block_size_(block_size)
+	, cur_(NULL)
+	, left_(0)
+	, allocations_(0)
+	, bytes_(0)
+{
+}
+
+tconfig_arena::~tconfig_arena()
+{
+	for (std::vector<char*>::const_iterator it = blocks_.begin(); it != blocks_.end(); ++ it) {
+		free(*it);
+	}
+}
+
+void* tconfig_arena::allocate(size_t size, size_t align)
+{
+	size_t pad = (align - reinterpret_cast<size_t>(cur_) % align) % align;
+	if (pad + size > left_) {
+		// a request larger than a block gets a block of its own.
+		const size_t block_size = std::max(block_size_, size + align);
+		cur_ = static_cast<char*>(malloc(block_size));
+		if (!cur_) {
+			throw std::bad_alloc();
+		}
+		blocks_.push_back(cur_);
+		left_ = block_size;
+		pad = (align - reinterpret_cast<size_t>(cur_) % align) % align;
+	}
+
+	void* result = cur_ + pad;
+	cur_ += pad + size;
+	left_ -= pad + size;
+	allocations_ ++;
+	bytes_ += size;
+	return result;
+}
+
+
 /* ** config implementation ** */
 
 
@@ -443,20 +497,33 @@ void config::check_valid(const config &cfg) const
 	VALIDATE(*this && cfg, "Mandatory WML child missing yet untested for. Please report.");
 }
 
-config::config() : values(), children(), ordered_children()
+config::config() : values(), children(), ordered_children(), referenced_(false), arena_(NULL)
 {
+	SDL_AtomicSet(&refs_, 0);
 }
 
-config::config(const config& cfg) : values(cfg.values), children(), ordered_children()
+config::config(const config& cfg) : values(cfg.values), children(), ordered_children(), referenced_(false), arena_(NULL)
 {
+	SDL_AtomicSet(&refs_, 0);
 	append_children(cfg);
 }
 
-config::config(const std::string& child) : values(), children(), ordered_children()
+config::config(const std::string& child) : values(), children(), ordered_children(), referenced_(false), arena_(NULL)
 {
+	SDL_AtomicSet(&refs_, 0);
 	add_child(child);
 }
 
+config::config(tconfig_arena& arena)
+	: values(std::less<std::string>(), attribute_map::allocator_type(&arena))
+	, children(std::less<std::string>(), child_map::allocator_type(&arena))
+	, ordered_children()
+	, referenced_(false)
+	, arena_(&arena)
+{
+	SDL_AtomicSet(&refs_, 0);
+}
+
 config::~config()
 {
 	clear();
@@ -468,22 +535,49 @@ config& config::operator=(const config& cfg)
 		return *this;
 	}
 
+	// cfg may live inside this tree. Copying first is cheap since subtrees are shared.
+	config tmp(cfg);
+	if (!arena_) {
+		swap(tmp);
+	} else {
+		// keep new attributes and children in this arena.
+		assign(tmp);
+	}
+	return *this;
+}
+
+void config::assign(const config& cfg)
+{
 	clear();
-	append_children(cfg);
 	values.insert(cfg.values.begin(), cfg.values.end());
-	return *this;
+	append_children(cfg);
 }
 
 #ifdef HAVE_CXX11
 config::config(config &&cfg):
-	values(std::move(cfg.values)),
-	children(std::move(cfg.children)),
-	ordered_children(std::move(cfg.ordered_children))
-{
+	values(),
+	children(),
+	ordered_children(),
+	referenced_(false),
+	arena_(NULL)
+{
+	SDL_AtomicSet(&refs_, 0);
+	if (cfg.arena_) {
+		// arena memory cannot be stolen by a heap config.
+		values.insert(cfg.values.begin(), cfg.values.end());
+		append_children(cfg);
+	} else {
+		values.swap(cfg.values);
+		children.swap(cfg.children);
+		ordered_children.swap(cfg.ordered_children);
+	}
 }
 
 config &config::operator=(config &&cfg)
 {
+	if (cfg.arena_ && cfg.arena_ != arena_) {
+		return operator=(static_cast<const config&>(cfg));
+	}
 	clear();
 	swap(cfg);
 	return *this;
@@ -516,12 +610,82 @@ void config::remove_attribute(const std::string &key)
 	values.erase(key);
 }
 
+config* config::share(config* cfg)
+{
+	SDL_AtomicIncRef(&cfg->refs_);
+	return cfg;
+}
+
+void config::release(config* cfg)
+{
+	if (SDL_AtomicDecRef(&cfg->refs_)) {
+		destroy(cfg);
+	}
+}
+
+void config::destroy(config* cfg)
+{
+	if (cfg->arena_) {
+		// memory goes back with the arena.
+		cfg->~config();
+	} else {
+		delete cfg;
+	}
+}
+
+config* config::create_child(tconfig_arena* arena, const config* val)
+{
+	config* cfg = arena? new (arena->allocate(sizeof(config), boost::alignment_of<config>::value)) config(*arena): new config();
+	if (val) {
+		cfg->values.insert(val->values.begin(), val->values.end());
+		cfg->append_children(*val);
+	}
+	return share(cfg);
+}
+
+config* config::reference(config* cfg)
+{
+	cfg->referenced_ = true;
+	return cfg;
+}
+
+config* config::adopt(config* cfg) const
+{
+	if (!cfg->referenced_ && (!cfg->arena_ || cfg->arena_ == arena_)) {
+		return share(cfg);
+	}
+	return create_child(arena_, cfg);
+}
+
+config* config::detach(child_list& l, unsigned index)
+{
+	config* cfg = l[index];
+	if (SDL_AtomicGet(&cfg->refs_) > 1) {
+		// the clone shares cfg's children, so only this level is copied.
+		l[index] = create_child(cfg->arena_, cfg);
+		release(cfg);
+	}
+	return l[index];
+}
+
+void config::add_child_shared(const std::string& key, config* cfg)
+{
+	child_list& v = children[key];
+	v.push_back(adopt(cfg));
+	ordered_children.push_back(child_pos(children.find(key), v.size() - 1));
+}
+
 void config::append_children(const config &cfg)
 {
 	check_valid(cfg);
 
-	BOOST_FOREACH(const any_child &value, cfg.all_children_range()) {
-		add_child(value.key, value.cfg);
+	if (this == &cfg) {
+		const config tmp(cfg);
+		append_children(tmp);
+		return;
+	}
+	BOOST_FOREACH(const child_pos& pos, cfg.ordered_children) {
+		add_child_shared(pos.pos->first, pos.pos->second[pos.index]);
 	}
 }
 
@@ -579,7 +743,12 @@ config::child_itors config::child_range(const std::string& key)
 	child_map::iterator i = children.find(key);
 	static child_list dummy;
 	child_list *p = &dummy;
-	if (i != children.end()) p = &i->second;
+	if (i != children.end()) {
+		p = &i->second;
+		for (unsigned n = 0; n < p->size(); n ++) {
+			reference(detach(*p, n));
+		}
+	}
 	return child_itors(child_iterator(p->begin()), child_iterator(p->end()));
 }
 
@@ -613,6 +782,17 @@ bool config::has_child(const std::string &key) const
 }
 
 config &config::child(const std::string& key, int n)
+{
+	const config& cfg = static_cast<const config*>(this)->child(key, n);
+	if (!cfg) {
+		return invalid;
+	}
+
+	if (n < 0) n = children.find(key)->second.size() + n;
+	return *reference(detach(children.find(key)->second, n));
+}
+
+const config &config::child(const std::string& key, int n) const
 {
 	check_valid();
 
@@ -662,9 +842,9 @@ const config & config::child_or_empty(const std::string& key) const
 
 config &config::child_or_add(const std::string &key)
 {
-	child_map::const_iterator i = children.find(key);
+	child_map::iterator i = children.find(key);
 	if (i != children.end() && !i->second.empty())
-		return *i->second.front();
+		return *reference(detach(i->second, 0));
 
 	return add_child(key);
 }
@@ -674,9 +854,9 @@ config& config::add_child(const std::string& key)
 	check_valid();
 
 	child_list& v = children[key];
-	v.push_back(new config());
+	v.push_back(create_child(arena_, NULL));
 	ordered_children.push_back(child_pos(children.find(key),v.size()-1));
-	return *v.back();
+	return *reference(v.back());
 }
 
 config& config::add_child(const std::string& key, const config& val)
@@ -684,9 +864,9 @@ config& config::add_child(const std::string& key, const config& val)
 	check_valid(val);
 
 	child_list& v = children[key];
-	v.push_back(new config(val));
+	v.push_back(create_child(arena_, &val));
 	ordered_children.push_back(child_pos(children.find(key),v.size()-1));
-	return *v.back();
+	return *reference(v.back());
 }
 
 #ifdef HAVE_CXX11
@@ -695,9 +875,13 @@ config &config::add_child(const std::string &key, config &&val)
 	check_valid(val);
 
 	child_list &v = children[key];
-	v.push_back(new config(std::move(val)));
+	if (arena_) {
+		v.push_back(create_child(arena_, &val));
+	} else {
+		v.push_back(share(new config(std::move(val))));
+	}
 	ordered_children.push_back(child_pos(children.find(key), v.size() - 1));
-	return *v.back();
+	return *reference(v.back());
 }
 #endif
 
@@ -710,7 +894,7 @@ config &config::add_child_at(const std::string &key, const config &val, unsigned
 		throw error("illegal index to add child at");
 	}
 
-	v.insert(v.begin()+index,new config(val));
+	v.insert(v.begin()+index,create_child(arena_, &val));
 
 	bool inserted = false;
 
@@ -731,7 +915,7 @@ config &config::add_child_at(const std::string &key, const config &val, unsigned
 		ordered_children.push_back(value);
 	}
 
-	return *v[index];
+	return *reference(v[index]);
 }
 
 namespace {
@@ -759,7 +943,7 @@ void config::clear_children(const std::string& key)
 		ordered_children.end(), remove_ordered(i)), ordered_children.end());
 
 	BOOST_FOREACH(config *c, i->second) {
-		delete c;
+		release(c);
 	}
 
 	children.erase(i);
@@ -779,7 +963,12 @@ void config::splice_children(config &src, const std::string &key)
 	child_list &dst = children[key];
 	child_map::iterator i_dst = children.find(key);
 	unsigned before = dst.size();
-	dst.insert(dst.end(), i_src->second.begin(), i_src->second.end());
+	BOOST_FOREACH(config* c, i_src->second) {
+		// nodes from another arena are copied, the rest just change owner
+		// so references to them stay valid.
+		dst.push_back(c->arena_ && c->arena_ != arena_? create_child(arena_, c): share(c));
+		release(c);
+	}
 	src.children.erase(i_src);
 	// key might be a reference to i_src->first, so it is no longer usable.
 
@@ -794,8 +983,8 @@ void config::recursive_clear_value(const std::string& key)
 
 	values.erase(key);
 
-	BOOST_FOREACH(const any_child &value, all_children_range()) {
-		const_cast<config *>(&value.cfg)->recursive_clear_value(key);
+	BOOST_FOREACH(const child_pos& pos, ordered_children) {
+		detach(pos.pos->second, pos.index)->recursive_clear_value(key);
 	}
 }
 
@@ -815,7 +1004,7 @@ std::vector<config::child_pos>::iterator config::remove_child(
 	}
 
 	// Remove from the child map.
-	delete pos->second[index];
+	release(pos->second[index]);
 	pos->second.erase(pos->second.begin() + index);
 
 	// Erase from the ordering and return the next position.
@@ -928,10 +1117,22 @@ private:
 
 config &config::find_child(const std::string &key, const std::string &name,
 	const std::string &value)
+{
+	const config& cfg = static_cast<const config*>(this)->find_child(key, name, value);
+	if (!cfg) {
+		return invalid;
+	}
+
+	child_list& l = children.find(key)->second;
+	return *reference(detach(l, std::find(l.begin(), l.end(), &cfg) - l.begin()));
+}
+
+const config &config::find_child(const std::string &key, const std::string &name,
+	const std::string &value) const
 {
 	check_valid();
 
-	const child_map::iterator i = children.find(key);
+	const child_map::const_iterator i = children.find(key);
 	if(i == children.end()) {
 		DBG_CF << "Key »" << name << "« value »" << value
 				<< "« pair not found as child of key »" << key << "«.\n";
@@ -939,7 +1140,7 @@ config &config::find_child(const std::string &key, const std::string &name,
 		return invalid;
 	}
 
-	const child_list::iterator j = std::find_if(i->second.begin(),
+	const child_list::const_iterator j = std::find_if(i->second.begin(),
 	                                            i->second.end(),
 	                                            config_has_value(name,value));
 	if(j != i->second.end()) {
@@ -992,8 +1193,10 @@ void config::clear()
 				if (state.vi < v.size()) {
 					config* c = v[state.vi];
 					++state.vi;
-					if (c->children.empty()) {
-						delete c; //special case for a slight speed increase?
+					if (!SDL_AtomicDecRef(&c->refs_)) {
+						// still owned by another tree, leave its subtree alone.
+					} else if (c->children.empty()) {
+						destroy(c); //special case for a slight speed increase?
 					} else {
 						//descend to the next level
 						config_clear_state next;
@@ -1011,7 +1214,7 @@ void config::clear()
 				//have been deleted, so it's safe to clear the map, delete the
 				//node and move up one level
 				state.c->children.clear();
-				if (state.c != this) delete state.c;
+				if (state.c != this) destroy(state.c);
 				l.pop_back();
 			}
 		}
@@ -1198,7 +1401,7 @@ void config::apply_diff(const config& diff, bool track /* = false */)
 				throw error("error in diff: could not find element '" + item.key + "'");
 			}
 
-			itor->second[index]->apply_diff(item.cfg, track);
+			detach(itor->second, index)->apply_diff(item.cfg, track);
 		}
 	}
 
@@ -1222,7 +1425,7 @@ void config::apply_diff(const config& diff, bool track /* = false */)
 				if(itor == children.end() || index >= itor->second.size()) {
 					throw error("error in diff: could not find element '" + item.key + "'");
 				}
-				itor->second[index]->values[diff_track_attribute] = "deleted";
+				detach(itor->second, index)->values[diff_track_attribute] = "deleted";
 			}
 		}
 	}
@@ -1253,11 +1456,11 @@ void config::clear_diff_track(const config& diff)
 				throw error("error in diff: could not find element '" + item.key + "'");
 			}
 
-			itor->second[index]->clear_diff_track(item.cfg);
+			detach(itor->second, index)->clear_diff_track(item.cfg);
 		}
 	}
-	BOOST_FOREACH(const any_child &value, all_children_range()) {
-		const_cast<config *>(&value.cfg)->remove_attribute(diff_track_attribute);
+	BOOST_FOREACH(const child_pos& pos, ordered_children) {
+		detach(pos.pos->second, pos.index)->remove_attribute(diff_track_attribute);
 	}
 }
 
@@ -1288,7 +1491,7 @@ void config::merge_with(const config& c)
 				if ( merge_child["__remove"].to_bool() ) {
 					to_remove.push_back(*i);
 				} else
-					(i->pos->second[i->index])->merge_with(merge_child);
+					detach(i->pos->second, i->index)->merge_with(merge_child);
 			}
 		}
 	}
@@ -1431,10 +1634,27 @@ std::string config::hash() const
 	return std::string(hash_str);
 }
 
+void config::make_shareable()
+{
+	BOOST_FOREACH(const child_pos& pos, ordered_children) {
+		config* cfg = pos.pos->second[pos.index];
+		cfg->referenced_ = false;
+		cfg->make_shareable();
+	}
+}
+
 void config::swap(config& cfg)
 {
 	check_valid(cfg);
 
+	if (arena_ != cfg.arena_) {
+		// maps keep the allocator they were created with, so copy across arenas.
+		config tmp(cfg);
+		cfg.assign(*this);
+		assign(tmp);
+		return;
+	}
+
 	values.swap(cfg.values);
 	children.swap(cfg.children);
 	ordered_children.swap(cfg.ordered_children);
@@ -1449,7 +1669,11 @@ bool operator==(const config& a, const config& b)
 
 	config::all_children_itors x = a.all_children_range(), y = b.all_children_range();
 	for (; x.first != x.second && y.first != y.second; ++x.first, ++y.first) {
-		if (x.first->key != y.first->key || x.first->cfg != y.first->cfg) {
+		if (x.first->key != y.first->key) {
+			return false;
+		}
+		// shared subtrees are equal without walking them.
+		if (&x.first->cfg != &y.first->cfg && x.first->cfg != y.first->cfg) {
 			return false;
 		}
 	}
@@ -33,14 +33,21 @@
 #include <map>
 #include <iosfwd>
 #include <vector>
+#include <new>
+#ifdef HAVE_CXX11
+#include <type_traits>
+#endif
 
 #include <boost/exception/exception.hpp>
+#include <boost/type_traits/alignment_of.hpp>
 #include <boost/variant/apply_visitor.hpp>
 #include <boost/variant/variant.hpp>
 
 #include "game_errors.hpp"
 #include "tstring.hpp"
 
+#include "SDL_atomic.h"
+
 class config;
 struct tconfig_implementation;
 class vconfig;
@@ -58,7 +65,129 @@ std::ostream &operator << (std::ostream &, const config &);
 #define VERBOSE_CONFIG
 #endif
 
-/** A config object defines a single node in a WML file, with access to child nodes. */
+/**
+ * Monotonic memory region for transient config trees.
+ *
+ * Nodes allocated from it are never freed individually; all memory is returned
+ * at once when the arena is destroyed, so it must outlive every config using it.
+ */
+class tconfig_arena
+{
+public:
+	explicit tconfig_arena(size_t block_size = 16 * 1024);
+	~tconfig_arena();
+
+	void* allocate(size_t size, size_t align);
+
+	/** Number of allocate() calls served, for measuring parse cost. */
+	size_t allocations() const { return allocations_; }
+	/** Number of blocks requested from the heap. */
+	size_t blocks() const { return blocks_.size(); }
+	/** Bytes handed out by allocate(). */
+	size_t bytes() const { return bytes_; }
+
+private:
+	tconfig_arena(const tconfig_arena&);
+	tconfig_arena& operator=(const tconfig_arena&);
+
+	std::vector<char*> blocks_;
+	const size_t block_size_;
+	char* cur_;
+	size_t left_;
+	size_t allocations_;
+	size_t bytes_;
+};
+
+/**
+ * Allocator of config's maps. With a NULL arena it is the normal heap allocator.
+ * Copies of a container always go to the heap, so they can outlive the arena.
+ */
+template<typename T>
+class tconfig_allocator
+{
+public:
+	typedef T value_type;
+	typedef T* pointer;
+	typedef const T* const_pointer;
+	typedef T& reference;
+	typedef const T& const_reference;
+	typedef size_t size_type;
+	typedef ptrdiff_t difference_type;
+
+#ifdef HAVE_CXX11
+	typedef std::false_type propagate_on_container_copy_assignment;
+	typedef std::false_type propagate_on_container_move_assignment;
+	// config::swap only swaps maps of the same arena.
+	typedef std::true_type propagate_on_container_swap;
+#endif
+
+	template<typename U> struct rebind { typedef tconfig_allocator<U> other; };
+
+	explicit tconfig_allocator(tconfig_arena* arena = NULL)
+		: arena_(arena)
+	{}
+
+	template<typename U>
+	tconfig_allocator(const tconfig_allocator<U>& that)
+		: arena_(that.arena())
+	{}
+
+	T* allocate(size_t n)
+	{
+		if (arena_) {
+			return static_cast<T*>(arena_->allocate(n * sizeof(T), boost::alignment_of<T>::value));
+		}
+		return static_cast<T*>(::operator new(n * sizeof(T)));
+	}
+
+	void deallocate(T* p, size_t)
+	{
+		if (!arena_) {
+			::operator delete(p);
+		}
+	}
+
+#ifdef HAVE_CXX11
+	template<typename U, typename... Args>
+	void construct(U* p, Args&&... args) { ::new((void*)p) U(std::forward<Args>(args)...); }
+
+	template<typename U>
+	void destroy(U* p) { p->~U(); }
+#else
+	void construct(pointer p, const T& val) { ::new((void*)p) T(val); }
+
+	void destroy(pointer p) { p->~T(); }
+#endif
+
+	size_t max_size() const { return size_t(-1) / sizeof(T); }
+
+	tconfig_allocator select_on_container_copy_construction() const { return tconfig_allocator(); }
+
+	tconfig_arena* arena() const { return arena_; }
+
+	template<typename U>
+	bool operator==(const tconfig_allocator<U>& that) const { return arena_ == that.arena(); }
+	template<typename U>
+	bool operator!=(const tconfig_allocator<U>& that) const { return arena_ != that.arena(); }
+
+private:
+	tconfig_arena* arena_;
+};
+
+/**
+ * A config object defines a single node in a WML file, with access to child nodes.
+ *
+ * Child nodes are reference counted and shared copy-on-write: copying a config,
+ * append_children and add_child(key, cfg) share the subtrees of the source
+ * instead of cloning them. A shared child is cloned (one level deep) the first
+ * time it is reached through a non-const accessor. A child handed out that way
+ * is never shared afterwards, later copies clone it, so a reference kept to it
+ * only ever modifies this tree.
+ *
+ * A config constructed with a tconfig_arena builds its whole tree (nodes and map
+ * entries) in that arena. Copying such a tree into a config that is not in the
+ * same arena makes a deep copy on the heap.
+ */
 class config
 {
 	friend bool operator==(const config& a, const config& b);
@@ -103,6 +232,11 @@ public:
 	 */
 	explicit config(const std::string &child);
 
+	/**
+	 * Creates an empty node whose subtree is allocated from @a arena.
+	 */
+	explicit config(tconfig_arena& arena);
+
 	~config();
 
 
@@ -115,7 +249,8 @@ public:
 #endif
 
 	typedef std::vector<config*> child_list;
-	typedef std::map<std::string,child_list> child_map;
+	typedef std::map<std::string, child_list, std::less<std::string>,
+		tconfig_allocator<std::pair<const std::string, child_list> > > child_map;
 
 	struct const_child_iterator;
 
@@ -305,7 +440,8 @@ public:
 		static const std::string s_true, s_false;
 	};
 
-	typedef std::map<std::string, attribute_value> attribute_map;
+	typedef std::map<std::string, attribute_value, std::less<std::string>,
+		tconfig_allocator<std::pair<const std::string, attribute_value> > > attribute_map;
 	typedef attribute_map::value_type attribute;
 
 	struct const_attribute_iterator
@@ -365,8 +501,7 @@ public:
 	 * @note A negative @a n accesses from the end of the object.
 	 *       For instance, -1 is the index of the last child.
 	 */
-	const config &child(const std::string& key, int n = 0) const
-	{ return const_cast<config *>(this)->child(key, n); }
+	const config &child(const std::string& key, int n = 0) const;
 
 	/**
 	 * Returns a mandatory child node.
@@ -461,8 +596,7 @@ public:
 		const std::string &value);
 
 	const config &find_child(const std::string &key, const std::string &name,
-		const std::string &value) const
-	{ return const_cast<config *>(this)->find_child(key, name, value); }
+		const std::string &value) const;
 
 	void clear_children(const std::string& key);
 
@@ -613,10 +747,57 @@ public:
 	 */
 	void merge_children_by_attribute(const std::string& key, const std::string& attribute);
 
-	//this is a cheap O(1) operation
+	/**
+	 * This is a cheap O(1) operation when both configs use the same arena.
+	 * Otherwise the contents are copied, so each side keeps its own allocation.
+	 */
 	void swap(config& cfg);
 
+	/**
+	 * Lets copies share every subtree of this config again. Call it only when no
+	 * reference to a child obtained through a non-const accessor is held, e.g.
+	 * right after a reader has built the tree.
+	 */
+	void make_shareable();
+
 private:
+	/** Takes one more reference to the heap node @a cfg. */
+	static config* share(config* cfg);
+
+	/** Returns @a cfg after noting that a non-const reference to it is handed out. */
+	static config* reference(config* cfg);
+
+	/** Drops one reference to @a cfg, deleting it when this was the last one. */
+	static void release(config* cfg);
+
+	/**
+	 * Makes @a l[index] exclusively owned by @a l before it is modified,
+	 * cloning it if it is shared with another tree.
+	 */
+	static config* detach(child_list& l, unsigned index);
+
+	/** Frees a node nobody refers to any longer. */
+	static void destroy(config* cfg);
+
+	/**
+	 * Allocates a new child node in @a arena (or on the heap if NULL),
+	 * copying @a val into it if given. The returned node is already shared once.
+	 */
+	static config* create_child(tconfig_arena* arena, const config* val);
+
+	/**
+	 * Returns @a cfg ready to be linked into this tree: shared if its storage
+	 * lives at least as long as this tree and no reference to it is handed out,
+	 * copied otherwise.
+	 */
+	config* adopt(config* cfg) const;
+
+	/** Replaces the contents of this config with a copy of @a cfg, allocated in arena_. */
+	void assign(const config& cfg);
+
+	/** Appends @a cfg as a child without copying it. */
+	void add_child_shared(const std::string& key, config* cfg);
+
 	/**
 	 * Removes the child at position @a pos of @a l.
 	 */
@@ -629,6 +810,21 @@ private:
 	child_map children;
 
 	std::vector<child_pos> ordered_children;
+
+	/**
+	 * Number of parents owning this node. 0 for a config that is not
+	 * a child of any other, i.e. one on the stack or a member variable.
+	 */
+	SDL_atomic_t refs_;
+
+	/**
+	 * A non-const reference to this node has been handed out, so it cannot be
+	 * shared until make_shareable() says that reference is gone.
+	 */
+	bool referenced_;
+
+	/** Arena this node and its maps are allocated from, NULL for the heap. */
+	tconfig_arena* const arena_;
 };
 
 extern const config null_cfg;
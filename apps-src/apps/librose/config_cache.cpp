@@ -709,6 +709,9 @@ std::vector<std::string> generate_tb_short_paths(const std::string& id, const co
 void teditor_::get_wml2bin_desc_from_wml(const std::vector<BIN_TYPE>& system_bin_types)
 {
 	tres_path_lock lock(*this);
+	// files may be edited since last refresh. bin types share directories,
+	// so every directory is still read only once in this call.
+	invalidate_file_tree_index();
 
 	wml2bin_desc desc;
 	file_tree_checksum dir_checksum;
@@ -809,7 +812,10 @@ void teditor_::get_wml2bin_desc_from_wml(const std::vector<BIN_TYPE>& system_bin
 			desc.wml_modified = dir_checksum.modified;
 		}
 
-		if (!wml_checksum_from_file(bin_to_path + "/" + desc.bin_name, &desc.bin_nfiles, &desc.bin_sum_size, (uint32_t*)&desc.bin_modified)) {
+		const std::string bin_file = bin_to_path + "/" + desc.bin_name;
+		if (!wml_checksum_from_file(bin_file, &desc.bin_nfiles, &desc.bin_sum_size, (uint32_t*)&desc.bin_modified)
+			|| (type == TB_DAT && !wml_building_rules_current(bin_file))) {
+			// tb-*.dat of previous format is regenerated.
 			desc.bin_nfiles = desc.bin_sum_size = desc.bin_modified = 0;
 		}
 
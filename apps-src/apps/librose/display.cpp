@@ -1112,9 +1112,10 @@ void display::drawing_buffer_commit(texture& screen, const SDL_Rect& clip_rect)
 
 	tdrawing_buffer& drawing_buffer = to_canvas_? canvas_drawing_buffer_: drawing_buffer_;
 	// std::list::sort() is a stable sort
-	uint32_t start = SDL_GetTicks();
-	drawing_buffer.sort();
-	uint32_t ticks1 = SDL_GetTicks();
+	{
+		tprofile_scope scope("sort");
+		drawing_buffer.sort();
+	}
 
 	/*
 	 * Info regarding the rendering algorithm.
@@ -1135,7 +1136,6 @@ void display::drawing_buffer_commit(texture& screen, const SDL_Rect& clip_rect)
 			image::render_blit(renderer, blit, blit3.x(), blit3.y());
 		}
 	}
-	// posix_print("drawing_buffer_commit, lists: %u, sort: %u\n", drawing_buffer.size(), ticks1 - start);
 	drawing_buffer.clear();
 }
 
@@ -1601,12 +1601,14 @@ bool display::scroll(int xmove, int ymove)
 		SDL_Renderer* renderer = get_renderer();
 		VALIDATE(!SDL_RenderIsClipEnabled(renderer), null_str);
 
-		texture target = SDL_CreateTexture(renderer, video_.getformat().format, SDL_TEXTUREACCESS_TARGET, srcrect.w, srcrect.h);
+		// scroll buffer is kept, so drag scroll doesn't allocate texture every event.
+		texture& target = get_scroll_texture(map_area().w, map_area().h);
+		const SDL_Rect bufrect = ::create_rect(0, 0, srcrect.w, srcrect.h);
 		{
 			trender_target_lock lock(renderer, target);
-			SDL_RenderCopy(renderer, get_screen_texture().get(), &srcrect, NULL);
+			SDL_RenderCopy(renderer, get_screen_texture().get(), &srcrect, &bufrect);
 		}
-		SDL_RenderCopy(renderer, target.get(), NULL, &dstrect);
+		SDL_RenderCopy(renderer, target.get(), &bufrect, &dstrect);
 	}
 	// Invalidate locations in the newly visible rects
 
@@ -2120,40 +2122,66 @@ void display::draw(bool update, bool force)
 	}
 
 	local_tod_light_ = has_time_area();
+	invalidated_hexes_ = 0;
+	drawn_hexes_ = 0;
 
 	//
 	// recalculate draw area
 	//
 	draw_area_rect_ = get_visible_hexes();
 	
-	draw_init();
-	pre_draw(draw_area_rect_);
-
-	// invalidate all that needs to be invalidated
-	invalidate_animations();
+	{
+		tprofile_scope scope("pre_draw");
+		draw_init();
+		pre_draw(draw_area_rect_);
+	}
 
-	// update_time_of_day();
-	// these new invalidations can not cause any propagation because
-	// if a hex was invalidated last turn but not this turn, then
-	// * case of no unit in neighbour hex=> no propagation
-	// * case of unit in hex but was there last turn=>its hexes are invalidated too
-	// * case of unit inhex not there last turn => it moved, so was invalidated previously
+	{
+		tprofile_scope scope("invalidate_animations");
+		// invalidate all that needs to be invalidated
+		invalidate_animations();
 
-	add_haloes();
-	halo::unrender();
+		// update_time_of_day();
+		// these new invalidations can not cause any propagation because
+		// if a hex was invalidated last turn but not this turn, then
+		// * case of no unit in neighbour hex=> no propagation
+		// * case of unit in hex but was there last turn=>its hexes are invalidated too
+		// * case of unit inhex not there last turn => it moved, so was invalidated previously
+	}
 
 	std::vector<map_location> unit_invals;
-	invalidate_units(unit_invals);
+	{
+		tprofile_scope scope("halo_unrender");
+		add_haloes();
+		halo::unrender();
+	}
 
-	invalidate_float_widgets();
+	{
+		tprofile_scope scope("invalidate_units");
+		invalidate_units(unit_invals);
+
+		invalidate_float_widgets();
+	}
 
 	// begin render
-	draw_terrains();
-	draw_units(unit_invals);
-	halo::render();
+	{
+		tprofile_scope scope("draw_terrains");
+		draw_terrains();
+	}
+	{
+		tprofile_scope scope("draw_units");
+		draw_units(unit_invals);
+	}
+	{
+		tprofile_scope scope("halo_render");
+		halo::render();
+	}
 
-	texture& screen = video_.getTexture();
-	drawing_buffer_commit(screen, clip_rect_commit());
+	{
+		tprofile_scope scope("drawing_buffer_commit");
+		texture& screen = video_.getTexture();
+		drawing_buffer_commit(screen, clip_rect_commit());
+	}
 
 	dlg_->get_window()->draw();
 
@@ -2161,7 +2189,14 @@ void display::draw(bool update, bool force)
 	// draw_sidebar may genrate new invalidate loc(ex. show_unit_tip), keep those dirty so next draw will update then
 	memset(locs_area_, CLEAN, locs_area_size_);
 
-	draw_sidebar();
+	{
+		tprofile_scope scope("draw_sidebar");
+		draw_sidebar();
+	}
+
+	tframe_profiler& profiler = get_frame_profiler();
+	profiler.count("invalidated hexes", invalidated_hexes_);
+	profiler.count("drawn hexes", drawn_hexes_);
 
 	draw_wrap(update, force);
 }
@@ -37,6 +37,7 @@
 #include <unistd.h>
 #include <dirent.h>
 #include <libgen.h>
+#include <sys/stat.h> // chmod
 #ifndef ANDROID
 #include <sys/param.h> // statfs 
 #include <sys/mount.h> // statfs
@@ -50,6 +51,7 @@
 #include <fstream>
 #include <iomanip>
 #include <set>
+#include <unordered_map>
 #include <boost/algorithm/string.hpp>
 
 // for strerror
@@ -71,6 +73,7 @@
 
 #include <boost/foreach.hpp>
 #include <boost/bind.hpp>
+#include <boost/crc.hpp>
 
 static lg::log_domain log_filesystem("filesystem");
 #define DBG_FS LOG_STREAM(debug, log_filesystem)
@@ -102,6 +105,26 @@ bool ends_with(const std::string& str, const std::string& suffix)
 	return str.size() >= suffix.size() && std::equal(suffix.begin(),suffix.end(),str.end()-suffix.size());
 }
 
+static bool filter_skip_dir(const std::string& basename, int filter)
+{
+	if ((filter & SKIP_MEDIA_DIR) && (basename == "images"|| basename == "sounds" || basename == "music")) {
+		return true;
+	}
+	if ((filter & SKIP_SCENARIO_DIR) && (basename == "scenarios"|| basename == "maps" || basename == "music")) {
+		return true;
+	}
+	if ((filter & SKIP_GUI_DIR) && basename == "gui") {
+		return true;
+	}
+	if ((filter & SKIP_INTERNAL_DIR) && basename == "units-internal") {
+		return true;
+	}
+	if ((filter & SKIP_BOOK) && basename == "book") {
+		return true;
+	}
+	return false;
+}
+
 void get_files_in_dir(const std::string &directory,
 					  std::vector<std::string>* files,
 					  std::vector<std::string>* dirs,
@@ -163,19 +186,7 @@ void get_files_in_dir(const std::string &directory,
 		}
 
 		if (SDL_DIRENT_DIR(entry->mode)) {
-			if ((filter & SKIP_MEDIA_DIR) && (basename == "images"|| basename == "sounds" || basename == "music")) {
-				continue;
-			}
-			if ((filter & SKIP_SCENARIO_DIR) && (basename == "scenarios"|| basename == "maps" || basename == "music")) {
-				continue;
-			}
-			if ((filter & SKIP_GUI_DIR) && basename == "gui") {
-				continue;
-			}
-			if ((filter & SKIP_INTERNAL_DIR) && basename == "units-internal") {
-				continue;
-			}
-			if ((filter & SKIP_BOOK) && basename == "book") {
+			if (filter_skip_dir(basename, filter)) {
 				continue;
 			}
 
@@ -703,6 +714,31 @@ void write_file(const std::string& fname, const char* data, int len)
 	posix_fclose(fp);
 }
 
+bool rename_file_over(const std::string& src, const std::string& dst)
+{
+#ifdef _WIN32
+	// names are utf-8, same as SDL_RWFromFile.
+	std::vector<WCHAR> wsrc(MultiByteToWideChar(CP_UTF8, 0, src.c_str(), -1, NULL, 0));
+	MultiByteToWideChar(CP_UTF8, 0, src.c_str(), -1, &wsrc[0], wsrc.size());
+	std::vector<WCHAR> wdst(MultiByteToWideChar(CP_UTF8, 0, dst.c_str(), -1, NULL, 0));
+	MultiByteToWideChar(CP_UTF8, 0, dst.c_str(), -1, &wdst[0], wdst.size());
+
+	return MoveFileExW(&wsrc[0], &wdst[0], MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)? true: false;
+#else
+	// src is a new file, give it dst's permission bits and owner, else scripts lose +x.
+	struct stat st;
+	if (stat(dst.c_str(), &st) == 0) {
+		if (chmod(src.c_str(), st.st_mode & 07777) != 0) {
+			return false;
+		}
+		if ((st.st_uid != geteuid() || st.st_gid != getegid()) && chown(src.c_str(), st.st_uid, st.st_gid) != 0) {
+			// only root can give file to other user, src keeps our owner.
+		}
+	}
+	return rename(src.c_str(), dst.c_str()) == 0;
+#endif
+}
+
 std::string read_map(const std::string& name)
 {
 	std::string res;
@@ -818,26 +854,188 @@ bool file_tree_checksum::operator==(const file_tree_checksum &rhs) const
 		modified == rhs.modified;
 }
 
-static void get_file_tree_checksum_internal(const std::string& path, file_tree_checksum& res, int filter)
+// stat index of directory trees used by checksums.
+// every directory is read once, children of one level are read in parallel,
+// and result is kept until invalidate_file_tree_index.
+class tstat_index
 {
+public:
+	// more threads don't help since disk is bottleneck.
+	static const int max_threads = 8;
+	// a level with fewer directories is read by this thread only.
+	static const int min_parallel_dirs = 8;
+
+	struct tdir {
+		tdir()
+			: nfiles(0)
+			, sum_size(0)
+			, modified(0)
+			, subdirs()
+		{}
+
+		size_t nfiles;
+		size_t sum_size;
+		time_t modified;
+		std::vector<std::string> subdirs;
+	};
+
+	tstat_index()
+		: dirs_()
+		, pending_(NULL)
+		, results_(NULL)
+	{
+		SDL_AtomicSet(&next_, 0);
+	}
 
-	std::vector<std::string> dirs;
-	get_files_in_dir(path,NULL,&dirs, ENTIRE_FILE_PATH, filter, DONT_REORDER, &res);
-	loadscreen::increment_progress();
+	void clear() { dirs_.clear(); }
+	void checksum(const std::string& path, int filter, file_tree_checksum& res);
+
+private:
+	void read(const std::vector<std::string>& pending, std::vector<tdir>& results);
+	static int thread_main(void* param);
+	void work();
+	static void read_dir(const std::string& path, tdir& result);
+
+private:
+	// key is full path without trailing '/'.
+	std::unordered_map<std::string, tdir> dirs_;
+
+	const std::vector<std::string>* pending_;
+	std::vector<tdir>* results_;
+	SDL_atomic_t next_;
+};
+
+void tstat_index::read_dir(const std::string& path, tdir& result)
+{
+	SDL_DIR* dir = SDL_OpenDir(path.c_str());
+	if (dir == NULL) {
+		return;
+	}
+
+	SDL_dirent2* entry;
+	while ((entry = SDL_ReadDir(dir)) != NULL) {
+		if (entry->name[0] == '.') {
+			continue;
+		}
+		if (SDL_DIRENT_DIR(entry->mode)) {
+			result.subdirs.push_back(entry->name);
+		} else {
+			if (entry->mtime > result.modified) {
+				result.modified = entry->mtime;
+			}
+			result.sum_size += entry->size;
+			result.nfiles ++;
+		}
+	}
+	SDL_CloseDir(dir);
+}
+
+int tstat_index::thread_main(void* param)
+{
+	static_cast<tstat_index*>(param)->work();
+	return 0;
+}
+
+void tstat_index::work()
+{
+	const int size = pending_->size();
+	while (true) {
+		const int at = SDL_AtomicAdd(&next_, 1);
+		if (at >= size) {
+			break;
+		}
+		read_dir((*pending_)[at], (*results_)[at]);
+	}
+}
+
+void tstat_index::read(const std::vector<std::string>& pending, std::vector<tdir>& results)
+{
+	results.resize(pending.size());
+	pending_ = &pending;
+	results_ = &results;
+	SDL_AtomicSet(&next_, 0);
+
+	std::vector<SDL_Thread*> handles;
+	if ((int)pending.size() >= min_parallel_dirs) {
+		int threads = std::min(SDL_GetCPUCount(), (int)max_threads);
+		for (int n = 1; n < threads; n ++) {
+			SDL_Thread* thread = SDL_CreateThread(thread_main, "stat", this);
+			if (thread) {
+				handles.push_back(thread);
+			}
+		}
+	}
+	// this thread works too.
+	work();
+	for (std::vector<SDL_Thread*>::const_iterator it = handles.begin(); it != handles.end(); ++ it) {
+		SDL_WaitThread(*it, NULL);
+	}
+	pending_ = NULL;
+	results_ = NULL;
+}
+
+void tstat_index::checksum(const std::string& path, int filter, file_tree_checksum& res)
+{
+	// relative path is rooted on game_config::path, same as get_files_in_dir.
+	std::string root = SDL_IsRootPath(path.c_str())? path: game_config::path + "/" + path;
+	while (root.size() > 1 && (root.back() == '/' || root.back() == '\\')) {
+		root.erase(root.size() - 1);
+	}
+
+	std::vector<std::string> level(1, root);
+	std::vector<std::string> next, pending;
+	std::vector<tdir> results;
+	while (!level.empty()) {
+		pending.clear();
+		for (std::vector<std::string>::const_iterator it = level.begin(); it != level.end(); ++ it) {
+			if (dirs_.find(*it) == dirs_.end()) {
+				pending.push_back(*it);
+			}
+		}
+		if (!pending.empty()) {
+			read(pending, results);
+			for (size_t n = 0; n < pending.size(); n ++) {
+				dirs_[pending[n]] = std::move(results[n]);
+			}
+		}
 
-	for (std::vector<std::string>::const_iterator j = dirs.begin(); j != dirs.end(); ++j) {
-		get_file_tree_checksum_internal(*j, res, filter);
+		next.clear();
+		for (std::vector<std::string>::const_iterator it = level.begin(); it != level.end(); ++ it) {
+			const tdir& dir = dirs_.find(*it)->second;
+			if (dir.modified > res.modified) {
+				res.modified = dir.modified;
+			}
+			res.sum_size += dir.sum_size;
+			res.nfiles += dir.nfiles;
+			loadscreen::increment_progress();
+
+			for (std::vector<std::string>::const_iterator it2 = dir.subdirs.begin(); it2 != dir.subdirs.end(); ++ it2) {
+				if (!filter_skip_dir(*it2, filter)) {
+					next.push_back(*it + "/" + *it2);
+				}
+			}
+		}
+		level.swap(next);
 	}
 }
 
+static tstat_index stat_index;
+
+void invalidate_file_tree_index()
+{
+	stat_index.clear();
+}
+
 const file_tree_checksum& data_tree_checksum(bool reset, int filter)
 {
 	static file_tree_checksum checksum;
-	if (reset)
+	if (reset) {
 		checksum.reset();
+		invalidate_file_tree_index();
+	}
 	if(checksum.nfiles == 0) {
-		get_file_tree_checksum_internal("data/", checksum, filter);
-		get_file_tree_checksum_internal(get_user_data_dir() + "/data/", checksum, filter);
+		stat_index.checksum("data/", filter, checksum);
+		stat_index.checksum(get_user_data_dir() + "/data/", filter, checksum);
 		LOG_FS << "calculated data tree checksum: "
 			   << checksum.nfiles << " files; "
 			   << checksum.sum_size << " bytes\n";
@@ -850,7 +1048,7 @@ void data_tree_checksum(const std::vector<std::string>& paths, file_tree_checksu
 {
 	checksum.reset();
 	for (std::vector<std::string>::const_iterator it = paths.begin(); it != paths.end(); ++ it) {
-		get_file_tree_checksum_internal(*it, checksum, filter);
+		stat_index.checksum(*it, filter, checksum);
 	}
 }
 
@@ -1338,6 +1536,239 @@ bool compare_directory(const std::string& dir1, const std::string& dir2)
 	return true;
 }
 
+class tverified_copier
+{
+public:
+	// more threads don't help since disk is bottleneck.
+	static const int max_threads = 8;
+	static const int buf_size = 64 * 1024;
+
+	tverified_copier(const std::string& src, const std::string& dst);
+
+	bool copy(bool subfolders, bool mirror, std::set<std::string>* files);
+
+private:
+	bool cb_collect(const std::string& dir, const SDL_dirent2* dirent, bool subfolders, std::set<std::string>* names, std::set<std::string>* dirs);
+	static int thread_main(void* param);
+	void work();
+	struct titem {
+		titem(const std::string& name, int64_t size, int64_t mtime)
+			: name(name)
+			, size(size)
+			, mtime(mtime)
+		{}
+
+		std::string name;
+		int64_t size;
+		int64_t mtime;
+	};
+	bool copy_file(const titem& item, std::vector<uint8_t>& buf) const;
+	static bool file_crc32(const std::string& file, int64_t size, std::vector<uint8_t>& buf, uint32_t& result);
+
+private:
+	std::string src_;
+	std::string dst_;
+	// relative name, size and modified time of files that require copy.
+	std::vector<titem> items_;
+	SDL_atomic_t next_;
+	SDL_atomic_t fail_;
+};
+
+tverified_copier::tverified_copier(const std::string& src, const std::string& dst)
+	: src_(src)
+	, dst_(dst)
+	, items_()
+{
+	SDL_AtomicSet(&next_, 0);
+	SDL_AtomicSet(&fail_, 0);
+	while (!src_.empty() && (src_.back() == '/' || src_.back() == '\\')) {
+		src_.erase(src_.size() - 1);
+	}
+	while (!dst_.empty() && (dst_.back() == '/' || dst_.back() == '\\')) {
+		dst_.erase(dst_.size() - 1);
+	}
+}
+
+bool tverified_copier::cb_collect(const std::string& dir, const SDL_dirent2* dirent, bool subfolders, std::set<std::string>* names, std::set<std::string>* dirs)
+{
+	const std::string root = names? src_: dst_;
+	std::string name = dir.size() > root.size()? dir.substr(root.size() + 1) + "/": null_str;
+	name.append(dirent->name);
+
+	if (SDL_DIRENT_DIR(dirent->mode)) {
+		if (subfolders) {
+			dirs->insert(name);
+		}
+	} else if (names) {
+		names->insert(name);
+		items_.push_back(titem(name, dirent->size, dirent->mtime));
+	} else {
+		// collect dst's files, put them into dirs.
+		dirs->insert(name);
+	}
+	return true;
+}
+
+bool tverified_copier::copy(bool subfolders, bool mirror, std::set<std::string>* files)
+{
+	if (src_.empty() || dst_.empty()) {
+		return false;
+	}
+
+	std::set<std::string> names;
+	std::set<std::string> dirs;
+	if (!walk_dir(src_, subfolders, boost::bind(&tverified_copier::cb_collect, this, _1, _2, subfolders, &names, &dirs))) {
+		return false;
+	}
+
+	if (mirror) {
+		// remove what doesn't exist in src, keep others so unchanged files can be skipped.
+		if (!is_directory(dst_)) {
+			SDL_DeleteFiles(dst_.c_str());
+		}
+		std::set<std::string> dst_dirs;
+		walk_dir(dst_, true, boost::bind(&tverified_copier::cb_collect, this, _1, _2, true, (std::set<std::string>*)NULL, &dst_dirs));
+		for (std::set<std::string>::const_iterator it = dst_dirs.begin(); it != dst_dirs.end(); ++ it) {
+			const std::string& name = *it;
+			if (dirs.find(name) == dirs.end() && names.find(name) == names.end()) {
+				SDL_DeleteFiles((dst_ + "/" + name).c_str());
+			}
+		}
+	}
+
+	SDL_MakeDirectory(dst_.c_str());
+	// parent is in front of child.
+	for (std::set<std::string>::const_iterator it = dirs.begin(); it != dirs.end(); ++ it) {
+		SDL_MakeDirectory((dst_ + "/" + *it).c_str());
+	}
+
+	int threads = std::min(SDL_GetCPUCount(), (int)max_threads);
+	threads = std::min(threads, (int)items_.size());
+	std::vector<SDL_Thread*> handles;
+	for (int n = 1; n < threads; n ++) {
+		SDL_Thread* thread = SDL_CreateThread(thread_main, "copier", this);
+		if (thread) {
+			handles.push_back(thread);
+		}
+	}
+	// this thread works too.
+	work();
+	for (std::vector<SDL_Thread*>::const_iterator it = handles.begin(); it != handles.end(); ++ it) {
+		SDL_WaitThread(*it, NULL);
+	}
+
+	if (SDL_AtomicGet(&fail_)) {
+		return false;
+	}
+	if (files) {
+		files->swap(names);
+	}
+	return true;
+}
+
+int tverified_copier::thread_main(void* param)
+{
+	static_cast<tverified_copier*>(param)->work();
+	return 0;
+}
+
+void tverified_copier::work()
+{
+	std::vector<uint8_t> buf(buf_size);
+	const int size = items_.size();
+	while (!SDL_AtomicGet(&fail_)) {
+		const int at = SDL_AtomicAdd(&next_, 1);
+		if (at >= size) {
+			break;
+		}
+		if (!copy_file(items_[at], buf)) {
+			SDL_AtomicSet(&fail_, 1);
+		}
+	}
+}
+
+bool tverified_copier::file_crc32(const std::string& file, int64_t size, std::vector<uint8_t>& buf, uint32_t& result)
+{
+	posix_file_t fp = INVALID_FILE;
+	posix_fopen(file.c_str(), GENERIC_READ, OPEN_EXISTING, fp);
+	if (fp == INVALID_FILE) {
+		return false;
+	}
+	boost::crc_32_type crc;
+	int64_t total = 0;
+	size_t bytes;
+	while ((bytes = posix_fread(fp, &buf[0], buf.size())) > 0) {
+		crc.process_bytes(&buf[0], bytes);
+		total += bytes;
+	}
+	posix_fclose(fp);
+
+	result = crc.checksum();
+	return total == size;
+}
+
+bool tverified_copier::copy_file(const titem& item, std::vector<uint8_t>& buf) const
+{
+	const std::string src = src_ + "/" + item.name;
+	const std::string dst = dst_ + "/" + item.name;
+	const int64_t size = item.size;
+	uint32_t src_crc, dst_crc;
+
+	SDL_dirent stat;
+	if (SDL_GetStat(dst.c_str(), &stat) && stat.size == size) {
+		// dst written after src was last modified, it is what last copy wrote.
+		if (stat.mtime >= item.mtime) {
+			return true;
+		}
+		// src is touched later, compare content. read is cheaper than write.
+		if (file_crc32(src, size, buf, src_crc) && file_crc32(dst, size, buf, dst_crc) && src_crc == dst_crc) {
+			return true;
+		}
+	}
+
+	posix_file_t in = INVALID_FILE, out = INVALID_FILE;
+	posix_fopen(src.c_str(), GENERIC_READ, OPEN_EXISTING, in);
+	if (in == INVALID_FILE) {
+		return false;
+	}
+	posix_fopen(dst.c_str(), GENERIC_WRITE, CREATE_ALWAYS, out);
+	if (out == INVALID_FILE) {
+		posix_fclose(in);
+		return false;
+	}
+
+	// calculate src's crc when copy, it needn't read src again.
+	boost::crc_32_type crc;
+	int64_t total = 0;
+	bool ok = true;
+	size_t bytes;
+	while ((bytes = posix_fread(in, &buf[0], buf.size())) > 0) {
+		crc.process_bytes(&buf[0], bytes);
+		if (posix_fwrite(out, &buf[0], bytes) != bytes) {
+			ok = false;
+			break;
+		}
+		total += bytes;
+	}
+	posix_fclose(in);
+	posix_fclose(out);
+
+	if (!ok || total != size) {
+		return false;
+	}
+	// verify what is written.
+	return file_crc32(dst, size, buf, dst_crc) && dst_crc == crc.checksum();
+}
+
+bool copy_files_verified(const std::string& src, const std::string& dst, bool subfolders, bool mirror, std::set<std::string>* files)
+{
+	if (files) {
+		files->clear();
+	}
+	tverified_copier copier(src, dst);
+	return copier.copy(subfolders, mirror, files);
+}
+
 scoped_istream& scoped_istream::operator=(std::istream *s)
 {
 	delete stream;
@@ -1755,9 +2186,221 @@ bool file_replace_string(const std::string& src_file, const std::pair<std::strin
 	return file_replace_string(src_file, replaces);
 }
 
+// Aho-Corasick automaton, apply all replaces in one pass over file.
+class tmulti_replacer
+{
+public:
+	static const int chunk_size = 64 * 1024;
+
+	// whether one pass get the same result as tfile::replace_string, which applies replaces one by one.
+	static bool independent(const std::vector<std::pair<std::string, std::string> >& replaces);
+
+	explicit tmulti_replacer(const std::vector<std::pair<std::string, std::string> >& replaces);
+
+	// write result to file.tmp, then rename it over file when there is replace.
+	bool replace_file(const std::string& file);
+
+private:
+	static bool overlap(const std::string& a, const std::string& b);
+	int add_node(int depth);
+
+private:
+	std::vector<std::pair<std::string, std::string> > replaces_;
+	// goto table, node * 256 + byte => node.
+	std::vector<int> delta_;
+	// index of replaces_ which key ends at this node, -1: none.
+	std::vector<int> output_;
+	std::vector<int> depth_;
+};
+
+bool tmulti_replacer::overlap(const std::string& a, const std::string& b)
+{
+	if (a.find(b) != std::string::npos || b.find(a) != std::string::npos) {
+		return true;
+	}
+	const size_t size = std::min(a.size(), b.size());
+	for (size_t len = 1; len < size; len ++) {
+		if (!a.compare(a.size() - len, len, b, 0, len) || !b.compare(b.size() - len, len, a, 0, len)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool tmulti_replacer::independent(const std::vector<std::pair<std::string, std::string> >& replaces)
+{
+	for (std::vector<std::pair<std::string, std::string> >::const_iterator it = replaces.begin(); it != replaces.end(); ++ it) {
+		if (it->first == it->second) {
+			continue;
+		}
+		if (it->first.empty()) {
+			return false;
+		}
+		for (std::vector<std::pair<std::string, std::string> >::const_iterator it2 = replaces.begin(); it2 != replaces.end(); ++ it2) {
+			if (it2 == it || it2->first == it2->second) {
+				continue;
+			}
+			// match of two keys must not overlap, or order of replaces decides which wins.
+			if (overlap(it->first, it2->first)) {
+				return false;
+			}
+			// value must not generate latter key.
+			if (it2 > it && overlap(it->second, it2->first)) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+int tmulti_replacer::add_node(int depth)
+{
+	const int node = output_.size();
+	delta_.resize(delta_.size() + 256, -1);
+	output_.push_back(-1);
+	depth_.push_back(depth);
+	return node;
+}
+
+tmulti_replacer::tmulti_replacer(const std::vector<std::pair<std::string, std::string> >& replaces)
+{
+	for (std::vector<std::pair<std::string, std::string> >::const_iterator it = replaces.begin(); it != replaces.end(); ++ it) {
+		if (it->first != it->second) {
+			replaces_.push_back(*it);
+		}
+	}
+
+	// trie
+	add_node(0);
+	for (int at = 0; at < (int)replaces_.size(); at ++) {
+		const std::string& key = replaces_[at].first;
+		int node = 0;
+		for (size_t n = 0; n < key.size(); n ++) {
+			const uint8_t c = key[n];
+			if (delta_[node * 256 + c] == -1) {
+				const int next = add_node(n + 1);
+				delta_[node * 256 + c] = next;
+			}
+			node = delta_[node * 256 + c];
+		}
+		output_[node] = at;
+	}
+
+	// breadth-first, fill missing goto by failure link, so it becomes a DFA.
+	std::vector<int> fail(output_.size(), 0);
+	std::vector<int> queue;
+	for (int c = 0; c < 256; c ++) {
+		int& next = delta_[c];
+		if (next == -1) {
+			next = 0;
+		} else {
+			queue.push_back(next);
+		}
+	}
+	for (size_t at = 0; at < queue.size(); at ++) {
+		const int node = queue[at];
+		if (output_[node] == -1) {
+			output_[node] = output_[fail[node]];
+		}
+		for (int c = 0; c < 256; c ++) {
+			int& next = delta_[node * 256 + c];
+			if (next == -1) {
+				next = delta_[fail[node] * 256 + c];
+			} else {
+				fail[next] = delta_[fail[node] * 256 + c];
+				queue.push_back(next);
+			}
+		}
+	}
+}
+
+bool tmulti_replacer::replace_file(const std::string& file)
+{
+	posix_file_t in = INVALID_FILE;
+	posix_fopen(file.c_str(), GENERIC_READ, OPEN_EXISTING, in);
+	if (in == INVALID_FILE) {
+		return false;
+	}
+	const std::string temp_file = file + ".tmp";
+	posix_file_t out = INVALID_FILE;
+	posix_fopen(temp_file.c_str(), GENERIC_WRITE, CREATE_ALWAYS, out);
+	if (out == INVALID_FILE) {
+		posix_fclose(in);
+		return false;
+	}
+
+	std::vector<char> buf(chunk_size);
+	// input that may be head of a key, not written yet.
+	std::string window;
+	int64_t total = 0;
+	bool dirty = false, ok = true, stopped = false;
+	int state = 0;
+	size_t bytes;
+	while (ok && (bytes = posix_fread(in, &buf[0], buf.size())) > 0) {
+		size_t start = 0;
+		if (!total && utils::bom_magic_started((const uint8_t*)&buf[0], bytes)) {
+			window.append(&buf[0], BOM_LENGTH);
+			start = BOM_LENGTH;
+		}
+		total += bytes;
+
+		for (size_t n = start; n < bytes; n ++) {
+			const char c = buf[n];
+			window.push_back(c);
+			if (stopped) {
+				continue;
+			}
+			if (!c) {
+				// same as strstr, don't search after '\0'.
+				stopped = true;
+				state = 0;
+				continue;
+			}
+			state = delta_[state * 256 + (uint8_t)c];
+			const int at = output_[state];
+			if (at != -1) {
+				const std::pair<std::string, std::string>& replace = replaces_[at];
+				window.erase(window.size() - replace.first.size());
+				window.append(replace.second);
+				state = 0;
+				dirty = true;
+			}
+		}
+
+		// keep bytes of current partial match only.
+		const size_t keep = stopped? 0: depth_[state];
+		const size_t flush = window.size() - keep;
+		if (flush && posix_fwrite(out, window.c_str(), flush) != flush) {
+			ok = false;
+		}
+		window.erase(0, flush);
+	}
+	if (ok && !window.empty() && posix_fwrite(out, window.c_str(), window.size()) != window.size()) {
+		ok = false;
+	}
+	posix_fclose(in);
+	posix_fclose(out);
+
+	if (!ok || !total || !dirty) {
+		SDL_DeleteFiles(temp_file.c_str());
+		return ok && total;
+	}
+	// rename replaces file in one step, if killed, file is either the former or the new one.
+	if (!rename_file_over(temp_file, file)) {
+		SDL_DeleteFiles(temp_file.c_str());
+		return false;
+	}
+	return true;
+}
+
 // replace src_str in src_file, and generate to dst_file.
 bool file_replace_string(const std::string& src_file, const std::vector<std::pair<std::string, std::string> >& replaces)
 {
+	if (tmulti_replacer::independent(replaces)) {
+		tmulti_replacer replacer(replaces);
+		return replacer.replace_file(src_file);
+	}
+
 	tfile file(src_file,  GENERIC_WRITE, OPEN_EXISTING);
 	int fsize = file.read_2_data();
 	if (!fsize) {
@@ -99,6 +99,9 @@ std::string read_file(const std::string &fname);
 std::istream *istream_file(const std::string &fname, bool to_utf16 = false);
 /** Throws io_exception if an error occurs. */
 void write_file(const std::string& fname, const char* data, int len);
+// rename src to dst in one step, replacing dst if it exists. readers never see dst missing.
+// dst keeps its permission bits (and owner if allowed).
+bool rename_file_over(const std::string& src, const std::string& dst);
 
 std::string read_map(const std::string& name);
 
@@ -148,6 +151,9 @@ struct file_tree_checksum
 /** Get the time at which the data/ tree was last modified at. */
 const file_tree_checksum& data_tree_checksum(bool reset = false, int filter = SKIP_MEDIA_DIR);
 
+/** Forget the cached stat index, next checksum re-reads directories. */
+void invalidate_file_tree_index();
+
 /** Get the time at which the data/ tree was last modified at. (used by editor)*/
 void data_tree_checksum(const std::vector<std::string>& paths, file_tree_checksum& checksum, int filter);
 
@@ -187,6 +193,10 @@ typedef boost::function<bool (const std::string& dir, const SDL_dirent2* dirent)
 bool walk_dir(const std::string& rootdir, bool subfolders, const twalk_dir_function& fn);
 bool copy_root_files(const std::string& src, const std::string& dst, std::set<std::string>* files);
 bool compare_directory(const std::string& dir1, const std::string& dir2);
+// copy files from src to dst by multiple threads. dst file which has same size and isn't older than src is skipped,
+// if it is older, it is skipped when crc32 is same too. every written file is verified by crc32. if mirror, what doesn't exist in src is removed from dst.
+// @files: name(relative to src) of all files in src.
+bool copy_files_verified(const std::string& src, const std::string& dst, bool subfolders, bool mirror, std::set<std::string>* files);
 
 /**
  *  The paths manager is responsible for recording the various paths
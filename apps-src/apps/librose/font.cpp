@@ -252,6 +252,10 @@ static TTF_Font* get_font(font_id id)
 	return font;
 }
 
+namespace font {
+static void clear_layout_cache();
+}
+
 static void clear_fonts()
 {
 	for(std::map<font_id,TTF_Font*>::iterator i = font_table.begin(); i != font_table.end(); ++i) {
@@ -262,6 +266,7 @@ static void clear_fonts()
 	font_names.clear();
 	char_blocks.cbmap.clear();
 	line_size_cache.clear();
+	font::clear_layout_cache();
 }
 
 struct font_style_setter
@@ -582,6 +587,94 @@ text_surface &text_cache::find(text_surface const &t)
 	return cache_.front();
 }
 
+// laid-out rich text, shared by get_rendered_text_size and get_rendered_text2.
+// measure keeps size only, render keeps layout with rasterized items.
+class layout_cache
+{
+public:
+	struct tlayout
+	{
+		tlayout(const std::string& text, int maximum_width, int font_size, const SDL_Color& color, bool editable);
+
+		bool operator==(const tlayout& that) const {
+			return hash == that.hash && maximum_width == that.maximum_width && font_size == that.font_size
+				&& color == that.color && editable == that.editable && hdpi_scale == that.hdpi_scale && text == that.text;
+		}
+
+		int hash;
+		std::string text;
+		int maximum_width;
+		int font_size;
+		SDL_Color color;
+		bool editable;
+		int hdpi_scale;
+
+		bool measured;
+		tpoint size;
+		std::shared_ptr<tintegrate> integrate;
+	};
+
+	static tlayout& find(const std::string& text, int maximum_width, int font_size, const SDL_Color& color, bool editable);
+	static void resize(unsigned int size);
+	static void clear() { cache_.clear(); }
+
+private:
+	typedef std::list<tlayout> layout_list;
+	static layout_list cache_;
+	static unsigned int max_size_;
+};
+
+layout_cache::layout_list layout_cache::cache_;
+unsigned int layout_cache::max_size_ = 50;
+
+layout_cache::tlayout::tlayout(const std::string& text, int maximum_width, int font_size, const SDL_Color& color, bool editable)
+	: hash(0)
+	, text(text)
+	, maximum_width(maximum_width)
+	, font_size(font_size)
+	, color(color)
+	, editable(editable)
+	, hdpi_scale(gui2::twidget::hdpi_scale)
+	, measured(false)
+	, size(0, 0)
+	, integrate()
+{
+	for (std::string::const_iterator it = text.begin(), it_end = text.end(); it != it_end; ++it) {
+		hash = ((hash << 9) | (hash >> (sizeof(int) * 8 - 9))) ^ (*it);
+	}
+}
+
+layout_cache::tlayout& layout_cache::find(const std::string& text, int maximum_width, int font_size, const SDL_Color& color, bool editable)
+{
+	const tlayout t(text, maximum_width, font_size, color, editable);
+
+	layout_list::iterator it_bgn = cache_.begin(), it_end = cache_.end();
+	layout_list::iterator it = std::find(it_bgn, it_end, t);
+	if (it != it_end) {
+		cache_.splice(it_bgn, cache_, it);
+	} else {
+		if (cache_.size() >= max_size_) {
+			cache_.pop_back();
+		}
+		cache_.push_front(t);
+	}
+
+	return cache_.front();
+}
+
+void layout_cache::resize(unsigned int size)
+{
+	while (size < cache_.size()) {
+		cache_.pop_back();
+	}
+	max_size_ = size;
+}
+
+static void clear_layout_cache()
+{
+	layout_cache::clear();
+}
+
 surface get_rendered_text2(const std::string& text, int maximum_width, int font_size, const SDL_Color& color, bool editable)
 {
 	if (text.empty()) {
@@ -589,8 +682,21 @@ surface get_rendered_text2(const std::string& text, int maximum_width, int font_
 	}
 	try {
 		if (maximum_width <= 0) maximum_width = gui2::settings::screen_width;
-		tintegrate integrate(text, maximum_width, -1, font_size, color, editable);
-		return integrate.get_surface();
+		layout_cache::tlayout& layout = layout_cache::find(text, maximum_width, font_size, color, editable);
+		if (layout.integrate) {
+			return layout.integrate->get_surface();
+		}
+
+		std::shared_ptr<tintegrate> integrate(new tintegrate(text, maximum_width, -1, font_size, color, editable));
+		SDL_Rect rc = integrate->get_size();
+		layout.measured = true;
+		layout.size = tpoint(rc.w, rc.h);
+		if (integrate->exist_anim()) {
+			// anim lives as long as tintegrate, don't keep it.
+			return integrate->get_surface();
+		}
+		layout.integrate = integrate;
+		return integrate->get_surface();
 	}
 	catch (utils::invalid_utf8_exception&) {
 		// Invalid UTF-8 string
@@ -604,12 +710,17 @@ tpoint get_rendered_text_size(const std::string& text, int maximum_width, int fo
 		return tpoint(0, 0);
 	}
 	try {
-		tintegrate integrate(text, maximum_width, -1, font_size, color, editable);
-		SDL_Rect rc = integrate.get_size();
+		layout_cache::tlayout& layout = layout_cache::find(text, maximum_width, font_size, color, editable);
+		if (!layout.measured) {
+			tintegrate integrate(text, maximum_width, -1, font_size, color, editable, true);
+			SDL_Rect rc = integrate.get_size();
+			layout.measured = true;
+			layout.size = tpoint(rc.w, rc.h);
+		}
 
-		VALIDATE(rc.w <= maximum_width, null_str);
+		VALIDATE(layout.size.x <= maximum_width, null_str);
 
-		return tpoint(rc.w, rc.h);
+		return layout.size;
 	}
 	catch (utils::invalid_utf8_exception&) {
 		// Invalid UTF-8 string
@@ -677,6 +788,27 @@ surface get_rendered_text(const std::string& text, int font_size, const SDL_Colo
 	}
 }
 
+SDL_Rect get_rendered_text_rect(const std::string& text, int font_size, int style)
+{
+	if (!font_size || text.empty()) {
+		return empty_rect;
+	}
+	VALIDATE(!strchr(text.c_str(), '\n'), null_str);
+
+	try {
+		// text_surface sizes chunks by TTF_SizeUTF8, same as surface that is rendered.
+		SDL_Rect ret = line_size(text, font_size, style);
+		if (ret.w > (int)max_text_line_width) {
+			return empty_rect;
+		}
+		return ret;
+	}
+	catch (utils::invalid_utf8_exception&) {
+		// Invalid UTF-8 string
+		return empty_rect;
+	}
+}
+
 int get_max_height(int size)
 {
 	// Only returns the maximal size of the first font
@@ -1103,7 +1235,8 @@ bool load_font_config()
 {
 	//read font config separately, so we do not have to re-read the whole
 	//config when changing languages
-	config cfg;
+	tconfig_arena arena;
+	config cfg(arena);
 	try {
 		scoped_istream stream = preprocess_file(get_wml_location("hardwired/fonts.cfg"));
 		read(cfg, *stream);
@@ -1145,8 +1278,10 @@ void cache_mode(CACHE mode)
 {
 	if(mode == CACHE_LOBBY) {
 		text_cache::resize(1000);
+		layout_cache::resize(200);
 	} else {
 		text_cache::resize(50);
+		layout_cache::resize(50);
 	}
 }
 
@@ -273,6 +273,47 @@ inline bool find(E event, F functor)
 
 namespace implementation {
 
+typedef std::vector<std::pair<twidget*, tevent> > tevent_chain;
+
+/**
+ * Borrows an event chain buffer that keeps its capacity between events.
+ *
+ * Handlers may fire events themselves, so every nested fire_event borrows
+ * its own buffer from the pool, returned when the scope ends.
+ */
+class tevent_chain_lock
+{
+public:
+	tevent_chain_lock()
+		: chain_(NULL)
+	{
+		std::vector<tevent_chain*>& free_chains = pool();
+		if (free_chains.empty()) {
+			chain_ = new tevent_chain;
+		} else {
+			chain_ = free_chains.back();
+			free_chains.pop_back();
+		}
+	}
+
+	~tevent_chain_lock()
+	{
+		chain_->clear();
+		pool().push_back(chain_);
+	}
+
+	tevent_chain& chain() { return *chain_; }
+
+private:
+	static std::vector<tevent_chain*>& pool()
+	{
+		static std::vector<tevent_chain*> free_chains;
+		return free_chains;
+	}
+
+	tevent_chain* chain_;
+};
+
 /*
  * Small sample to illustrate the effects of the various build_event_chain
  * functions. Assume the widgets are in an window with the following widgets:
@@ -313,8 +354,7 @@ namespace implementation {
  * @param dispatcher              The final widget to test, this is also the
  *                                dispatcher the sends the event.
  * @param widget                  The widget should parent(s) to check.
- *
- * @returns                       The list of widgets with a handler.
+ * @param result                  Filled with the list of widgets with a handler.
  *                                The order will be (assuming all have a
  *                                handler):
  *                                * container 2
@@ -322,16 +362,15 @@ namespace implementation {
  *                                * dispatcher
  */
 template<class T>
-inline std::vector<std::pair<twidget*, tevent> > build_event_chain(
+inline void build_event_chain(
 		  const tevent event
 		, twidget* dispatcher
-		, twidget* widget)
+		, twidget* widget
+		, tevent_chain& result)
 {
 	VALIDATE(dispatcher, null_str);
 	VALIDATE(widget, null_str);
 
-	std::vector<std::pair<twidget*, tevent> > result;
-
 	while(widget != dispatcher) {
 		widget = widget->parent();
 		VALIDATE(widget, null_str);
@@ -342,25 +381,22 @@ inline std::vector<std::pair<twidget*, tevent> > build_event_chain(
 			result.push_back(std::make_pair(widget, event));
 		}
 	}
-
-	return result;
 }
 
 /**
  * Build the event chain for tsignal_notification_function.
  *
- * The notification is only send to the receiver it returns an empty chain.
+ * The notification is only send to the receiver it leaves the chain empty.
  * Since the pre and post queues are unused, it validates whether they are
  * empty (using asserts).
- *
- * @returns                       An empty vector.
  */
 template<>
-inline std::vector<std::pair<twidget*, tevent> >
+inline void
 build_event_chain<tsignal_notification_function>(
 		  const tevent event
 		, twidget* dispatcher
-		, twidget* widget)
+		, twidget* widget
+		, tevent_chain& /*result*/)
 {
 	assert(dispatcher);
 	assert(widget);
@@ -370,8 +406,6 @@ build_event_chain<tsignal_notification_function>(
 			, tdispatcher::tevent_type(
 					  tdispatcher::pre
 					| tdispatcher::post)));
-
-	return std::vector<std::pair<twidget*, tevent> >();
 }
 
 #ifdef _MSC_VER
@@ -388,7 +422,7 @@ build_event_chain<tsignal_notification_function>(
  *
  * @pre                           dispatcher == widget
  *
- * @returns                       The list of widgets with a handler.
+ * @param result                  Filled with the list of widgets with a handler.
  *                                The order will be (assuming all have a
  *                                handler):
  *                                * window
@@ -396,18 +430,17 @@ build_event_chain<tsignal_notification_function>(
  *                                * container 2
  */
 template<>
-inline std::vector<std::pair<twidget*, tevent> >
+inline void
 build_event_chain<tsignal_message_function>(
 		  const tevent event
 		, twidget* dispatcher
-		, twidget* widget)
+		, twidget* widget
+		, tevent_chain& result)
 {
 	assert(dispatcher);
 	assert(widget);
 	assert(widget == dispatcher);
 
-	std::vector<std::pair<twidget*, tevent> > result;
-
 	/* We only should add the parents of the widget to the chain. */
 	while((widget = widget->parent())) {
 		assert(widget);
@@ -418,8 +451,6 @@ build_event_chain<tsignal_message_function>(
 			result.insert(result.begin(), std::make_pair(widget, event));
 		}
 	}
-
-	return result;
 }
 #ifdef _MSC_VER
 #pragma warning (pop)
@@ -553,8 +584,9 @@ inline bool fire_event(const tevent event
 	assert(dispatcher);
 	assert(widget);
 
-	std::vector<std::pair<twidget*, tevent> > event_chain =
-			implementation::build_event_chain<T>(event, dispatcher, widget);
+	implementation::tevent_chain_lock lock;
+	implementation::tevent_chain& event_chain = lock.chain();
+	implementation::build_event_chain<T>(event, dispatcher, widget, event_chain);
 
 	return implementation::fire_event<T>(event
 			, event_chain
@@ -578,7 +610,8 @@ inline bool fire_event_double_click(
 	assert(dispatcher);
 	assert(widget);
 
-	std::vector<std::pair<twidget*, tevent> > event_chain;
+	implementation::tevent_chain_lock lock;
+	implementation::tevent_chain& event_chain = lock.chain();
 	twidget* w = widget;
 	while(w!= dispatcher) {
 		w = w->parent();
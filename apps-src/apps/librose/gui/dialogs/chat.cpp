@@ -58,7 +58,6 @@
 #include "webrtc/base/logging.h"
 #include "webrtc/media/engine/webrtcvideocapturerfactory.h"
 #include "webrtc/modules/video_capture/video_capture_factory.h"
-#include "libyuv/convert_argb.h"
 #include "webrtc/base/stringutils.h"
 
 #if defined(__APPLE__) && TARGET_OS_IPHONE
@@ -387,10 +386,10 @@ tchat_::tchat_(display& disp, int chat_page)
 	, resolver_(NULL)
 	, state_(NOT_CONNECTED)
 	, my_id_(-1)
-	, remote_pixels_(NULL)
 	, remote_size_(-1, -1)
-	, local_pixels_(NULL)
 	, local_size_(-1, -1)
+	, remote_angle_(0)
+	, local_angle_(0)
 	, local_render_size_(capture_size)
 	, original_local_offset_(0, 0)
 	, current_local_offset_(0, 0)
@@ -438,14 +437,12 @@ void tchat_::pre_create_renderer()
 		threading::lock lock(remote_mutex_);
 		remote_tex_ = NULL;
 		remote_size_ = tpoint(twidget::npos, twidget::npos);
-		remote_pixels_ = NULL;
 	}
 
 	if (local_tex_.get() != NULL) {
 		threading::lock lock(local_mutex_);
 		local_tex_ = NULL;
 		local_size_ = tpoint(twidget::npos, twidget::npos);
-		local_pixels_ = NULL;
 	}
 }
 
@@ -1525,7 +1522,6 @@ void tchat_::set_renderer_texture_size(bool remote, int width, int height)
 {
 	texture& tex = remote? remote_tex_: local_tex_;
 	tpoint& size = remote? remote_size_: local_size_;
-	uint8_t** pixels = remote? &remote_pixels_: &local_pixels_;
 
 	if (width == size.x && height == size.y) {
 		return;
@@ -1537,10 +1533,47 @@ void tchat_::set_renderer_texture_size(bool remote, int width, int height)
 		tex.reset(NULL);
 	}
 	if (tex.get() == NULL) {
-		tex = SDL_CreateTexture(get_renderer(), get_screen_format().format, SDL_TEXTUREACCESS_STREAMING, width, height);
+		tex = SDL_CreateTexture(get_renderer(), SDL_PIXELFORMAT_IYUV, SDL_TEXTUREACCESS_STREAMING, width, height);
+	}
+}
+
+void tchat_::upload_frame(VideoRenderer& renderer, bool remote)
+{
+	webrtc::VideoRotation rotation = webrtc::kVideoRotation_0;
+	rtc::scoped_refptr<webrtc::VideoFrameBuffer> buffer = renderer.take_frame(rotation);
+	if (!buffer) {
+		return;
+	}
+
+	// out of lock, webrtc thread can deliver next frame while uploading this.
+	set_renderer_texture_size(remote, buffer->width(), buffer->height());
+	texture& tex = remote? remote_tex_: local_tex_;
+	SDL_UpdateYUVTexture(tex.get(), NULL, buffer->DataY(), buffer->StrideY(),
+		buffer->DataU(), buffer->StrideU(),
+		buffer->DataV(), buffer->StrideV());
+
+	int angle = rotation;
+	const int rotated_width = angle == 90 || angle == 270? buffer->height(): buffer->width();
+	if (rotated_width != capture_size.x) {
+		angle += 90;
+	}
+	(remote? remote_angle_: local_angle_) = angle % 360;
+}
+
+void tchat_::render_frame(SDL_Renderer* renderer, bool remote, const SDL_Rect& dst) const
+{
+	SDL_Texture* tex = remote? remote_tex_.get(): local_tex_.get();
+	const int angle = remote? remote_angle_: local_angle_;
+
+	if (angle == 0) {
+		SDL_RenderCopy(renderer, tex, NULL, &dst);
+	} else if (angle == 180) {
+		SDL_RenderCopyEx(renderer, tex, NULL, &dst, angle, NULL, SDL_FLIP_NONE);
+	} else {
+		// texture is rotated around center, so pre-rotated rect is width/height swapped.
+		SDL_Rect rect = ::create_rect(dst.x + (dst.w - dst.h) / 2, dst.y + (dst.h - dst.w) / 2, dst.h, dst.w);
+		SDL_RenderCopyEx(renderer, tex, NULL, &rect, angle, NULL, SDL_FLIP_NONE);
 	}
-	int pitch = 0;
-	SDL_LockTexture(tex.get(), NULL, (void**)pixels, &pitch);
 }
 
 void tchat_::did_draw_vrenderer(ttrack& widget, const SDL_Rect& widget_rect, const bool bg_drawn, bool force)
@@ -1568,12 +1601,11 @@ void tchat_::did_draw_vrenderer(ttrack& widget, const SDL_Rect& widget_rect, con
 	bool require_render_remote = remote_renderer != NULL && (remote_renderer->dirty() || require_render_local || force);
 
 	if (require_render_remote) {
-		threading::lock lock(remote_mutex_);
 		if (remote_renderer->dirty()) {
-			SDL_UnlockTexture(remote_tex_.get());
+			upload_frame(*remote_renderer, true);
 		}
 
-		SDL_RenderCopy(renderer, remote_tex_.get(), NULL, &widget_rect);
+		render_frame(renderer, true, widget_rect);
 
 		text_surf = font::get_rendered_text2(_("Remote video"), -1, 48, font::BAD_COLOR);
 		dst = ::create_rect(widget_rect.x, widget_rect.y, text_surf->w, text_surf->h);
@@ -1584,9 +1616,8 @@ void tchat_::did_draw_vrenderer(ttrack& widget, const SDL_Rect& widget_rect, con
 		render_surface(renderer, surf, NULL, &dst);
 	}
 	if (require_render_local) {
-		threading::lock lock(local_mutex_);
 		if (local_renderer->dirty()) {
-			SDL_UnlockTexture(local_tex_.get());
+			upload_frame(*local_renderer, false);
 		}
 
 		if (local_render_size_.x * 2 > widget_rect.w) {
@@ -1598,7 +1629,7 @@ void tchat_::did_draw_vrenderer(ttrack& widget, const SDL_Rect& widget_rect, con
 		dst.x = widget_rect.x + original_local_offset_.x + current_local_offset_.x;
 		dst.y = widget_rect.y + original_local_offset_.y + current_local_offset_.y;
 
-		SDL_RenderCopy(renderer, local_tex_.get(), NULL, &dst);
+		render_frame(renderer, false, dst);
 
 		text_surf = font::get_rendered_text2(_("Local video"), -1, 36, font::GOOD_COLOR);
 		dst.w = text_surf->w;
@@ -3298,15 +3329,48 @@ void tchat_::resize_send_data(int size)
 	}
 }
 
+tframe_handoff::tframe_handoff()
+	: mutex_()
+	, front_(0)
+	, fresh_(false)
+{
+	rotations_[0] = rotations_[1] = webrtc::kVideoRotation_0;
+}
+
+void tframe_handoff::put(const rtc::scoped_refptr<webrtc::VideoFrameBuffer>& buffer, webrtc::VideoRotation rotation)
+{
+	// UI thread only reads buffers_[front_], and front_ is changed by this thread only.
+	const int back = 1 - front_;
+	buffers_[back] = buffer;
+	rotations_[back] = rotation;
+
+	threading::lock lock(mutex_);
+	front_ = back;
+	fresh_ = true;
+}
+
+rtc::scoped_refptr<webrtc::VideoFrameBuffer> tframe_handoff::take(webrtc::VideoRotation& rotation)
+{
+	threading::lock lock(mutex_);
+	if (!fresh_) {
+		return NULL;
+	}
+	rtc::scoped_refptr<webrtc::VideoFrameBuffer> buffer = buffers_[front_];
+	rotation = rotations_[front_];
+	buffers_[front_] = NULL;
+	fresh_ = false;
+	return buffer;
+}
+
 tchat_::VideoRenderer::VideoRenderer(tchat_* chat, int width, int height, webrtc::VideoTrackInterface* track_to_render, bool remote)
 	: chat_(chat)
 	, rendered_track_(track_to_render)
 	, remote_(remote)
-	, dirty_(false)
-	, bytesperpixel_(4)
+	, frames_()
 {
 	rtc::VideoSinkWants wants;
-	wants.rotation_applied = true;
+	// rotate when render, avoid copy frame on webrtc thread.
+	wants.rotation_applied = false;
 	rendered_track_->AddOrUpdateSink(this, wants);
 }
 
@@ -3317,39 +3381,14 @@ tchat_::VideoRenderer::~VideoRenderer()
 
 void tchat_::VideoRenderer::OnFrame(const webrtc::VideoFrame& video_frame)
 {
-	{
-		threading::mutex& mutex(chat_->get_mutex(remote_));
-		threading::lock lock2(mutex);
-
-		// const webrtc::VideoFrame frame(webrtc::I420Buffer::Rotate(video_frame.video_frame_buffer(), video_frame.rotation()),
-		//	webrtc::kVideoRotation_0, video_frame.timestamp_us());
-		rtc::scoped_refptr<webrtc::VideoFrameBuffer> buffer;
-		if (video_frame.video_frame_buffer()->native_handle()) {
-			buffer = video_frame.video_frame_buffer()->NativeToI420Buffer();
-		} else {
-			buffer = video_frame.video_frame_buffer();
-		}
-		if (video_frame.rotation() != webrtc::kVideoRotation_0) {
-			buffer = webrtc::I420Buffer::Rotate(buffer, video_frame.rotation());
-		}	
-		if (buffer->width() != capture_size.x) {
-			buffer = webrtc::I420Buffer::Rotate(buffer, webrtc::kVideoRotation_90);
-		}
-
-		uint8_t* pixels = chat_->pixels(remote_);
-		if (pixels == NULL) {
-			// maybe in change orientation.
-			return;
-		}
-		int pitch = buffer->width() * bytesperpixel_;
-		libyuv::I420ToARGB(buffer->DataY(), buffer->StrideY(),
-            buffer->DataU(), buffer->StrideU(),
-            buffer->DataV(), buffer->StrideV(),
-            pixels,
-			pitch,
-            buffer->width(), buffer->height());
+	rtc::scoped_refptr<webrtc::VideoFrameBuffer> buffer;
+	if (video_frame.video_frame_buffer()->native_handle()) {
+		buffer = video_frame.video_frame_buffer()->NativeToI420Buffer();
+	} else {
+		buffer = video_frame.video_frame_buffer();
 	}
-	dirty_ = true;
+
+	frames_.put(buffer, video_frame.rotation());
 }
 
 tchat2::tchat2(display& disp)
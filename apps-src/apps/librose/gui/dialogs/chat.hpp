@@ -51,6 +51,29 @@ class tstack;
 class tgrid;
 class ttrack;
 
+// double-buffered hand over of decoded frames from webrtc thread to UI thread.
+// webrtc thread fills back slot without lock, lock is held only to flip slots,
+// so neither thread waits for conversion or upload of the other.
+class tframe_handoff
+{
+public:
+	tframe_handoff();
+
+	// webrtc thread. if UI thread hasn't taken previous frame, it is dropped.
+	void put(const rtc::scoped_refptr<webrtc::VideoFrameBuffer>& buffer, webrtc::VideoRotation rotation);
+	// UI thread. frame that arrived since last take, NULL if none.
+	rtc::scoped_refptr<webrtc::VideoFrameBuffer> take(webrtc::VideoRotation& rotation);
+	bool fresh() const { return fresh_; }
+
+private:
+	threading::mutex mutex_;
+	rtc::scoped_refptr<webrtc::VideoFrameBuffer> buffers_[2];
+	webrtc::VideoRotation rotations_[2];
+	// slot UI thread takes from, other one is back slot. only put changes it.
+	int front_;
+	volatile bool fresh_;
+};
+
 class tchat_: public tdialog, public tlobby::thandler, public webrtc::PeerConnectionObserver, public webrtc::CreateSessionDescriptionObserver, public sigslot::has_slots<>, public rtc::MessageHandler
 {
 public:
@@ -126,7 +149,6 @@ public:
 	void did_control_drag_detect(ttrack& widget, const tpoint& first, const tpoint& last);
 	void did_drag_coordinate(ttrack& widget, const tpoint& first, const tpoint& last);
 	ttrack* vrenderer_track() const { return vrenderer_track_; }
-	uint8_t* pixels(bool remote) const { return remote? remote_pixels_: local_pixels_; }
 
 protected:
 	/** Inherited from tdialog. */
@@ -297,6 +319,9 @@ private:
 
 	threading::mutex& get_mutex(bool remote) { return remote? remote_mutex_: local_mutex_; }
 	void set_renderer_texture_size(bool remote, int width, int height);
+	class VideoRenderer;
+	void upload_frame(VideoRenderer& renderer, bool remote);
+	void render_frame(SDL_Renderer* renderer, bool remote, const SDL_Rect& dst) const;
 	
 	int AddRef() const override;
 	int Release() const override;
@@ -409,7 +434,9 @@ private:
 		// VideoSinkInterface implementation
 		void OnFrame(const webrtc::VideoFrame& frame) override;
 
-		bool dirty() const { return dirty_; }
+		bool dirty() const { return frames_.fresh(); }
+		// called by UI thread. frame that arrived since last take, NULL if none.
+		rtc::scoped_refptr<webrtc::VideoFrameBuffer> take_frame(webrtc::VideoRotation& rotation) { return frames_.take(rotation); }
 
 	protected:
 
@@ -419,10 +446,11 @@ private:
 		};
 
 		tchat_* chat_;
-		int bytesperpixel_;
 		rtc::scoped_refptr<webrtc::VideoTrackInterface> rendered_track_;
 		bool remote_;
-		bool dirty_;
+
+		// webrtc thread only hands over a reference of latest frame, UI thread uploads it.
+		tframe_handoff frames_;
 	};
 	std::unique_ptr<VideoRenderer> local_renderer_;
 	std::unique_ptr<VideoRenderer> remote_renderer_;
@@ -439,12 +467,13 @@ private:
 	tpoint original_local_offset_;
 	tpoint current_local_offset_;
 
+	// I420 planes are uploaded as is, rotation is done when render.
 	texture remote_tex_;
 	texture local_tex_;
 	tpoint remote_size_;
 	tpoint local_size_;
-	uint8_t* remote_pixels_;
-	uint8_t* local_pixels_;
+	int remote_angle_;
+	int local_angle_;
 
 	mutable volatile int ref_count_;
 
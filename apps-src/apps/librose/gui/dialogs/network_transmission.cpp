@@ -90,9 +90,9 @@ void tnetwork_transmission::set_percent(const int percent)
 			   << "/"
 			   << utils::si_string(total, true, _("unit_byte^B"));
 
-			find_widget<tlabel>(window_, "_numeric_progress", false)
-					.set_label(ss.str());
-			window_->invalidate_layout();
+			tlabel& label = find_widget<tlabel>(window_, "_numeric_progress", false);
+			label.set_label(ss.str());
+			window_->invalidate_layout(label);
 		}
 	}
 }
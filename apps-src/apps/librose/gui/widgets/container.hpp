@@ -50,6 +50,9 @@ public:
 	/** Inherited from tcontrol. */
 	void layout_init();
 
+	/** Inherited from tcontrol. */
+	void clear_subtree_best_size() override { grid_->clear_subtree_best_size(); }
+
 	virtual const tgrid& layout_grid() const { return *grid_; }
 
 protected:
@@ -103,6 +106,12 @@ public:
 		return grid_->find_at(coordinate, must_be_active); 
 	}
 
+	/** Inherited from twidget. */
+	SDL_Rect hit_rect() const override
+	{
+		return union_rects(get_rect(), grid_->hit_rect());
+	}
+
 	/** Inherited from tcontrol.*/
 	twidget* find(const std::string& id, const bool must_be_active)
 	{
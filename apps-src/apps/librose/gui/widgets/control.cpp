@@ -382,12 +382,14 @@ void tcontrol::set_definition(const std::string& definition)
 void tcontrol::clear_label_size_cache()
 {
 	label_size_.second.x = 0;
+	invalidate_best_size();
 }
 
 void tcontrol::set_best_size(const std::string& width, const std::string& height)
 {
 	best_width_ = tformula<unsigned>(width);
 	best_height_ = tformula<unsigned>(height);
+	invalidate_best_size();
 }
 
 void tcontrol::set_label(const std::string& label)
@@ -398,6 +400,7 @@ void tcontrol::set_label(const std::string& label)
 
 	label_ = label;
 	label_size_.second.x = 0;
+	invalidate_best_size();
 	update_canvas();
 	set_dirty();
 
@@ -411,6 +414,7 @@ void tcontrol::set_text_editable(bool editable)
 	}
 
 	text_editable_ = editable;
+	invalidate_best_size();
 	update_canvas();
 	set_dirty();
 }
@@ -440,8 +444,9 @@ int tcontrol::get_text_maximum_height() const
 
 void tcontrol::set_text_maximum_width(int maximum)
 {
-	if (restrict_width_) {
+	if (restrict_width_ && text_maximum_width_ != maximum - (int)config_->text_extra_width) {
 		text_maximum_width_ = maximum - config_->text_extra_width;
+		invalidate_best_size();
 	}
 }
 
@@ -33,6 +33,11 @@ tgrid::tgrid(const unsigned rows, const unsigned cols)
 	, cols_(cols)
 	, row_height_()
 	, col_width_()
+	, memorize_best_size_(true)
+	, best_size_pass_(0)
+	, best_size_(0, 0)
+	, best_row_height_()
+	, best_col_width_()
 	, row_grow_factor_(rows)
 	, col_grow_factor_(cols)
 	, children_(NULL)
@@ -40,6 +45,20 @@ tgrid::tgrid(const unsigned rows, const unsigned cols)
 	, children_vsize_(rows * cols)
 	, stuff_widget_()
 	, valid_stuff_size_(0)
+	, geometry_stamp_(0)
+	, translating_(false)
+	, index_stamp_(0)
+	, index_hits_(0)
+	, index_children_(NULL)
+	, index_vsize_(0)
+	, index_origin_(0, 0)
+	, index_bound_(empty_rect)
+	, index_bucket_w_(0)
+	, index_bucket_h_(0)
+	, index_cols_(0)
+	, index_bucket_start_()
+	, index_items_()
+	, index_widgets_()
 {
 	if (children_size_) {
 		children_ = (tchild*)malloc(children_size_ * sizeof(tchild));
@@ -112,6 +131,7 @@ void tgrid::set_child(twidget* widget, const unsigned row,
 		// make sure the new child is valid before deferring
 		cell.widget_->set_parent(this);
 	}
+	invalidate_best_size();
 }
 
 twidget* tgrid::swap_child(
@@ -145,6 +165,7 @@ twidget* tgrid::swap_child(
 
 		widget->set_parent(this);
 		child.widget_ = widget;
+		invalidate_best_size();
 
 		return old;
 	}
@@ -162,6 +183,7 @@ void tgrid::remove_child(const unsigned row, const unsigned col)
 		delete cell.widget_;
 	}
 	cell.widget_ = NULL;
+	invalidate_best_size();
 }
 
 void tgrid::remove_child(const std::string& id, const bool find_all)
@@ -172,6 +194,7 @@ void tgrid::remove_child(const std::string& id, const bool find_all)
 		if (child.widget_->id() == id) {
 			delete child.widget_;
 			child.widget_ = NULL;
+			invalidate_best_size();
 
 			if (!find_all) {
 				break;
@@ -230,6 +253,7 @@ void tgrid::layout_init()
 {
 	// Inherited.
 	twidget::layout_init();
+	best_size_pass_ = 0;
 
 	// Clear child caches.
 	for (int n = 0; n < children_vsize_; n ++) {
@@ -241,8 +265,29 @@ void tgrid::layout_init()
 	}
 }
 
+void tgrid::clear_subtree_best_size()
+{
+	best_size_pass_ = 0;
+	for (int n = 0; n < children_vsize_; n ++) {
+		children_[n].widget_->clear_subtree_best_size();
+	}
+}
+
 tpoint tgrid::calculate_best_size() const
 {
+	if (best_size_pass_ == layout_pass) {
+		// no child changed since last calculate in this layout pass.
+#ifdef _DEBUG
+		// if differ, some change of best size doesn't call invalidate_best_size.
+		const tpoint memorized = best_size_;
+		best_size_pass_ = 0;
+		VALIDATE(calculate_best_size() == memorized, "memorized best size of grid is stale!");
+#endif
+		row_height_ = best_row_height_;
+		col_width_ = best_col_width_;
+		return best_size_;
+	}
+
 	// Reset the cached values.
 	row_height_.clear();
 	row_height_.resize(rows_, 0);
@@ -269,6 +314,13 @@ tpoint tgrid::calculate_best_size() const
 		std::accumulate(col_width_.begin(), col_width_.end(), 0),
 		std::accumulate(row_height_.begin(), row_height_.end(), 0));
 
+	if (memorize_best_size_) {
+		best_size_ = result;
+		best_row_height_ = row_height_;
+		best_col_width_ = col_width_;
+		best_size_pass_ = layout_pass;
+	}
+
 	return result;
 }
 
@@ -477,6 +529,7 @@ void tgrid::set_origin(const tpoint& origin)
 	// Inherited.
 	twidget::set_origin(origin);
 
+	begin_translate();
 	for (int n = 0; n < children_vsize_; n ++) {
 		tchild& child = children_[n];
 
@@ -487,6 +540,27 @@ void tgrid::set_origin(const tpoint& origin)
 				widget->get_x() + movement.x,
 				widget->get_y() + movement.y));
 	}
+	end_translate(movement);
+}
+
+void tgrid::end_translate(const tpoint& movement)
+{
+	translating_ = false;
+	index_origin_.x += movement.x;
+	index_origin_.y += movement.y;
+}
+
+void tgrid::child_geometry_changed(twidget& child, const SDL_Rect& rect)
+{
+	if (translating_) {
+		return;
+	}
+	geometry_stamp_ ++;
+
+	// outside of this grid, hit_rect of this grid changes too.
+	if (rect.w > 0 && rect.h > 0 && (rect.x < x_ || rect.y < y_ || rect.x + rect.w > x_ + (int)w_ || rect.y + rect.h > y_ + (int)h_)) {
+		twidget::child_geometry_changed(child, rect);
+	}
 }
 
 void tgrid::set_visible_area(const SDL_Rect& area)
@@ -525,12 +599,146 @@ void tgrid::child_populate_dirty_list(twindow& caller, const std::vector<twidget
 	}
 }
 
+bool tgrid::index_valid() const
+{
+	return index_stamp_ == geometry_stamp_ && index_children_ == children_ && index_vsize_ == children_vsize_ && index_cols_;
+}
+
+bool tgrid::build_index()
+{
+	index_cols_ = 0;
+	index_origin_ = tpoint(x_, y_);
+	index_bound_ = empty_rect;
+	std::vector<SDL_Rect> rects(children_vsize_);
+	for (int n = 0; n < children_vsize_; n ++) {
+		SDL_Rect& rect = rects[n] = children_[n].widget_->hit_rect();
+		rect.x -= x_;
+		rect.y -= y_;
+		if (rect.w > 0 && rect.h > 0) {
+			index_bound_ = union_rects(index_bound_, rect);
+		}
+	}
+	if (!index_bound_.w) {
+		return false;
+	}
+
+	// about one child every bucket, bucket cols/rows follow the aspect of bound.
+	const double per_bucket = 1.0 * index_bound_.w * index_bound_.h / children_vsize_;
+	const int side = std::max(1, (int)sqrt(per_bucket));
+	index_bucket_w_ = std::max(side, index_bound_.w / children_vsize_);
+	index_bucket_h_ = std::max(side, index_bound_.h / children_vsize_);
+	const int cols = (index_bound_.w + index_bucket_w_ - 1) / index_bucket_w_;
+	const int rows = (index_bound_.h + index_bucket_h_ - 1) / index_bucket_h_;
+
+	// counting pass, then fill. a child overlapping many buckets is in each of them.
+	index_bucket_start_.assign(cols * rows + 1, 0);
+	for (int pass = 0; pass < 2; pass ++) {
+		std::vector<int> fill;
+		if (pass) {
+			for (int at = 1; at <= cols * rows; at ++) {
+				index_bucket_start_[at] += index_bucket_start_[at - 1];
+			}
+			index_items_.resize(index_bucket_start_[cols * rows]);
+			fill.assign(index_bucket_start_.begin(), index_bucket_start_.end() - 1);
+		}
+		for (int n = 0; n < children_vsize_; n ++) {
+			const twidget& widget = *children_[n].widget_;
+			const SDL_Rect& rect = rects[n];
+			// visible child without hit area, keep linear scan's behavior by checking it in every bucket.
+			int col0 = 0, col1 = cols - 1, row0 = 0, row1 = rows - 1;
+			if (rect.w > 0 && rect.h > 0) {
+				col0 = (rect.x - index_bound_.x) / index_bucket_w_;
+				col1 = (rect.x + rect.w - 1 - index_bound_.x) / index_bucket_w_;
+				row0 = (rect.y - index_bound_.y) / index_bucket_h_;
+				row1 = (rect.y + rect.h - 1 - index_bound_.y) / index_bucket_h_;
+			} else if (widget.get_visible() != VISIBLE) {
+				continue;
+			}
+			for (int row = row0; row <= row1; row ++) {
+				for (int col = col0; col <= col1; col ++) {
+					const int at = row * cols + col;
+					if (pass) {
+						index_items_[fill[at] ++] = n;
+					} else {
+						index_bucket_start_[at + 1] ++;
+					}
+				}
+			}
+		}
+	}
+
+	index_widgets_.resize(children_vsize_);
+	for (int n = 0; n < children_vsize_; n ++) {
+		index_widgets_[n] = children_[n].widget_;
+	}
+	index_cols_ = cols;
+	index_stamp_ = geometry_stamp_;
+	index_children_ = children_;
+	index_vsize_ = children_vsize_;
+	return true;
+}
+
+SDL_Rect tgrid::hit_rect() const
+{
+	SDL_Rect result = get_rect();
+	for (int n = 0; n < children_vsize_; n ++) {
+		const twidget& widget = *children_[n].widget_;
+		if (widget.get_visible() == VISIBLE) {
+			result = union_rects(result, widget.hit_rect());
+		}
+	}
+	return result;
+}
+
 twidget* tgrid::find_at(const tpoint& coordinate, const bool must_be_active)
 {
 	if (visible_ != VISIBLE) {
 		return nullptr;
 	}
 
+	if (children_vsize_ >= index_threshold) {
+		if (!index_valid()) {
+			if (index_stamp_ != geometry_stamp_ || index_children_ != children_ || index_vsize_ != children_vsize_) {
+				index_stamp_ = geometry_stamp_;
+				index_children_ = children_;
+				index_vsize_ = children_vsize_;
+				index_cols_ = 0;
+				index_hits_ = 0;
+			}
+			if (++ index_hits_ >= 2) {
+				build_index();
+			}
+		}
+	}
+
+	if (index_valid()) {
+		const int x = coordinate.x - index_origin_.x, y = coordinate.y - index_origin_.y;
+		if (!point_in_rect(x, y, index_bound_)) {
+			return nullptr;
+		}
+		const int at = ((y - index_bound_.y) / index_bucket_h_) * index_cols_ + (x - index_bound_.x) / index_bucket_w_;
+		bool stale = false;
+		for (int i = index_bucket_start_[at]; i < index_bucket_start_[at + 1]; i ++) {
+			const tchild& child = children_[index_items_[i]];
+			if (child.widget_ != index_widgets_[index_items_[i]]) {
+				// child is replaced without changing geometry, fallback to scan.
+				stale = true;
+				break;
+			}
+			if (child.widget_->get_visible() != VISIBLE) {
+				continue;
+			}
+			twidget* widget = child.widget_->find_at(coordinate, must_be_active);
+			if (widget) {
+				return widget;
+			}
+		}
+		if (!stale) {
+			return nullptr;
+		}
+		index_cols_ = 0;
+	}
+
 	for (int n = 0; n < children_vsize_; n ++) {
 		const tchild& child = children_[n];
 
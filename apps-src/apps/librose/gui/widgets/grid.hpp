@@ -184,6 +184,11 @@ public:
 
 	tpoint calculate_best_size_fix() const;
 
+	void clear_best_size() override { best_size_pass_ = 0; }
+
+	/** Inherited from twidget. */
+	void clear_subtree_best_size() override;
+
 	/** Inherited from twidget. */
 	void impl_draw_children(texture& frame_buffer, int x_offset, int y_offset);
 	void broadcast_frame_buffer(texture& frame_buffer);
@@ -216,6 +221,12 @@ public:
 	/** Inherited from twidget. */
 	twidget* find_at(const tpoint& coordinate, const bool must_be_active) override;
 
+	/** Inherited from twidget. */
+	SDL_Rect hit_rect() const override;
+
+	/** Inherited from twidget. */
+	void child_geometry_changed(twidget& child, const SDL_Rect& rect) override;
+
 	/** Inherited from twidget.*/
 	twidget* find(const std::string& id, const bool must_be_active);
 
@@ -301,6 +312,19 @@ protected:
 	/** The column widths in the grid. */
 	mutable std::vector<unsigned> col_width_;
 
+	/**
+	 * Best size memorized in layout pass best_size_pass_.
+	 *
+	 * Sibling subtrees keep it when only one child relayouts, so parents don't
+	 * re-measure whole tree. Derived grid that changes children_ by itself
+	 * should set memorize_best_size_ to false.
+	 */
+	bool memorize_best_size_;
+	mutable unsigned best_size_pass_;
+	mutable tpoint best_size_;
+	mutable std::vector<unsigned> best_row_height_;
+	mutable std::vector<unsigned> best_col_width_;
+
 	/** The grow factor for all rows. */
 	std::vector<unsigned> row_grow_factor_;
 
@@ -321,6 +345,41 @@ protected:
 	int valid_stuff_size_;
 
 	const std::string& get_control_type() const;
+
+	/**
+	 * Children are moved together with this grid by movement, between the two
+	 * calls their geometry_changed() doesn't make hit-test index stale.
+	 */
+	void begin_translate() { translating_ = true; }
+	void end_translate(const tpoint& movement);
+
+	/***** ***** ***** ***** hit-test index ***** ***** ***** *****/
+
+	// below this children count, find_at scans linearly.
+	static const int index_threshold = 32;
+
+	// children in bucket are in ascending order, so find_at returns the same child as linear scan.
+	// a child is put in buckets by its hit_rect, so descendants placed outside its rectangle are found too.
+	bool build_index();
+	bool index_valid() const;
+
+	// increased whenever rectangle or visibility of a child changes, or of a descendant outside this grid.
+	unsigned geometry_stamp_;
+	bool translating_;
+	unsigned index_stamp_;
+	// index is built only when geometry keeps same between two find_at, not during relayout.
+	unsigned index_hits_;
+	tchild* index_children_;
+	int index_vsize_;
+	// rectangles in index are relative to index_origin_, which moves when the whole subtree is translated.
+	tpoint index_origin_;
+	SDL_Rect index_bound_;
+	int index_bucket_w_;
+	int index_bucket_h_;
+	int index_cols_;
+	std::vector<int> index_bucket_start_;
+	std::vector<int> index_items_;
+	std::vector<twidget*> index_widgets_;
 };
 
 /** Returns the best size for the cell. */
@@ -1367,6 +1367,8 @@ void tlistbox::tgrid3::set_origin(const tpoint& origin)
 		return;
 	}
 
+	const tpoint movement(origin.x - get_x(), origin.y - get_y());
+
 	// Inherited.
 	twidget::set_origin(origin);
 
@@ -1374,6 +1376,8 @@ void tlistbox::tgrid3::set_origin(const tpoint& origin)
 		return;
 	}
 
+	// rows keep their distance, so they move together with this grid.
+	begin_translate();
 	for (int n = 0; n < children_vsize_; n ++) {
 		ttoggle_panel* widget = dynamic_cast<ttoggle_panel*>(children_[n].widget_);
 		VALIDATE(widget, null_str);
@@ -1384,6 +1388,7 @@ void tlistbox::tgrid3::set_origin(const tpoint& origin)
 		//    1    ---> origin.y + 1
 		widget->set_origin(tpoint(origin.x, origin.y + distance_value(current_gc_row->distance)));
 	}
+	end_translate(movement);
 
 }
 
@@ -35,7 +35,10 @@ public:
 	public:
 		tgrid3(tlistbox& listbox)
 			: listbox_(listbox)
-		{}
+		{
+			// rows are inserted/erased directly in children_.
+			memorize_best_size_ = false;
+		}
 
 
 		void set_origin(const tpoint& origin) override;	
@@ -1114,6 +1114,7 @@ void treport::tgrid2::replacement_children()
 		}
 		w_ = w;
 		h_ = h;
+		geometry_changed();
 
 	} else {
 		children_[children_vsize_ - 1].flags_ = VERTICAL_GROW_SEND_TO_CLIENT | HORIZONTAL_GROW_SEND_TO_CLIENT;
@@ -1142,6 +1143,8 @@ void treport::tgrid2::replacement_children()
 		}
 	}
 
+	geometry_changed();
+
 	// remember it, speed up get_best_size.
 	set_layout_size(tpoint(w_, h_));
 }
@@ -72,6 +72,12 @@ void tscroll_container::layout_init()
 	content_grid_->layout_init();
 }
 
+void tscroll_container::clear_subtree_best_size()
+{
+	tcontainer_::clear_subtree_best_size();
+	content_grid_->clear_subtree_best_size();
+}
+
 tpoint tscroll_container::scrollbar_size(const tgrid& scrollbar_grid, tscrollbar_mode scrollbar_mode) const
 {
 	if (scrollbar_mode == auto_visible) {
@@ -266,6 +272,14 @@ twidget* tscroll_container::find_at(const tpoint& coordinate, const bool must_be
 	return result;
 }
 
+void tscroll_container::child_geometry_changed(twidget& child, const SDL_Rect& rect)
+{
+	// content_grid_ isn't part of hit_rect, so scrolling it doesn't concern the owner.
+	if (&child != content_grid_) {
+		tcontainer_::child_geometry_changed(child, rect);
+	}
+}
+
 twidget* tscroll_container::find(const std::string& id, const bool must_be_active)
 {
 	// Inherited.
@@ -510,6 +524,8 @@ void tscroll_container::clear_texture()
 void tscroll_container::layout_children()
 {
 	if (need_layout_) {
+		// content may change without invalidate_best_size, don't use memorized best size in this subtree.
+		clear_subtree_best_size();
 		place(get_origin(), get_size());
 
 		// since place scroll_container again, set it dirty.
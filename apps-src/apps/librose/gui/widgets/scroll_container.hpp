@@ -77,6 +77,9 @@ public:
 	/** Inherited from tcontainer_. */
 	void layout_init();
 
+	/** Inherited from tcontainer_. */
+	void clear_subtree_best_size() override;
+
 	/** Inherited from tcontainer_. */
 	bool can_wrap() const
 	{
@@ -124,6 +127,9 @@ public:
 	/** Inherited from tcontainer_. */
 	twidget* find_at(const tpoint& coordinate, const bool must_be_active) override;
 
+	/** Inherited from tcontainer_. */
+	void child_geometry_changed(twidget& child, const SDL_Rect& rect) override;
+
 	/** Inherited from tcontainer_. */
 	twidget* find(const std::string& id, const bool must_be_active);
 
@@ -35,6 +35,7 @@ int twidget::hdpi_scale = 1;
 const int twidget::max_effectable_point = 540; // 1920x1080
 bool twidget::current_landscape = true;
 bool twidget::simple_place = false;
+unsigned twidget::layout_pass = 1;
 
 bool twidget::landscape_from_orientation(torientation orientation, bool def)
 {
@@ -79,6 +80,7 @@ twidget::twidget()
 	, fix_rect_(null_rect)
 	, cookie_(NULL)
 	, layout_size_(tpoint(0,0))
+	, need_relayout_(false)
 	, linked_group_()
 	, drag_(drag_none)
 {
@@ -100,6 +102,7 @@ twidget::twidget(const tbuilder_widget& builder)
 	, fix_rect_(null_rect)
 	, cookie_(NULL)
 	, layout_size_(tpoint(0,0))
+	, need_relayout_(false)
 	, linked_group_(builder.linked_group)
 	, drag_(drag_none)
 {
@@ -119,6 +122,9 @@ twidget::~twidget()
 		if (!linked_group_.empty()) {
 			window->remove_linked_widget(linked_group_, this);
 		}
+		if (need_relayout_) {
+			window->erase_relayout_widget(*this);
+		}
 		tdialog* dialog = window->dialog();
 		if (dialog) {
 			dialog->destruct_widget(this);
@@ -156,6 +162,13 @@ tpoint twidget::get_best_size() const
 	}
 }
 
+void twidget::invalidate_best_size()
+{
+	for (twidget* widget = this; widget; widget = widget->parent_) {
+		widget->clear_best_size();
+	}
+}
+
 void twidget::place(const tpoint& origin, const tpoint& size)
 {
 	// x, y maybe < 0. for example: content_grid_.
@@ -176,6 +189,7 @@ void twidget::place(const tpoint& origin, const tpoint& size)
 		w_ = fix_rect_.w;
 		h_ = fix_rect_.h;
 	}
+	geometry_changed();
 
 	set_dirty();
 }
@@ -187,6 +201,7 @@ void twidget::set_size(const tpoint& size)
 
 	w_ = size.x;
 	h_ = size.y;
+	geometry_changed();
 
 	set_dirty();
 }
@@ -207,6 +222,21 @@ void twidget::move(const int x_offset, const int y_offset)
 {
 	x_ += x_offset;
 	y_ += y_offset;
+	geometry_changed();
+}
+
+void twidget::geometry_changed()
+{
+	if (parent_) {
+		parent_->child_geometry_changed(*this, get_rect());
+	}
+}
+
+void twidget::child_geometry_changed(twidget& child, const SDL_Rect& rect)
+{
+	if (parent_) {
+		parent_->child_geometry_changed(*this, rect);
+	}
 }
 
 twindow* twidget::get_window()
@@ -269,6 +299,7 @@ void twidget::populate_dirty_list(twindow& caller, std::vector<twidget*>& call_s
 void twidget::set_layout_size(const tpoint& size) 
 {
 	layout_size_ = size; 
+	invalidate_best_size();
 }
 
 void twidget::set_visible(const tvisible visible)
@@ -280,8 +311,11 @@ void twidget::set_visible(const tvisible visible)
 	// Switching to or from invisible should invalidate the layout.
 	const bool need_resize = visible_ == INVISIBLE || visible == INVISIBLE;
 	visible_ = visible;
+	geometry_changed();
 
 	if (need_resize) {
+		invalidate_best_size();
+
 		twindow *window = get_window();
 		if(window) {
 			window->invalidate_layout();
@@ -305,6 +339,7 @@ void twidget::set_origin(const tpoint& origin)
 
 	x_ = origin.x;
 	y_ = origin.y;
+	geometry_changed();
 
 	redraw_ = true;
 }
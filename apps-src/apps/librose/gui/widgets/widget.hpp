@@ -82,6 +82,8 @@ public:
 	static int hdpi_scale;
 	static const int max_effectable_point;
 	static bool simple_place;
+	// increased when a window starts full layout, grid's memorized best size is valid only in the same pass.
+	static unsigned layout_pass;
 
 	enum tdrag_direction { drag_none, drag_left = 0x1, drag_right = 0x2, drag_up = 0x4, drag_down = 0x8, drag_track = 0x10};
 	enum tmouse_event {mouse_down, mouse_leave, mouse_motion};
@@ -207,6 +209,20 @@ public:
 	 */
 	tpoint get_best_size() const;
 
+	/**
+	 * Invalidates the memorized best size of this widget and its ancestors.
+	 *
+	 * Anything that changes a widget's best size outside layout_init() should
+	 * call this, else a grid may reuse the best size of this layout pass.
+	 */
+	void invalidate_best_size();
+
+	/** Drops the memorized best size, only grid memorizes it. */
+	virtual void clear_best_size() {}
+
+	/** Drops the memorized best size of this widget and every widget in its subtree. */
+	virtual void clear_subtree_best_size() { clear_best_size(); }
+
 private:
 	/**
 	 * Calculates the best size.
@@ -274,6 +290,12 @@ public:
 	virtual twidget* find_at(const tpoint& coordinate,
 			const bool must_be_active);
 
+	/**
+	 * Area in which find_at can return this widget or one of its descendants.
+	 * A container's descendant may be placed outside of its rectangle.
+	 */
+	virtual SDL_Rect hit_rect() const { return get_rect(); }
+
 	/**
 	 * Gets a widget with the wanted id.
 	 *
@@ -412,6 +434,18 @@ public:
 	 */
 	virtual void move(const int x_offset, const int y_offset);
 
+	/**
+	 * Called whenever rectangle or visibility changes, tells the grid that owns
+	 * this widget, grid uses it to know hit-test index is stale.
+	 */
+	void geometry_changed();
+
+	/**
+	 * Geometry of a widget in the subtree of @a child changed, @a rect is its
+	 * rectangle. Grid handles it, other widgets pass it to their parent.
+	 */
+	virtual void child_geometry_changed(twidget& child, const SDL_Rect& rect);
+
 	int get_x() const { return x_; }
 
 	int get_y() const { return y_; }
@@ -654,6 +688,9 @@ private:
 	 */
 	tpoint layout_size_;
 
+	/** Is waiting in twindow::relayout_widgets_. */
+	bool need_relayout_;
+
 	/**
 	 * The linked group the widget belongs to.
 	 *
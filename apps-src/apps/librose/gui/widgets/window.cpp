@@ -170,6 +170,7 @@ twindow::twindow(CVideo& video,
 	, retval_(NONE)
 	, owner_(0)
 	, need_layout_(true)
+	, relayout_widgets_()
 	, variables_()
 	, invalidate_layout_blocked_(false)
 	, suspend_drawing_(true)
@@ -246,6 +247,10 @@ twindow::~twindow()
 			grid().remove_child(row, col);
 		}
 	}
+	for (std::vector<twidget*>::const_iterator it = relayout_widgets_.begin(); it != relayout_widgets_.end(); ++ it) {
+		(*it)->need_relayout_ = false;
+	}
+	relayout_widgets_.clear();
 
 	/*
 	 * The tip needs to be closed if the window closes and the window is
@@ -411,6 +416,7 @@ int twindow::show(const bool restore)
 
 void twindow::draw()
 {
+	tprofile_scope scope("window draw");
 	display::tcanvas_drawing_buffer_lock lock(*display::get_singleton());
 	/***** ***** ***** ***** Init ***** ***** ***** *****/
 	// Prohibited from drawing?
@@ -424,6 +430,10 @@ void twindow::draw()
 	SDL_QueryTexture(frame_buffer.get(), NULL, NULL, &frame_buffer_width, &frame_buffer_height);
 
 	/***** ***** Layout and get dirty list ***** *****/
+	if (!need_layout_ && !relayout_widgets_.empty()) {
+		// maybe require full layout.
+		relayout();
+	}
 	if (need_layout_) {
 		VALIDATE(!scene_, "layout must not be false during draw.");
 
@@ -713,6 +723,104 @@ void twindow::invalidate_layout()
 	}
 }
 
+void twindow::invalidate_layout(twidget& widget)
+{
+	if (scene_ || invalidate_layout_blocked_ || need_layout_) {
+		return;
+	}
+	widget.invalidate_best_size();
+	if (!widget.need_relayout_) {
+		widget.need_relayout_ = true;
+		relayout_widgets_.push_back(&widget);
+	}
+}
+
+void twindow::erase_relayout_widget(twidget& widget)
+{
+	std::vector<twidget*>::iterator it = std::find(relayout_widgets_.begin(), relayout_widgets_.end(), &widget);
+	if (it != relayout_widgets_.end()) {
+		relayout_widgets_.erase(it);
+	}
+	widget.need_relayout_ = false;
+}
+
+twidget* twindow::relayout_root(twidget& widget)
+{
+	twidget* result = &widget;
+	while (result != this) {
+		if (result->get_visible() == twidget::INVISIBLE) {
+			// it and it's children doesn't take space.
+			return NULL;
+		}
+		if (!result->linked_group_.empty()) {
+			return this;
+		}
+		if (dynamic_cast<tscroll_container*>(result)) {
+			// scrollbar absorb any size change of content.
+			return result;
+		}
+		const tpoint size = result->get_best_size();
+		if (size.x <= (int)result->get_width() && size.y <= (int)result->get_height()) {
+			return result;
+		}
+		result = result->parent();
+		if (!result) {
+			// had been removed from this window.
+			return NULL;
+		}
+	}
+	return this;
+}
+
+void twindow::relayout()
+{
+	std::vector<twidget*> roots;
+	for (std::vector<twidget*>::const_iterator it = relayout_widgets_.begin(); it != relayout_widgets_.end(); ++ it) {
+		twidget& widget = **it;
+		widget.need_relayout_ = false;
+		if (need_layout_) {
+			continue;
+		}
+
+		twidget* root = relayout_root(widget);
+		if (root == this) {
+			need_layout_ = true;
+
+		} else if (root && std::find(roots.begin(), roots.end(), root) == roots.end()) {
+			roots.push_back(root);
+		}
+	}
+	relayout_widgets_.clear();
+
+	if (need_layout_) {
+		return;
+	}
+
+	for (std::vector<twidget*>::const_iterator it = roots.begin(); it != roots.end(); ++ it) {
+		twidget* root = *it;
+		twidget* parent = root->parent();
+		while (parent && std::find(roots.begin(), roots.end(), parent) == roots.end()) {
+			parent = parent->parent();
+		}
+		if (parent) {
+			// ancestor will place it.
+			continue;
+		}
+
+		tscroll_container* scroll = dynamic_cast<tscroll_container*>(root);
+		if (scroll) {
+			// layout_children will place it.
+			scroll->invalidate_layout(false);
+
+		} else {
+			// size keeps, so visible area of parent keeps.
+			root->place(root->get_origin(), root->get_size());
+			root->set_visible_area(root->clip_rect());
+			root->set_dirty();
+		}
+	}
+}
+
 twidget* twindow::float_widget_find_at(const tpoint& coordinate, const bool must_be_active) const
 {
 	twidget* result = nullptr;
@@ -852,6 +960,12 @@ void twindow::layout()
 	VALIDATE(!scene_ || (maximum_width == settings::screen_width && maximum_height == settings::screen_height), null_str);
 
 	/***** Layout. *****/
+	for (std::vector<twidget*>::const_iterator it = relayout_widgets_.begin(); it != relayout_widgets_.end(); ++ it) {
+		(*it)->need_relayout_ = false;
+	}
+	relayout_widgets_.clear();
+	twidget::layout_pass ++;
+
 	layout_init();
 
 	layout_linked_widgets(NULL);
@@ -35,6 +35,10 @@
 
 class CVideo;
 
+namespace benchmark {
+class twindow_layout;
+}
+
 namespace gui2{
 
 class tdialog;
@@ -79,6 +83,7 @@ class twindow
 {
 	friend twindow* build(CVideo&, const twindow_builder::tresolution*, const unsigned, const unsigned);
 	friend class tinvalidate_layout_blocker;
+	friend class benchmark::twindow_layout;
 
 public:
 
@@ -260,6 +265,17 @@ public:
 	 */
 	void invalidate_layout();
 
+	/**
+	 * Relayouts only the subtree that can absorb widget's new best size.
+	 *
+	 * At next draw, size change propagates up until an ancestor whose current
+	 * size holds its new best size, or a scroll container, and only that
+	 * ancestor is placed again. Reaching the window or a linked group falls
+	 * back to full layout.
+	 */
+	void invalidate_layout(twidget& widget);
+	void erase_relayout_widget(twidget& widget);
+
 	/** Inherited from tevent_handler. */
 	twindow& get_window() { return *this; }
 
@@ -462,6 +478,9 @@ public:
 	bool is_scene() const { return scene_; }
 
 private:
+	twidget* relayout_root(twidget& widget);
+	void relayout();
+
 	twidget* float_widget_find_at(const tpoint& coordinate, const bool must_be_active) const;
 	twidget* float_widget_find(const std::string& id, const bool must_be_active) const;
 
@@ -486,6 +505,9 @@ private:
 	 */
 	bool need_layout_;
 
+	/** Widgets that wait for relayout, see invalidate_layout(twidget&). */
+	std::vector<twidget*> relayout_widgets_;
+
 	/** The variables of the canvas. */
 	game_logic::map_formula_callable variables_;
 
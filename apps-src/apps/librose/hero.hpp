@@ -764,7 +764,7 @@ public:
 	bool map_to_file(const std::string& fname);
 	bool map_to_file_fp(posix_file_t fp);
 	bool map_from_file(const std::string& fname);
-	bool map_from_file_fp(posix_file_t fp, uint32_t file_offset = 0, uint32_t valid_bytes = 0);
+	bool map_from_file_fp(posix_file_t fp, uint32_t file_offset = 0, uint32_t valid_bytes = 0, bool check = false);
 
 	bool map_from_mem(const uint8_t* mem, int len);
 	uint32_t map_to_mem(uint8_t* data) const;
@@ -798,6 +798,9 @@ public:
 	void reset_to_unstage();
 	void change_language();
 
+private:
+	void add_from_mem(const uint8_t* mem, int64_t len, bool check);
+
 private:
 	size_t map_size_;
 
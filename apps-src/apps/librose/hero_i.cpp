@@ -1599,104 +1599,72 @@ void hero_map::erase(const uint16_t number)
 	}
 }
 
-bool hero_map::map_from_file(const std::string& fname)
+void hero_map::add_from_mem(const uint8_t* mem, int64_t len, bool check)
 {
-	posix_file_t fp = INVALID_FILE;
-	int64_t fsize, rdpos;
-	uint8_t* fdata = NULL;
-	uint32_t data_size;
-	bool fok = false;
-
-	posix_fopen(fname.c_str(), GENERIC_READ, OPEN_EXISTING, fp);
-	if (fp == INVALID_FILE) {
-		goto exit;
-	}
-	fsize = posix_fsize(fp);
-	if (fsize < HEROS_FILE_PREFIX_BYTES) {
-		goto exit;
-	}
-	fdata = (uint8_t*)malloc(fsize);
-	if (!fdata) {
-		goto exit;
-	}
-	posix_fseek(fp, HEROS_FILE_PREFIX_BYTES);
-	data_size = posix_fread(fp, fdata, fsize - HEROS_FILE_PREFIX_BYTES);
-
-	rdpos = 0;
+	int64_t rdpos = 0;
 	// realloc map memory in hero_map
 	realloc_hero_map(HEROS_MAX_HEROS);
-	while (rdpos + HEROS_BYTES_PER_HERO <= data_size) {
-		hero h(fdata + rdpos);
+	while (rdpos + HEROS_BYTES_PER_HERO <= len) {
+		// construct in place, no temporary hero to copy from.
+		hero* p = new hero(mem + rdpos);
 
-		if (!h.check_valid()) {
+		if (check && !p->check_valid()) {
 			std::stringstream strstr;
-			strstr << h.name() << "'s set is invalid!";
+			strstr << p->name() << "'s set is invalid!";
 			posix_print_mb(utf8_2_ansi(strstr.str().c_str()));
 		}
 		
-		if (h.valid()) {
-			add(h);
+		if (p->valid()) {
+			p->number_ = map_vsize_;
+			map_[map_vsize_ ++] = p;
+		} else {
+			delete p;
 		}
 		rdpos += HEROS_BYTES_PER_HERO;
 	}
+}
 
-	fok = true;
+bool hero_map::map_from_file(const std::string& fname)
+{
+	posix_file_t fp = INVALID_FILE;
+	bool fok;
 
-exit:
-	if (fp != INVALID_FILE) {
-		posix_fclose(fp);
-	}
-	if (fdata) {
-		free(fdata);
+	posix_fopen(fname.c_str(), GENERIC_READ, OPEN_EXISTING, fp);
+	if (fp == INVALID_FILE) {
+		return false;
 	}
+	fok = map_from_file_fp(fp, 0, 0, true);
+	posix_fclose(fp);
 
 	return fok;
 }
 
-bool hero_map::map_from_file_fp(posix_file_t fp, uint32_t file_offset, uint32_t valid_bytes)
+bool hero_map::map_from_file_fp(posix_file_t fp, uint32_t file_offset, uint32_t valid_bytes, bool check)
 {
-	int64_t fsize, rdpos;
+	int64_t fsize;
 	uint8_t* fdata = NULL;
-	bool fok = false;
+	uint32_t data_size;
 
 	fsize = posix_fsize(fp);
 	if (fsize < file_offset + HEROS_FILE_PREFIX_BYTES) {
-		goto exit;
+		return false;
 	}
 	if (valid_bytes) {
-		fdata = (uint8_t*)malloc(valid_bytes - HEROS_FILE_PREFIX_BYTES);
+		data_size = valid_bytes - HEROS_FILE_PREFIX_BYTES;
 	} else {
-		fdata = (uint8_t*)malloc(fsize - file_offset - HEROS_FILE_PREFIX_BYTES);
+		data_size = fsize - file_offset - HEROS_FILE_PREFIX_BYTES;
 	}
+	fdata = (uint8_t*)malloc(data_size);
 	if (!fdata) {
-		goto exit;
+		return false;
 	}
 	posix_fseek(fp, file_offset + HEROS_FILE_PREFIX_BYTES);
-	uint32_t data_size;
-	if (valid_bytes) {
-		data_size = posix_fread(fp, fdata, valid_bytes - HEROS_FILE_PREFIX_BYTES);
-	} else {
-		data_size = posix_fread(fp, fdata, fsize - file_offset - HEROS_FILE_PREFIX_BYTES);
-	}
-
-	rdpos = 0;
-	// realloc map memory in hero_map
-	realloc_hero_map(HEROS_MAX_HEROS);
-	while (rdpos + HEROS_BYTES_PER_HERO <= data_size) {
-		hero h(fdata + rdpos);
-		if (h.valid()) {
-			add(h);
-		}
-		rdpos += HEROS_BYTES_PER_HERO;
-	}
+	data_size = posix_fread(fp, fdata, data_size);
 
-	fok = true;
-exit:
-	if (fdata) {
-		free(fdata);
-	}
+	add_from_mem(fdata, data_size, check);
+	free(fdata);
 
-	return fok;
+	return true;
 }
 
 bool hero_map::map_from_mem(const uint8_t* mem, int len)
@@ -1705,18 +1673,7 @@ bool hero_map::map_from_mem(const uint8_t* mem, int len)
 		return false;
 	}
 
-	int rdpos = HEROS_FILE_PREFIX_BYTES;
-	// realloc map memory in hero_map
-	realloc_hero_map(HEROS_MAX_HEROS);
-	while (rdpos + HEROS_BYTES_PER_HERO <= len) {
-		hero h(mem + rdpos);
-
-		if (h.valid()) {
-			add(h);
-		}
-		rdpos += HEROS_BYTES_PER_HERO;
-	}
-
+	add_from_mem(mem + HEROS_FILE_PREFIX_BYTES, len - HEROS_FILE_PREFIX_BYTES, false);
 	return true;
 }
 
@@ -20,7 +20,6 @@
 
 #include "config.hpp"
 #include "marked-up_text.hpp"
-#include "serialization/parser.hpp"
 #include "integrate.hpp"
 #include "wml_exception.hpp"
 #include "image.hpp"
@@ -224,9 +223,168 @@ std::string tintegrate::drop_escape(const std::string& str)
 
 tintegrate* share_canvas_integrate = NULL;
 
-tintegrate::tintegrate(const std::string& src, int maximum_width, int maximum_height, int default_font_size, const SDL_Color& default_font_color, bool editable)
+const config::attribute_value& tintegrate::tmarkup::operator[](const std::string& key) const
+{
+	for (std::vector<std::pair<std::string, config::attribute_value> >::const_iterator it = attrs.begin(); it != attrs.end(); ++ it) {
+		if (it->first == key) {
+			return it->second;
+		}
+	}
+	static const config::attribute_value empty_attribute;
+	return empty_attribute;
+}
+
+void tintegrate::tmarkup::set(const std::string& key, const std::string& value)
+{
+	for (std::vector<std::pair<std::string, config::attribute_value> >::iterator it = attrs.begin(); it != attrs.end(); ++ it) {
+		if (it->first == key) {
+			it->second = value;
+			return;
+		}
+	}
+	attrs.push_back(std::make_pair(key, config::attribute_value()));
+	// same conversion as WML reader, "yes" is bool, "12" is int and so on.
+	attrs.back().second = value;
+}
+
+static void trim_blank(std::string& str)
+{
+	const char* blanks = " \t\r\n";
+	size_t start = str.find_first_not_of(blanks);
+	if (start == std::string::npos) {
+		str.clear();
+		return;
+	}
+	str.erase(str.find_last_not_of(blanks) + 1);
+	str.erase(0, start);
+}
+
+// attributes are separated by space or newline, value that contains space must be in single quotes.
+// '\' escapes quote and separator. return false if quote is unterminated.
+static bool parse_markup_attributes(const char* start, const char* end, tintegrate::tmarkup& markup)
+{
+	const char escape_char = '\\';
+	std::string key, value;
+	bool has_eq = false, quoted = false, in_quotes = false, escape = false;
+
+	for (const char* ptr = start; ptr <= end; ptr ++) {
+		const bool at_end = ptr == end;
+		const char ch = at_end? '\0': *ptr;
+		if (!at_end && !escape && ch == escape_char) {
+			escape = true;
+			continue;
+		}
+		const bool literal = escape;
+		escape = false;
+
+		if (!at_end && !literal && ch == '\'') {
+			in_quotes = !in_quotes;
+			if (has_eq) {
+				quoted = true;
+			}
+
+		} else if (at_end || (!literal && !in_quotes && (ch == ' ' || ch == '\n'))) {
+			// end of attribute. one without '=' is ignored.
+			if (has_eq) {
+				trim_blank(key);
+				if (!quoted) {
+					trim_blank(value);
+				}
+				if (!key.empty()) {
+					markup.set(key, value);
+				}
+			}
+			key.clear();
+			value.clear();
+			has_eq = quoted = false;
+
+		} else if (!in_quotes && !has_eq && ch == '=') {
+			has_eq = true;
+
+		} else if (has_eq) {
+			value.push_back(ch);
+		} else {
+			key.push_back(ch);
+		}
+	}
+	return !in_quotes;
+}
+
+bool tintegrate::parse_markup(const std::string& src, std::vector<tmarkup>& result)
+{
+	const char escape_char = '\\';
+	const char* c_str = src.c_str();
+	const int size = src.size();
+	std::string text;
+	int text_start = 0;
+	bool escape = false;
+
+	for (int pos = 0; pos < size; pos ++) {
+		char ch = c_str[pos];
+		if (escape || ch != '<') {
+			if (!escape && ch == escape_char) {
+				escape = true;
+			} else {
+				text.push_back(ch);
+				escape = false;
+			}
+			continue;
+		}
+
+		// element name
+		if (!text.empty()) {
+			result.push_back(tmarkup(text_start));
+			result.back().text.swap(text);
+		}
+		std::string name;
+		int name_end = pos + 1;
+		for (; name_end < size; name_end ++) {
+			ch = c_str[name_end];
+			if (!escape && ch == escape_char) {
+				escape = true;
+				continue;
+			}
+			escape = false;
+			if (ch == '/') {
+				// erroneous / in element name.
+				return false;
+			} else if (ch == '>') {
+				break;
+			}
+			name.push_back(ch);
+		}
+		if (name_end == size) {
+			// element continues through end of string.
+			return false;
+		}
+
+		const std::string end_key = "</" + name + ">";
+		const size_t end_pos = src.find(end_key, name_end);
+		if (end_pos == std::string::npos) {
+			// unterminated element.
+			return false;
+		}
+		result.push_back(tmarkup(pos));
+		tmarkup& markup = result.back();
+		markup.name = name;
+		if (!parse_markup_attributes(c_str + name_end + 1, c_str + end_pos, markup)) {
+			return false;
+		}
+
+		pos = end_pos + end_key.size() - 1;
+		text_start = pos + 1;
+	}
+	if (!text.empty()) {
+		result.push_back(tmarkup(text_start));
+		result.back().text.swap(text);
+	}
+	return true;
+}
+
+tintegrate::tintegrate(const std::string& src, int maximum_width, int maximum_height, int default_font_size, const SDL_Color& default_font_color, bool editable, bool measure_only)
 	: src_(editable? src: null_str)
 	, editable_(editable)
+	, measure_only_(measure_only)
 	, items_()
 	, last_row_()
 	, title_spacing_(16)
@@ -252,50 +410,33 @@ tintegrate::tintegrate(const std::string& src, int maximum_width, int maximum_he
 	maximum_width_ = posix_align_floor(maximum_width_, gui2::twidget::hdpi_scale);
 
 	// Parse and add the text.
-	std::map<int, std::string> parsed_items;
-
-	try {
-		parsed_items = utils::to_cfgs(src);
-	} catch (twml_exception& /* e */) {
+	std::vector<tmarkup> markups;
+	if (!parse_markup(src, markups)) {
 		// [see remark#30] process character: '<' 
+		markups.clear();
 		add_text_item(0, 0, src, default_font_color_);
 	}
 
-	std::map<int, std::string>::const_iterator it;
-	for (it = parsed_items.begin(); it != parsed_items.end(); ++it) {
-		std::string name;
-		if (utils::is_single_cfg(it->second, &name)) {
-			// Should be parsed as WML.
-			config cfg;
-/*
-			if (it->second == "[format]text=\"37.0\"[/format]") {
-				int ii = 0;
-			}
-*/
-			read(cfg, it->second);
-/*
-			if (it->second == "[format]text=\"37.0\"[/format]") {
-				int ii = 0;
-			}
-*/
+	for (std::vector<tmarkup>::const_iterator it = markups.begin(); it != markups.end(); ++ it) {
+		const tmarkup& markup = *it;
+		if (markup.name.empty()) {
+			add_text_item(markup.start, markup.start, markup.text, default_font_color_);
+			continue;
+		}
 
-#define TRY(name) do { \
-			if (config &child = cfg.child(#name)) \
-				handle_##name##_cfg(it->first, child); \
+#define TRY(tag) do { \
+			if (markup.name == #tag) \
+				handle_##tag##_cfg(markup.start, markup); \
 			} while (0)
 
-			TRY(ref);
-			TRY(img);
-			TRY(bold);
-			TRY(italic);
-			TRY(header);
-			TRY(jump);
-			TRY(format);
+		TRY(ref);
+		TRY(img);
+		TRY(bold);
+		TRY(italic);
+		TRY(header);
+		TRY(jump);
+		TRY(format);
 #undef TRY
-
-		} else {
-			add_text_item(it->first, it->first, it->second, default_font_color_);
-		}
 	}
 
 	down_one_line(); // End the last line.
@@ -326,7 +467,7 @@ int tintegrate::forward_pos(int start, const std::string& key) const
 	return pos;
 }
 
-void tintegrate::handle_ref_cfg(int tag_start, const config &cfg)
+void tintegrate::handle_ref_cfg(int tag_start, const tmarkup& cfg)
 {
 	const std::string dst = cfg["dst"];
 	const std::string text = cfg["text"];
@@ -335,8 +476,10 @@ void tintegrate::handle_ref_cfg(int tag_start, const config &cfg)
 	if (dst == "") {
 		std::stringstream msg;
 		msg << "Ref markup must have dst attribute. Please submit a bug"
-		       " report if you have not modified the game files yourself. Erroneous config: ";
-		write(msg, cfg);
+		       " report if you have not modified the game files yourself. Erroneous markup: ";
+		for (std::vector<std::pair<std::string, config::attribute_value> >::const_iterator it = cfg.attrs.begin(); it != cfg.attrs.end(); ++ it) {
+			msg << it->first << "='" << it->second.str() << "' ";
+		}
 		VALIDATE(false, msg.str());
 	}
 
@@ -351,7 +494,7 @@ void tintegrate::handle_ref_cfg(int tag_start, const config &cfg)
 
 }
 
-void tintegrate::handle_img_cfg(int start, const config &cfg)
+void tintegrate::handle_img_cfg(int start, const tmarkup& cfg)
 {
 	const std::string src = cfg["src"];
 	const std::string align = cfg["align"];
@@ -363,7 +506,7 @@ void tintegrate::handle_img_cfg(int start, const config &cfg)
 	add_img_item(start, src, align, floating, box, cfg);
 }
 
-void tintegrate::handle_bold_cfg(int tag_start, const config &cfg)
+void tintegrate::handle_bold_cfg(int tag_start, const tmarkup& cfg)
 {
 	const std::string text = cfg["text"];
 	VALIDATE(!text.empty(), "Bold markup must have text attribute.");
@@ -371,7 +514,7 @@ void tintegrate::handle_bold_cfg(int tag_start, const config &cfg)
 	add_text_item(tag_start, start, text, default_font_color_, "", false, -1, true);
 }
 
-void tintegrate::handle_italic_cfg(int tag_start, const config &cfg)
+void tintegrate::handle_italic_cfg(int tag_start, const tmarkup& cfg)
 {
 	const std::string text = cfg["text"];
 	VALIDATE(!text.empty(), "Italic markup must have text attribute.");
@@ -379,7 +522,7 @@ void tintegrate::handle_italic_cfg(int tag_start, const config &cfg)
 	add_text_item(tag_start, start, text, default_font_color_, "", false, -1, false, true);
 }
 
-void tintegrate::handle_header_cfg(int tag_start, const config &cfg)
+void tintegrate::handle_header_cfg(int tag_start, const tmarkup& cfg)
 {
 	const std::string text = cfg["text"];
 	VALIDATE(!text.empty(), "Header markup must have text attribute.");
@@ -387,7 +530,7 @@ void tintegrate::handle_header_cfg(int tag_start, const config &cfg)
 	add_text_item(tag_start, start, text, default_font_color_, "", false, title2_size, true);
 }
 
-void tintegrate::handle_jump_cfg(int, const config &cfg)
+void tintegrate::handle_jump_cfg(int, const tmarkup& cfg)
 {
 	const std::string amount_str = cfg["amount"];
 	const std::string to_str = cfg["to"];
@@ -423,7 +566,7 @@ void tintegrate::handle_jump_cfg(int, const config &cfg)
 	}
 }
 
-void tintegrate::handle_format_cfg(int tag_start, const config &cfg)
+void tintegrate::handle_format_cfg(int tag_start, const tmarkup& cfg)
 {
 	const std::string text = cfg["text"];
 	if (text == "") {
@@ -496,12 +639,20 @@ void tintegrate::add_text_item(int tag_start, int start, const std::string& text
 		else
 			color = font::YELLOW_COLOR;
 
-		surface surf(font::get_rendered_text(first_part, font_size, color, state));
+		surface surf;
+		SDL_Rect text_rect = empty_rect;
+		if (!measure_only_) {
+			surf = font::get_rendered_text(first_part, font_size, color, state);
+		} else {
+			text_rect = font::get_rendered_text_rect(first_part, font_size, state);
+		}
 
-		if (!surf.null()) {
-			// [See remark#22]
-			SDL_SetSurfaceBlendMode(surf, SDL_BLENDMODE_NONE); // direct blit without alpha blending
-			SDL_SetSurfaceRLE(surf, 0);
+		if (!surf.null() || text_rect.w) {
+			if (surf) {
+				// [See remark#22]
+				SDL_SetSurfaceBlendMode(surf, SDL_BLENDMODE_NONE); // direct blit without alpha blending
+				SDL_SetSurfaceRLE(surf, 0);
+			}
 			int src_text_size = get_src_text_size(start, first_part);
 			if (editable_) {
 				std::string text = first_part;
@@ -511,7 +662,12 @@ void tintegrate::add_text_item(int tag_start, int start, const std::string& text
 				validate_str(start, src_text_size, text);
 			}
 
-			add_item(titem(surf, tag_start, start, curr_loc_.first, curr_loc_.second, first_part, ref_dst, font_size, state, src_text_size));
+			titem item(surf, tag_start, start, curr_loc_.first, curr_loc_.second, first_part, ref_dst, font_size, state, src_text_size);
+			if (measure_only_) {
+				item.rect.w = text_rect.w;
+				item.rect.h = text_rect.h;
+			}
+			add_item(item);
 			start += src_text_size;
 			if (editable_) {
 				start -= items_.back().src_end_is_lf(src_);
@@ -565,7 +721,7 @@ surface adaptive_scale_image(surface& surf, double max_ratio)
 }
 
 void tintegrate::add_img_item(int start, const std::string& path, const std::string& alignment,
-								  const bool floating, const bool box, const config& cfg)
+								  const bool floating, const bool box, const tmarkup& cfg)
 {
 	surface surf;
 	std::string anim_id;
@@ -643,7 +799,10 @@ void tintegrate::add_img_item(int start, const std::string& path, const std::str
 		if (surf) {
 			add_item(titem(surf, start, xpos, ypos, src_size, floating, box, align));
 		} else {
-			config anim_cfg = cfg;
+			config anim_cfg;
+			for (std::vector<std::pair<std::string, config::attribute_value> >::const_iterator it = cfg.attrs.begin(); it != cfg.attrs.end(); ++ it) {
+				anim_cfg[it->first] = it->second;
+			}
 			anim_cfg["id"] = anim_id;
 			add_item(titem(anim_cfg, start, create_rect(xpos, ypos, width, height), src_size, floating, box, align));
 			exist_anim_ = true;
@@ -808,6 +967,8 @@ SDL_Rect tintegrate::get_size() const
 
 surface tintegrate::get_surface()
 {
+	VALIDATE(!measure_only_, null_str);
+
 	SDL_Rect size = get_size();
 	surface screen = create_neutral_surface(size.w, size.h);
 
@@ -1429,7 +1590,7 @@ std::string tintegrate::handle_selection(int startx, int starty, int endx, int e
 		} else {
 			start_tmp_pos = start_loc.it->pos;
 		}
-		tintegrate integrate(ret, maximum_width_, maximum_height_, default_font_size_, default_font_color_, true);
+		tintegrate integrate(ret, maximum_width_, maximum_height_, default_font_size_, default_font_color_, true, true);
 		*new_pt = integrate.calculate_cursor(start_tmp_pos);
 
 	} else {
@@ -1571,7 +1732,7 @@ std::string tintegrate::handle_char(bool del, int x, int y, const bool backspace
 				src_tmp_pos = tmp_pos;
 			}
 
-			tintegrate integrate(ret, maximum_width_, maximum_height_, default_font_size_, default_font_color_, true);
+			tintegrate integrate(ret, maximum_width_, maximum_height_, default_font_size_, default_font_color_, true, true);
 			new_pt = integrate.calculate_cursor(src_tmp_pos);
 
 		} else if (before_loc.it->text_type()) {
@@ -1634,7 +1795,7 @@ std::string tintegrate::handle_char(bool del, int x, int y, const bool backspace
 			} else {
 				tmp_pos = loc.it->pos;
 			}
-			tintegrate integrate(ret, maximum_width_, maximum_height_, default_font_size_, default_font_color_, true);
+			tintegrate integrate(ret, maximum_width_, maximum_height_, default_font_size_, default_font_color_, true, true);
 			new_pt = integrate.calculate_cursor(tmp_pos);
 
 		} else {
@@ -1731,7 +1892,7 @@ std::string tintegrate::handle_char(bool del, int x, int y, const bool backspace
 		} else {
 			tmp_pos = loc.it->pos;
 		}
-		tintegrate integrate(ret, maximum_width_, maximum_height_, default_font_size_, default_font_color_, true);
+		tintegrate integrate(ret, maximum_width_, maximum_height_, default_font_size_, default_font_color_, true, true);
 		new_pt = integrate.calculate_cursor(tmp_pos);
 
 	} else if (!new_pt_cacluated) {
@@ -1821,7 +1982,7 @@ std::string tintegrate::insert_str(bool text, int x, int y, const std::string& s
 	}
 
 	if (src_.empty()) {
-		tintegrate integrate(str, maximum_width_, maximum_height_, default_font_size_, default_font_color_, true);
+		tintegrate integrate(str, maximum_width_, maximum_height_, default_font_size_, default_font_color_, true, true);
 		// goto end
 		new_pt = integrate.editable_at2(str.size());
 		return str;
@@ -1865,7 +2026,7 @@ std::string tintegrate::insert_str(bool text, int x, int y, const std::string& s
 			tmp_pos += loc.it->src_size;
 		}
 	}
-	tintegrate integrate(ret, maximum_width_, maximum_height_, default_font_size_, default_font_color_, true);
+	tintegrate integrate(ret, maximum_width_, maximum_height_, default_font_size_, default_font_color_, true, true);
 	new_pt = integrate.calculate_cursor(tmp_pos);
 
 	return ret;
@@ -15,6 +15,7 @@
 #ifndef LIBROSE_INTEGRATE_HPP_INCLUDED
 #define LIBROSE_INTEGRATE_HPP_INCLUDED
 
+#include "config.hpp"
 #include "exceptions.hpp"
 #include "sdl_utils.hpp"
 #include "SDL_ttf.h"
@@ -23,7 +24,6 @@
 
 #include <list>
 
-class config;
 class display;
 
 // Integrating Text and Graphics 
@@ -46,7 +46,8 @@ public:
 	static std::string stuff_escape(const std::string& str);
 	static std::string drop_escape(const std::string& str);
 
-	tintegrate(const std::string& src, int maximum_width, int maximum_height, int default_font_size, const SDL_Color& default_font_color, bool editable = false);
+	// measure_only: lay out by font metrics and don't rasterize text, get_surface() isn't allowed.
+	tintegrate(const std::string& src, int maximum_width, int maximum_height, int default_font_size, const SDL_Color& default_font_color, bool editable = false, bool measure_only = false);
 	~tintegrate();
 
 	int get_src_text_size(int pos, const std::string& text) const;
@@ -91,6 +92,7 @@ public:
 	void set_align_bottom(bool value) { align_bottom_ = value; }
 
 	bool empty() const { return items_.empty(); }
+	bool measure_only() const { return measure_only_; }
 	void clear();
 
 	/// An item that is displayed in the text area. Contains the surface
@@ -163,6 +165,27 @@ public:
 	};
 	void fill_locator_rect(std::vector<tlocator>& locator, bool use_max_width);
 
+	// one segment of markup source: plain text, or a <name>key=value ...</name> tag.
+	struct tmarkup {
+		explicit tmarkup(int start)
+			: start(start)
+			, name()
+			, text()
+			, attrs()
+		{}
+
+		const config::attribute_value& operator[](const std::string& key) const;
+		void set(const std::string& key, const std::string& value);
+
+		int start;
+		// empty if this is plain text.
+		std::string name;
+		std::string text;
+		std::vector<std::pair<std::string, config::attribute_value> > attrs;
+	};
+	// split src into segments in one pass. return false if markup is broken.
+	static bool parse_markup(const std::string& src, std::vector<tmarkup>& result);
+
 private:
 	/// Convert a string to an alignment. Throw parse_error if
 	/// unsuccessful.
@@ -192,13 +215,13 @@ private:
 	// Create appropriate items from configs. Items will be added to the
 	// internal vector. These methods check that the necessary
 	// attributes are specified.
-	void handle_ref_cfg(int start, const config &cfg);
-	void handle_img_cfg(int start, const config &cfg);
-	void handle_bold_cfg(int start, const config &cfg);
-	void handle_italic_cfg(int start, const config &cfg);
-	void handle_header_cfg(int start, const config &cfg);
-	void handle_jump_cfg(int start, const config &cfg);
-	void handle_format_cfg(int start, const config &cfg);
+	void handle_ref_cfg(int start, const tmarkup& cfg);
+	void handle_img_cfg(int start, const tmarkup& cfg);
+	void handle_bold_cfg(int start, const tmarkup& cfg);
+	void handle_italic_cfg(int start, const tmarkup& cfg);
+	void handle_header_cfg(int start, const tmarkup& cfg);
+	void handle_jump_cfg(int start, const tmarkup& cfg);
+	void handle_format_cfg(int start, const tmarkup& cfg);
 
 	/// Add an item with text. If ref_dst is something else than the
 	/// empty string, the text item will be underlined to show that it
@@ -211,7 +234,7 @@ private:
 
 	/// Add an image item with the specified attributes.
 	void add_img_item(int start, const std::string& path, const std::string& alignment, const bool floating,
-					  const bool box, const config& cfg);
+					  const bool box, const tmarkup& cfg);
 
 	/// Move the current input point to the next line.
 	void down_one_line();
@@ -247,6 +270,7 @@ private:
 private:
 	std::string src_;
 	bool editable_;
+	const bool measure_only_;
 	std::list<titem> items_;
 	std::list<titem *> last_row_;
 	const int title_spacing_;
@@ -87,7 +87,8 @@ const t_string& symbol_table::operator[](const char* key) const
 
 bool load_language_list()
 {
-	config cfg;
+	tconfig_arena arena;
+	config cfg(arena);
 	try {
 		wml_config_from_file(game_config::path + "/xwml/" + "language.bin", cfg);
 		
@@ -197,7 +198,9 @@ bool set_language(const language_def& locale)
 	locale_lc.resize(locale.localename.size());
 	std::transform(locale.localename.begin(),locale.localename.end(),locale_lc.begin(),tolower);
 
-	config cfg;
+	// only [language] attributes are kept, the parsed tree is dropped at once.
+	tconfig_arena arena;
+	config cfg(arena);
 
 	current_language = locale;
 	wesnoth_setlocale(LC_COLLATE, locale.localename, &locale.alternates);
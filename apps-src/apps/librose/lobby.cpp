@@ -79,6 +79,401 @@ void tlobby::tlog_handler::join()
 	has_joined_ = true;
 }
 
+tline_framer::tline_framer(int read_size)
+	: data_(NULL)
+	, capacity_(0)
+	, read_size_(0)
+	, head_(0)
+	, scan_(0)
+	, tail_(0)
+{
+	set_read_size(read_size);
+}
+
+tline_framer::~tline_framer()
+{
+	if (data_) {
+		free(data_);
+	}
+}
+
+void tline_framer::set_read_size(int size)
+{
+	VALIDATE(size > 0, null_str);
+	read_size_ = size;
+}
+
+char* tline_framer::prepare()
+{
+	if (capacity_ - tail_ >= read_size_) {
+		return data_ + tail_;
+	}
+
+	// wrap. only the unfinished line is moved.
+	const int pending = tail_ - head_;
+	if (pending + read_size_ > capacity_) {
+		// at least hold 4 reads, only a line longer than that makes it grow again.
+		int size = posix_align_ceil(std::max(pending + read_size_, 4 * read_size_), 4096);
+		char* tmp = (char*)malloc(size);
+		if (pending) {
+			memcpy(tmp, data_ + head_, pending);
+		}
+		if (data_) {
+			free(data_);
+		}
+		data_ = tmp;
+		capacity_ = size;
+
+	} else if (pending) {
+		memmove(data_, data_ + head_, pending);
+	}
+	scan_ -= head_;
+	head_ = 0;
+	tail_ = pending;
+
+	return data_ + tail_;
+}
+
+void tline_framer::commit(int size)
+{
+	VALIDATE(size >= 0 && tail_ + size <= capacity_, null_str);
+	tail_ += size;
+}
+
+char* tline_framer::next_line(int& len)
+{
+	// memchr is vectorized by C runtime.
+	const char* lf = (const char*)memchr(data_ + scan_, '\n', tail_ - scan_);
+	if (!lf) {
+		scan_ = tail_;
+		return NULL;
+	}
+
+	char* line = data_ + head_;
+	const int end = lf - data_;
+	len = end - head_;
+	if (len && line[len - 1] == '\r') {
+		len --;
+	}
+	line[len] = '\0';
+
+	head_ = scan_ = end + 1;
+	if (head_ == tail_) {
+		// all data delivered, next read starts from begin.
+		head_ = scan_ = tail_ = 0;
+	}
+	return line;
+}
+
+thttp_file_sink::thttp_file_sink(const std::string& file)
+	: fp_(INVALID_FILE)
+{
+	posix_fopen(file.c_str(), GENERIC_WRITE, CREATE_ALWAYS, fp_);
+}
+
+thttp_file_sink::~thttp_file_sink()
+{
+	if (fp_ != INVALID_FILE) {
+		posix_fclose(fp_);
+	}
+}
+
+void thttp_file_sink::write(const char* data, int len)
+{
+	if (fp_ != INVALID_FILE) {
+		posix_fwrite(fp_, data, len);
+	}
+}
+
+static bool http_token_equal(const char* s, int len, const char* token)
+{
+	const int token_len = strlen(token);
+	if (len != token_len) {
+		return false;
+	}
+	for (int i = 0; i < len; i ++) {
+		if (tolower((unsigned char)s[i]) != tolower((unsigned char)token[i])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// true if comma-separated value contains token, e.g. "gzip, chunked".
+static bool http_list_contain(const std::string& value, const char* token)
+{
+	const char* s = value.c_str();
+	while (*s) {
+		while (*s == ' ' || *s == '\t' || *s == ',') {
+			s ++;
+		}
+		const char* end = s;
+		while (*end && *end != ',') {
+			end ++;
+		}
+		const char* last = end;
+		while (last > s && (last[-1] == ' ' || last[-1] == '\t')) {
+			last --;
+		}
+		if (last > s && http_token_equal(s, last - s, token)) {
+			return true;
+		}
+		s = end;
+	}
+	return false;
+}
+
+thttp_parser::thttp_parser()
+	: state_(st_status)
+	, sink_(NULL)
+	, line_()
+	, fed_(0)
+	, header_size_(-1)
+	, version_()
+	, status_(0)
+	, phrase_()
+	, headers_()
+	, content_length_(-1)
+	, chunked_(false)
+	, remain_(0)
+	, body_size_(0)
+{}
+
+void thttp_parser::reset(thttp_sink* sink)
+{
+	state_ = st_status;
+	sink_ = sink;
+	line_.clear();
+	fed_ = 0;
+	header_size_ = -1;
+	version_.clear();
+	status_ = 0;
+	phrase_.clear();
+	headers_.clear();
+	content_length_ = -1;
+	chunked_ = false;
+	remain_ = 0;
+	body_size_ = 0;
+}
+
+int thttp_parser::feed(const char* data, int len)
+{
+	int pos = 0;
+	while (pos < len && state_ != st_done && state_ != st_error) {
+		if (state_ == st_body || state_ == st_chunk_data || state_ == st_body_until_close) {
+			int size = len - pos;
+			if (state_ != st_body_until_close && remain_ < size) {
+				size = (int)remain_;
+			}
+			if (sink_) {
+				sink_->write(data + pos, size);
+			}
+			body_size_ += size;
+			pos += size;
+			if (state_ != st_body_until_close) {
+				remain_ -= size;
+				if (!remain_) {
+					state_ = state_ == st_body? st_done: st_chunk_crlf;
+				}
+			}
+			continue;
+		}
+
+		// line based states. only a line spanning two reads is copied.
+		const char* lf = (const char*)memchr(data + pos, '\n', len - pos);
+		const int end = lf? lf - data: len;
+		if ((int)line_.size() + end - pos > max_line_size) {
+			state_ = st_error;
+			break;
+		}
+		if (!lf) {
+			line_.append(data + pos, end - pos);
+			pos = end;
+			break;
+		}
+
+		const char* line = data + pos;
+		int line_len = end - pos;
+		if (!line_.empty()) {
+			line_.append(line, line_len);
+			line = line_.c_str();
+			line_len = line_.size();
+		}
+		if (line_len && line[line_len - 1] == '\r') {
+			line_len --;
+		}
+		pos = end + 1;
+
+		bool ok = handle_line(line, line_len);
+		line_.clear();
+		if (!ok) {
+			state_ = st_error;
+		} else if (state_ != st_header && header_size_ == -1 && status_) {
+			header_size_ = fed_ + pos;
+		}
+	}
+	fed_ += pos;
+	return pos;
+}
+
+void thttp_parser::finish()
+{
+	if (state_ == st_body_until_close) {
+		state_ = st_done;
+	}
+}
+
+bool thttp_parser::handle_line(const char* line, int len)
+{
+	if (state_ == st_status) {
+		if (!len) {
+			// tolerate empty lines before status line.
+			return true;
+		}
+		return handle_status_line(line, len);
+
+	} else if (state_ == st_header) {
+		if (!len) {
+			headers_end();
+			return true;
+		}
+		return handle_header_line(line, len);
+
+	} else if (state_ == st_chunk_size) {
+		char* end;
+		const int64_t size = strtoll(line, &end, 16);
+		if (end == line || size < 0) {
+			return false;
+		}
+		// chunk extensions after ';' are ignored.
+		if (size) {
+			remain_ = size;
+			state_ = st_chunk_data;
+		} else {
+			state_ = st_trailer;
+		}
+
+	} else if (state_ == st_chunk_crlf) {
+		if (len) {
+			return false;
+		}
+		state_ = st_chunk_size;
+
+	} else if (state_ == st_trailer) {
+		if (!len) {
+			state_ = st_done;
+		}
+	}
+	return true;
+}
+
+bool thttp_parser::handle_status_line(const char* line, int len)
+{
+	// HTTP/1.1 200 OK
+	int start = 0;
+	while (start < len && (line[start] == ' ' || line[start] == '\t')) {
+		start ++;
+	}
+	if (len - start < 5 || memcmp(line + start, "HTTP/", 5)) {
+		return false;
+	}
+	const char* sp = (const char*)memchr(line + start, ' ', len - start);
+	if (!sp) {
+		return false;
+	}
+	version_.assign(line + start, sp - line - start);
+
+	int pos = sp - line + 1;
+	status_ = 0;
+	int digits = 0;
+	for (; pos < len && line[pos] >= '0' && line[pos] <= '9'; pos ++, digits ++) {
+		status_ = status_ * 10 + line[pos] - '0';
+	}
+	if (digits != 3) {
+		return false;
+	}
+	while (pos < len && line[pos] == ' ') {
+		pos ++;
+	}
+	phrase_.assign(line + pos, len - pos);
+	state_ = st_header;
+	return true;
+}
+
+bool thttp_parser::handle_header_line(const char* line, int len)
+{
+	const char* colon = (const char*)memchr(line, ':', len);
+	if (!colon) {
+		// invalid line, skip it as before.
+		return true;
+	}
+	int key_start = 0, key_end = colon - line;
+	int val_start = key_end + 1, val_end = len;
+	while (key_start < key_end && isspace((unsigned char)line[key_start])) key_start ++;
+	while (key_end > key_start && isspace((unsigned char)line[key_end - 1])) key_end --;
+	while (val_start < val_end && isspace((unsigned char)line[val_start])) val_start ++;
+	while (val_end > val_start && isspace((unsigned char)line[val_end - 1])) val_end --;
+
+	const char* key = line + key_start;
+	const int key_len = key_end - key_start;
+	headers_.push_back(std::make_pair(std::string(key, key_len), std::string(line + val_start, val_end - val_start)));
+
+	const std::string& value = headers_.back().second;
+	if (http_token_equal(key, key_len, "Content-Length")) {
+		char* end;
+		content_length_ = strtoll(value.c_str(), &end, 10);
+		if (end == value.c_str() || content_length_ < 0) {
+			return false;
+		}
+	} else if (http_token_equal(key, key_len, "Transfer-Encoding")) {
+		chunked_ = http_list_contain(value, "chunked");
+	}
+	return true;
+}
+
+void thttp_parser::headers_end()
+{
+	if (status_ >= 100 && status_ < 200) {
+		// interim response, the real one follows.
+		headers_.clear();
+		status_ = 0;
+		state_ = st_status;
+		return;
+	}
+	if (status_ == 204 || status_ == 304) {
+		state_ = st_done;
+
+	} else if (chunked_) {
+		state_ = st_chunk_size;
+
+	} else if (content_length_ >= 0) {
+		remain_ = content_length_;
+		state_ = remain_? st_body: st_done;
+
+	} else {
+		state_ = st_body_until_close;
+	}
+}
+
+const std::string* thttp_parser::header(const char* key) const
+{
+	for (std::vector<std::pair<std::string, std::string> >::const_iterator it = headers_.begin(); it != headers_.end(); ++ it) {
+		if (http_token_equal(it->first.c_str(), it->first.size(), key)) {
+			return &it->second;
+		}
+	}
+	return NULL;
+}
+
+bool thttp_parser::keep_alive() const
+{
+	const std::string* connection = header("Connection");
+	if (version_ == "HTTP/1.0") {
+		return connection && http_list_contain(*connection, "keep-alive");
+	}
+	return !connection || !http_list_contain(*connection, "close");
+}
+
 #define INVALID_PORT	-1
 tsock::tsock(int at)
 	: at_(at)
@@ -1060,6 +1455,7 @@ irc::ircnet tlobby::tchat_sock::generate_ircnet() const
 
 void tlobby::tchat_sock::mini_connectd()
 {
+	framer_.clear();
 	lobby->add_log(*this, "Connected success! Enter consult.");
 	serv_->p_login(serv_, serv_->network.nick.c_str(), serv_->network.real.c_str());
 }
@@ -1079,48 +1475,22 @@ void tlobby::tchat_sock::mini_read()
 	// since has receive data, i think this conenction is active.
 	pong_receiving_ = false;
 
-	const int chunk_size = 1024;
-	int ret_size = 0, data_pos = 0, segment_pos = 0, line_pos = 0;
+	const int chunk_size = framer_.read_size();
+	int ret_size = 0, line_len;
+	char* line;
 
 	do {
-		if (raw_data_size_ < raw_data_vsize_ + chunk_size) {
-			resize_raw_data(raw_data_size_ + chunk_size);
-		}
-		ret_size = socket_->Recv(raw_data_ + raw_data_vsize_, chunk_size, nullptr);
+		ret_size = socket_->Recv(framer_.prepare(), chunk_size, nullptr);
 		if (ret_size <= 0) {
 			break;
 		}
+		framer_.commit(ret_size);
 
-		raw_data_vsize_ += ret_size;
-
-		while (data_pos < raw_data_vsize_) {
-			switch (raw_data_[data_pos]) {
-			case '\r':
-				break;
-
-			case '\n':
-				raw_data_[segment_pos + line_pos] = 0;
-				serv_->p_inline(serv_, raw_data_ + segment_pos, line_pos);
-				segment_pos = data_pos + 1; // 1 is this \n.
-				line_pos = 0;
-				break;
-
-			default:
-				line_pos ++;
-			}
-			data_pos ++;
+		while ((line = framer_.next_line(line_len))) {
+			serv_->p_inline(serv_, line, line_len);
 		}
 
-	} while (ret_size == chunk_size || raw_data_vsize_ != segment_pos);
-
-	if (!raw_data_vsize_ || raw_data_vsize_ == segment_pos) {
-		raw_data_vsize_ = 0;
-		return;
-	}
-
-	VALIDATE(raw_data_vsize_ > segment_pos, null_str);
-	memmove(raw_data_, raw_data_ + segment_pos, raw_data_vsize_ - segment_pos);
-	raw_data_vsize_ -= segment_pos;
+	} while (ret_size == chunk_size || framer_.has_partial());
 }
 
 void tlobby::tchat_sock::mini_close(int err)
@@ -1902,143 +2272,93 @@ std::string tlobby::thttp_sock::form_request(const std::string& task, size_t con
 	return request.str();
 }
 
-int tlobby::thttp_sock::http_2_cfg(const char* http, const int size, config& cfg)
+void tlobby::thttp_sock::mini_connectd()
 {
-	std::string str;
-	std::vector<std::string> res;
-	int content_start = -1;
+	posix_print("tlobby::thttp_sock::mini_connected()------, state_: %i\n", state_);
 
-	int first;
-	int end = size;
-	int i = 0;
-	while (i != size && (http[i] == ' ' || http[i] == '\t' || http[i] == '\r' || http[i] == '\n')) {
-		++ i;
+	if (progress_) {
+		progress_->set_percent(gui2::tprogress_::finish_precent);
 	}
-	first = i;
-	
-	cfg.clear();
-	while (i != end) {
-		if (http[i] == '\r') {
-			++ i;
-			if (i == end) { 
-				break;
-			}
-			if (http[i] == '\n') {
-				str.resize((i - 1) - first);
-				str.assign(http + first, i - 1 - first);
-				if (!str.empty()) {
-					if (!cfg.has_attribute("__version")) {
-						size_t pos = str.find("HTTP/");
-						if (pos == 0) {
-							std::vector<std::string> vstr = utils::split(str, ' ');
-							if (vstr.size() >= 3) {
-								cfg["__version"] = vstr[0];
-								cfg["__status"] = lexical_cast<int>(vstr[1]);
-								std::stringstream phrase;
-								for (size_t t = 2; t < vstr.size(); t ++) {
-									if (!phrase.str().empty()) {
-										phrase << " ";
-									}
-									phrase << vstr[t];
-								}
-								cfg["__phrase"] = phrase.str();
-							}
-						}
-					} else {
-						size_t pos = str.find(":");
-						if (pos != std::string::npos) {
-							std::string key = str.substr(0, pos);
-							std::string val = str.substr(pos + 1);
-							cfg[utils::strip(key)] = utils::strip(val);
-						}
-					}
-				} else {
-					content_start = i + 1;
-					break;
-				}
-				res.push_back(str);
-				first = i + 1;
-			}
+	pending_.clear();
+	start_response();
+	state_ = s_ready;
+}
+
+void tlobby::thttp_sock::start_response()
+{
+	memory_sink_.clear();
+	response_size_ = 0;
+	parser_.reset(sink_? sink_: &memory_sink_);
+
+	if (!pending_.empty()) {
+		// keep-alive, rest of previous read is start of this response.
+		std::string data;
+		data.swap(pending_);
+		int used = parser_.feed(data.c_str(), data.size());
+		if (parser_.done()) {
+			pending_.assign(data.c_str() + used, data.size() - used);
+			end_response();
 		}
-		++ i;
 	}
-
-	return content_start;
 }
 
-void tlobby::thttp_sock::mini_connectd()
+void tlobby::thttp_sock::end_response()
 {
-	posix_print("tlobby::thttp_sock::mini_connected()------, state_: %i\n", state_);
-
+	response_size_ = (int)parser_.body_size();
 	if (progress_) {
 		progress_->set_percent(gui2::tprogress_::finish_precent);
 	}
-	response_size_ = 0;
-	state_ = s_ready;
 }
 
 void tlobby::thttp_sock::mini_read()
 {
 	VALIDATE(state_ == s_ready, null_str);
-	VALIDATE(!response_size_ || response_size_ <= raw_data_vsize_, null_str);
 
-	const int chunk_size = 1024;
-	int total_size, ret_size;
+	const int chunk_size = 4096;
+	int ret_size;
 
-	char* end_header = NULL;
-	std::string header;
-
-	if (response_size_ && raw_data_vsize_ >= response_size_) {
-		if (raw_data_vsize_ > response_size_) {
-			memmove(raw_data_, raw_data_ + response_size_, raw_data_vsize_ - response_size_);
+	if (parser_.done()) {
+		// previous response has been taken, start next one.
+		start_response();
+		if (parser_.done()) {
+			return;
 		}
-		raw_data_vsize_ -= response_size_;
-		response_size_ = 0;
 	}
 
-	while (!end_header) {
-		if (raw_data_size_ < raw_data_vsize_ + chunk_size) {
-			resize_raw_data(raw_data_size_ + chunk_size);
-		}
-		ret_size = socket_->Recv(raw_data_ + raw_data_vsize_, chunk_size, NULL);
+	resize_raw_data(chunk_size);
+	while (!parser_.done() && !parser_.error()) {
+		ret_size = socket_->Recv(raw_data_, chunk_size, NULL);
 		if (ret_size <= 0) {
 			return;
 		}
-		raw_data_vsize_ += ret_size;
-		end_header = strstr(raw_data_, "\r\n\r\n");
-	}
 
-	int content_length = 0;
-	char* start = strstr(raw_data_, "Content-Length:");
-	if (start && start < end_header) {
-		start += 15;
-		char* end = strstr(start, "\r\n");
-		if (end && end <= end_header) {
-			std::string str(start, end - start);
-			content_length = lexical_cast<int>(str);
+		int used = parser_.feed(raw_data_, ret_size);
+		if (parser_.done()) {
+			pending_.assign(raw_data_ + used, ret_size - used);
+			end_response();
 		}
 	}
-	
-	total_size = (end_header - raw_data_) + 4 + content_length;
-	resize_raw_data(total_size);
 
-	while (total_size > raw_data_vsize_) {
-		ret_size = socket_->Recv(raw_data_ + raw_data_vsize_, total_size - raw_data_vsize_, NULL);
-		if (ret_size <= 0) {
-			return;
+	if (parser_.error()) {
+		// rest of stream can not be framed, drop the connection whether or not a dialog waits for it.
+		posix_print("thttp_sock::mini_read, malformed response, status: %i\n", parser_.status());
+		if (progress_) {
+			progress_->cancel_task();
 		}
-		raw_data_vsize_ += ret_size;
-	}
-
-	if (progress_) {
-		progress_->set_percent(gui2::tprogress_::finish_precent);
+		reset_connect();
 	}
-	// maybe total_size < raw_data_vsize_
-	response_size_ = total_size;
 }
 
 void tlobby::thttp_sock::mini_close(int err)
 {
+	if (!parser_.done()) {
+		parser_.finish();
+		if (parser_.done()) {
+			// body delimited by close is complete.
+			end_response();
+			return;
+		}
+	}
 	if (progress_) {
 		progress_->cancel_task();
 	}
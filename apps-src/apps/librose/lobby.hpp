@@ -18,6 +18,7 @@
 #include "sdl_utils.hpp"
 #include "events.hpp"
 #include "config.hpp"
+#include "posix2.h"
 #include <time.h>
 #include "ichat.hpp"
 #include "gui/dialogs/network_transmission.hpp"
@@ -57,6 +58,130 @@ struct tnoresponse_msg
 	std::string cookie;
 };
 
+// splits a byte stream into '\n' terminated lines without copying them.
+// data is read into a wrap-around buffer, on wrap only the unfinished line is moved to front,
+// so complete lines are always contiguous and handed out in place.
+class tline_framer: private boost::noncopyable
+{
+public:
+	static const int default_read_size = 4096;
+
+	explicit tline_framer(int read_size = default_read_size);
+	~tline_framer();
+
+	void set_read_size(int size);
+	int read_size() const { return read_size_; }
+
+	// return place where next read_size() bytes can be received to.
+	char* prepare();
+	void commit(int size);
+
+	// return next complete line or NULL. "\r\n" or "\n" of line is replaced by 0.
+	// line is valid until next prepare().
+	char* next_line(int& len);
+
+	bool has_partial() const { return head_ != tail_; }
+	void clear() { head_ = scan_ = tail_ = 0; }
+
+private:
+	char* data_;
+	int capacity_;
+	int read_size_;
+	int head_; // start of first not delivered line
+	int scan_; // [head_, scan_) has been searched, no '\n' in it.
+	int tail_;
+};
+
+// receives body bytes of a http response as they arrive.
+class thttp_sink
+{
+public:
+	virtual ~thttp_sink() {}
+	virtual void write(const char* data, int len) = 0;
+};
+
+class thttp_memory_sink: public thttp_sink
+{
+public:
+	void write(const char* data, int len) override { data_.append(data, len); }
+	void clear() { data_.clear(); }
+	const std::string& data() const { return data_; }
+
+private:
+	std::string data_;
+};
+
+class thttp_file_sink: public thttp_sink
+{
+public:
+	explicit thttp_file_sink(const std::string& file);
+	~thttp_file_sink();
+
+	bool valid() const { return fp_ != INVALID_FILE; }
+	void write(const char* data, int len) override;
+
+private:
+	posix_file_t fp_;
+};
+
+// incremental HTTP/1.1 response parser.
+// feed bytes as they are received, body is passed to sink without buffering.
+class thttp_parser
+{
+public:
+	enum tstate {st_status, st_header, st_body, st_body_until_close, st_chunk_size, st_chunk_data, st_chunk_crlf, st_trailer, st_done, st_error};
+	static const int max_line_size = 64 * 1024;
+
+	thttp_parser();
+
+	// start a new response. body will be written to sink, can be NULL.
+	void reset(thttp_sink* sink);
+
+	// return bytes consumed. stop at end of response, rest belongs to next response.
+	int feed(const char* data, int len);
+	// connection is closed. a response delimited by close is complete now.
+	void finish();
+
+	tstate state() const { return state_; }
+	bool done() const { return state_ == st_done; }
+	bool error() const { return state_ == st_error; }
+	bool headers_complete() const { return header_size_ != -1; }
+	// size of status line and headers, including the empty line.
+	int header_size() const { return header_size_; }
+
+	const std::string& version() const { return version_; }
+	int status() const { return status_; }
+	const std::string& phrase() const { return phrase_; }
+	const std::vector<std::pair<std::string, std::string> >& headers() const { return headers_; }
+	// case-insensitive, NULL if not exist.
+	const std::string* header(const char* key) const;
+	int64_t content_length() const { return content_length_; }
+	int64_t body_size() const { return body_size_; }
+	bool keep_alive() const;
+
+private:
+	bool handle_line(const char* line, int len);
+	bool handle_status_line(const char* line, int len);
+	bool handle_header_line(const char* line, int len);
+	void headers_end();
+
+private:
+	tstate state_;
+	thttp_sink* sink_;
+	std::string line_; // partial line that spans reads
+	int64_t fed_;
+	int header_size_;
+
+	std::string version_;
+	int status_;
+	std::string phrase_;
+	std::vector<std::pair<std::string, std::string> > headers_;
+	int64_t content_length_;
+	bool chunked_;
+	int64_t remain_;
+	int64_t body_size_;
+};
+
 class tsock: public sigslot::has_slots<>, private boost::noncopyable
 {
 	friend class tlobby;
@@ -344,6 +469,7 @@ public:
 
 		const std::string& nick() const { return nick_; }
 		irc::server* serv() const { return serv_; }
+		void set_read_size(int size) { framer_.set_read_size(size); }
 		void process();
 		void pre_disconnect();
 		void set_host(const std::string& host, int port);
@@ -409,6 +535,7 @@ public:
 		std::map<int, tlobby_user> users_;
 		std::string nick_;
 		irc::server* serv_;
+		tline_framer framer_;
 		bool pong_receiving_;
 		bool online_offline_received_;
 		
@@ -437,12 +564,14 @@ public:
 			thttp_sock& sock_;
 		};
 
-		static int http_2_cfg(const char* http, const int size, config& cfg);
-
 		thttp_sock()
 			: tsock(tag_http)
 			, progress_(nullptr)
 			, response_size_(0)
+			, parser_()
+			, sink_(nullptr)
+			, memory_sink_()
+			, pending_()
 		{}
 		void process();
 		bool ready() const { return socket_.get() != nullptr; }
@@ -455,10 +584,19 @@ public:
 		bool network_receive_dialog(display& disp, int hidden_ms = 3);
 		bool network_send_dialog(display& disp, const char* buf, int len, int hidden_ms = 3);
 
+		// body of the complete response. when a sink is set, body goes to it and response_buf() is nullptr.
 		int response_size() const { return response_size_; }
-		const char* response_buf() const { return response_size_? raw_data_: nullptr; }
+		const char* response_buf() const { return response_size_ && !sink_? memory_sink_.data().c_str(): nullptr; }
+		// status and headers of the complete response.
+		const thttp_parser& response() const { return parser_; }
+
+		// direct body of following responses to sink. nullptr is memory.
+		void set_sink(thttp_sink* sink) { sink_ = sink; }
 
 	private:
+		void start_response();
+		void end_response();
+
 		void mini_connectd() override;
 		void mini_read() override;
 		void mini_close(int err) override;
@@ -466,6 +604,12 @@ public:
 	private:
 		gui2::tprogress_* progress_;
 		int response_size_;
+
+		thttp_parser parser_;
+		thttp_sink* sink_;
+		thttp_memory_sink memory_sink_;
+		// received bytes after end of a keep-alive response.
+		std::string pending_;
 	};
 
 	class ttransit_sock: public tsock
@@ -134,7 +134,7 @@ void tmap::write_terrain(const map_location &loc, config& cfg) const
 }
 
 tmap::tmap(const std::string& data):
-		tiles_(1),
+		tiles_(),
 		terrainList_(),
 		tcodeToTerrain_(),
 		villages_(),
@@ -160,7 +160,7 @@ tmap::~tmap()
 void tmap::read(const std::string& data)
 {
 	// Initial stuff
-	tiles_.clear();
+	tiles_ = t_translation::t_grid();
 	villages_.clear();
 	std::fill(startingPositions_, startingPositions_ +
 		sizeof(startingPositions_) / sizeof(*startingPositions_), map_location());
@@ -218,10 +218,9 @@ void tmap::read(const std::string& data)
 		throw incorrect_map_format_error(msg.c_str());
 	}
 
-	const std::string& map = std::string(data, header_offset + 2);
-
 	try {
-		tiles_ = t_translation::read_game_map(map, starting_positions);
+		const size_t map_offset = std::min(header_offset + 2, data.size());
+		tiles_ = t_translation::read_game_map(data.c_str() + map_offset, data.size() - map_offset, starting_positions);
 
 	} catch(t_translation::error& e) {
 		// We re-throw the error but as map error.
@@ -229,6 +228,8 @@ void tmap::read(const std::string& data)
 		throw incorrect_map_format_error(e.message);
 	}
 
+	tiles_.set_border(border_size_);
+
 	// Convert the starting positions to the array
 	std::map<int, t_translation::coordinate>::const_iterator itor =
 		starting_positions.begin();
@@ -251,20 +252,21 @@ void tmap::read(const std::string& data)
 	}
 
 	// Post processing on the map
-	total_width_ = tiles_.size();
-	total_height_ = total_width_ > 0 ? tiles_[0].size() : 0;
+	total_width_ = tiles_.w();
+	total_height_ = tiles_.h();
 	w_ = total_width_ - 2 * border_size_;
 	h_ = total_height_ - 2 * border_size_;
 
 	for(int x = 0; x < total_width_; ++x) {
 		for(int y = 0; y < total_height_; ++y) {
+			const t_translation::t_terrain tile = tiles_(x, y);
 
 			// Is the terrain valid?
-			if(tcodeToTerrain_.count(tiles_[x][y]) == 0) {
-				if(!try_merge_terrains(tiles_[x][y])) {
+			if(tcodeToTerrain_.count(tile) == 0) {
+				if(!try_merge_terrains(tile)) {
 					std::stringstream ss;
-					ss << "Illegal tile in map: (" << t_translation::write_terrain_code(tiles_[x][y])
-						   << ") '" << tiles_[x][y] << "'\n";
+					ss << "Illegal tile in map: (" << t_translation::write_terrain_code(tile)
+						   << ") '" << tile << "'\n";
 					// ERR_CF << ss.str();
 					ss << "The map cannot be loaded.";
 					throw incorrect_map_format_error(ss.str().c_str());
@@ -274,23 +276,30 @@ void tmap::read(const std::string& data)
 			// Is it a village?
 			if(x >= border_size_ && y >= border_size_
 					&& x < total_width_-border_size_  && y < total_height_-border_size_
-					&& is_village(tiles_[x][y])) {
+					&& is_village(tile)) {
 				villages_.push_back(map_location(x-border_size_, y-border_size_));
 			}
 		}
 	}
 }
 
-std::string tmap::write() const
+static std::map<int, t_translation::coordinate> starting_positions_to_map(const tmap& map)
 {
 	// Convert the starting positions to a map
 	std::map<int, t_translation::coordinate> starting_positions;
-	for (int i = 0; i < MAX_PLAYERS + 1; ++i)
+	for (int i = 0; i < tmap::MAX_PLAYERS + 1; ++i)
 	{
-		if (!on_board(startingPositions_[i])) continue;
-		t_translation::coordinate position(startingPositions_[i].x + border_size_, startingPositions_[i].y + border_size_);
+		const map_location& loc = map.starting_position(i);
+		if (!map.on_board(loc)) continue;
+		t_translation::coordinate position(loc.x + map.border_size(), loc.y + map.border_size());
 		starting_positions[i] = position;
 	}
+	return starting_positions;
+}
+
+std::string tmap::write() const
+{
+	const std::map<int, t_translation::coordinate> starting_positions = starting_positions_to_map(*this);
 
 	// Let the low level convertor do the conversion
 	std::ostringstream s;
@@ -315,8 +324,8 @@ void tmap::overlay(const tmap& m, const config& rules_cfg, int xpos, int ypos, b
 			const int y2 = y1 + ypos +
 				((xpos & 1) && (x1 & 1) ? 1 : 0);
 
-			const t_translation::t_terrain t = m[x1][y1 + m.border_size_];
-			const t_translation::t_terrain current = (*this)[x2][y2 + border_size_];
+			const t_translation::t_terrain t = m.tiles_.board(x1, y1);
+			const t_translation::t_terrain current = tiles_.board(x2, y2);
 
 			if(t == t_translation::FOGGED || t == t_translation::VOID_TERRAIN) {
 				continue;
@@ -399,7 +408,7 @@ t_translation::t_terrain tmap::get_terrain(const map_location& loc) const
 {
 
 	if(on_board_with_border(loc)) {
-		return tiles_[loc.x + border_size_][loc.y + border_size_];
+		return tiles_.board(loc.x, loc.y);
 	}
 
 	const std::map<map_location, t_translation::t_terrain>::const_iterator itor = borderCache_.find(loc);
@@ -414,7 +423,7 @@ t_translation::t_terrain tmap::get_terrain(const map_location& loc) const
 	get_adjacent_tiles(loc,adj);
 	for(int n = 0; n != 6; ++n) {
 		if(on_board(adj[n])) {
-			items[nitems] = tiles_[adj[n].x][adj[n].y];
+			items[nitems] = tiles_(adj[n].x, adj[n].y);
 			++nitems;
 		} else {
 			// If the terrain is off map but already in the border cache,
@@ -544,7 +553,7 @@ void tmap::set_terrain(const map_location& loc, const t_translation::t_terrain t
 		}
 	}
 
-	tiles_[loc.x + border_size_][loc.y + border_size_] = new_terrain;
+	tiles_.board(loc.x, loc.y) = new_terrain;
 
 	// Update the off-map autogenerated tiles
 	map_location adj[6];
@@ -571,7 +580,7 @@ const std::map<t_translation::t_terrain, size_t>& tmap::get_weighted_terrain_fre
 	for(size_t i = 0; i != size_t(w()); ++i) {
 		for(size_t j = 0; j != size_t(h()); ++j) {
 			const size_t distance = distance_between(map_location(i,j),center);
-			terrainFrequencyCache_[(*this)[i][j]] += weight_at_edge +
+			terrainFrequencyCache_[tiles_(i + border_size_, j)] += weight_at_edge +
 			    (furthest_distance-distance)*additional_weight_at_center;
 		}
 	}
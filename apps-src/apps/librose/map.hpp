@@ -140,7 +140,7 @@ public:
 	int total_height() const { return total_height_; }
 
 	const t_translation::t_terrain operator[](const map_location& loc) const
-		{ return tiles_[loc.x + border_size_][loc.y + border_size_]; }
+		{ return tiles_.board(loc.x, loc.y); }
 
 	/**
 	 * Looks up terrain at a particular location.
@@ -248,7 +248,7 @@ public:
     t_translation::t_terrain merge_terrains(const t_translation::t_terrain old_t, const t_translation::t_terrain new_t, const tmerge_mode mode, bool replace_if_failed = false);
 
 protected:
-	t_translation::t_map tiles_;
+	t_translation::t_grid tiles_;
 
 	/**
 	 * The size of the starting positions array is MAX_PLAYERS + 1,
@@ -265,10 +265,6 @@ private:
 	int num_starting_positions() const
 		{ return sizeof(startingPositions_)/sizeof(*startingPositions_); }
 
-	/** Allows lookup of terrain at a particular location. */
-	const t_translation::t_list operator[](int index) const
-		{ return tiles_[index + border_size_]; }
-
 	/**
 	 * Tries to find out if "terrain" can be created by combining two existing
 	 * terrains Will add the resulting terrain to the terrain list if
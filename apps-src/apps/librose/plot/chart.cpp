@@ -3,14 +3,114 @@
 #include "plot/chart.hpp"
 #include "wml_exception.hpp"
 
-int tplot_chart::calculate_pixel_temperature(bool slope, int number, const int pixels, const int last_unit_value, time_t base_time, int duration, int samples, const titem* chart_data, int* result, int& writable_pos)
+void tplot_chart::tlod::append(const titem& item, int item_size, int value)
+{
+	if (!times.empty() && item.time < times.back()) {
+		monotonic = false;
+	}
+	times.push_back(item.time);
+	items.insert(items.end(), (const uint8_t*)&item, (const uint8_t*)&item + item_size);
+	if (!aggregated) {
+		return;
+	}
+	values.push_back(value);
+
+	// this sample completes one bucket on every level whose width divides count.
+	const size_t count = values.size();
+	for (size_t level = 0; !(count & ((2 << level) - 1)); level ++) {
+		if (levels.size() == level) {
+			levels.push_back(std::vector<tbucket>());
+		}
+		std::vector<tbucket>& buckets = levels[level];
+		const size_t at = buckets.size() * 2;
+		tbucket bucket;
+		if (level == 0) {
+			bucket.min = std::min(values[at], values[at + 1]);
+			bucket.max = std::max(values[at], values[at + 1]);
+			bucket.sum = (int64_t)values[at] + values[at + 1];
+
+		} else {
+			const tbucket& first = levels[level - 1][at];
+			const tbucket& second = levels[level - 1][at + 1];
+			bucket.min = std::min(first.min, second.min);
+			bucket.max = std::max(first.max, second.max);
+			bucket.sum = first.sum + second.sum;
+		}
+		buckets.push_back(bucket);
+	}
+}
+
+void tplot_chart::tlod::clear()
+{
+	parsed_size = 0;
+	data_offset = 0;
+	first_time = 0;
+	aggregated = false;
+	monotonic = true;
+	times.clear();
+	items.clear();
+	values.clear();
+	levels.clear();
+}
+
+int tplot_chart::tlod::lower_bound(int from, int to, time_t time) const
+{
+	if (monotonic) {
+		return std::lower_bound(times.begin() + from, times.begin() + to, time) - times.begin();
+	}
+	while (from < to && times[from] < time) {
+		from ++;
+	}
+	return from;
+}
+
+tplot_chart::tbucket tplot_chart::tlod::aggregate(int from, int to) const
+{
+	VALIDATE(from < to && to <= (int)values.size(), null_str);
+
+	tbucket result;
+	result.min = result.max = values[from];
+	result.sum = values[from];
+	from ++;
+
+	while (from < to) {
+		// widest complete bucket that starts at from and ends within to.
+		int level = -1;
+		while (level + 1 < (int)levels.size()) {
+			const int width = 2 << (level + 1);
+			if ((from & (width - 1)) || from + width > to || (from >> (level + 2)) >= (int)levels[level + 1].size()) {
+				break;
+			}
+			level ++;
+		}
+
+		if (level < 0) {
+			result.min = std::min(result.min, values[from]);
+			result.max = std::max(result.max, values[from]);
+			result.sum += values[from];
+			from ++;
+
+		} else {
+			const tbucket& bucket = levels[level][from >> (level + 1)];
+			result.min = std::min(result.min, bucket.min);
+			result.max = std::max(result.max, bucket.max);
+			result.sum += bucket.sum;
+			from += 2 << level;
+		}
+	}
+	return result;
+}
+
+int tplot_chart::calculate_pixel_temperature(bool slope, int number, const int pixels, const int last_unit_value, time_t base_time, int duration, int first, int samples, int* result, int& writable_pos)
 {
 	int time_per_pixel = 0, pixel_per_time = 0;
 	int can_spread_time = 0, can_spread_pixels = 0;
 	int* result_ptr = result + writable_pos;
 	int last_value = last_unit_value;
+	const int aggregate2 = aggregate();
 
-	int n = 0, at;
+	int n = first, at;
+	const int stop = first + samples;
 	if (duration >= pixels) {
 		time_per_pixel = duration / pixels;
 		can_spread_time = duration - time_per_pixel * pixels;
@@ -30,7 +130,6 @@ int tplot_chart::calculate_pixel_temperature(bool slope, int number, const int p
 	int value;
 	bool key;
 	time_t end_time = base_time;
-	const titem* t2 = NULL;
 
 	for (int pixel = 0; pixel < pixels; ) {
 		if (time_per_pixel) {
@@ -56,16 +155,22 @@ int tplot_chart::calculate_pixel_temperature(bool slope, int number, const int p
 
 		key = true;
 		value = gui2::twidget::npos;
-		while (t2 || n < samples) {
-			if (!t2) {
-				t2 = (const titem*)((uint8_t*)chart_data + n * item_size_);
-				n ++;
+		const int to = lod_.lower_bound(n, stop, end_time);
+		if (aggregate2 == aggregate_fold) {
+			for (; n < to; n ++) {
+				value = calculate_value(lod_.item(n, item_size_), value);
 			}
-			if (t2->time >= end_time) {
-				break;
+
+		} else if (n < to) {
+			const tbucket bucket = lod_.aggregate(n, to);
+			if (aggregate2 == aggregate_min) {
+				value = bucket.min;
+			} else if (aggregate2 == aggregate_max) {
+				value = bucket.max;
+			} else {
+				value = (int)(bucket.sum / (to - n));
 			}
-			value = calculate_value(*t2, value);
-			t2 = NULL;
+			n = to;
 		}
 		if (slope) {
 			if (value == gui2::twidget::npos) {
@@ -131,7 +236,7 @@ int tplot_chart::calculate_pixel_temperature(bool slope, int number, const int p
 		last_value = value & 0xffff;
 	}
 
-	VALIDATE(n == samples, null_str);
+	VALIDATE(n == stop, null_str);
 
 	if (!slope) {
 		writable_pos += pixels;
@@ -158,26 +263,64 @@ void tplot_chart::resize_data_per_unit(int size)
 	}
 }
 
-void tplot_chart::generate(tfile& lock, int used_units, int zoom)
+void tplot_chart::reset_samples()
 {
-/*
-	if (chart_data_key.first == used_units && chart_data_key.second == zoom) {
+	release_vector();
+	lod_.clear();
+}
+
+void tplot_chart::append_samples(tfile& lock)
+{
+	const int items2 = items();
+	const int64_t data_size2 = data_size();
+	VALIDATE(items2 * item_size_ == data_size2, null_str);
+
+	const bool aggregated = aggregate() != aggregate_fold;
+	if (data_size2 < lod_.parsed_size || data_offset() != lod_.data_offset || first_time() != lod_.first_time || aggregated != lod_.aggregated) {
+		// not the recording that lod_ was built from, or levels are required now.
+		reset_samples();
+		lod_.data_offset = data_offset();
+		lod_.first_time = first_time();
+		lod_.aggregated = aggregated;
+	}
+	if (lod_.parsed_size == data_size2) {
 		return;
 	}
-*/
+
+	const int one_read_bytes = 4096 * item_size_;
+	lock.resize_data(one_read_bytes);
+	posix_fseek(lock.fp, data_offset() + lod_.parsed_size);
+
+	while (lod_.parsed_size < data_size2) {
+		int size = one_read_bytes;
+		if (data_size2 - lod_.parsed_size < one_read_bytes) {
+			size = data_size2 - lod_.parsed_size;
+		}
+		VALIDATE((int)posix_fread(lock.fp, lock.data, size) == size, null_str);
+
+		for (const char* data_ptr = lock.data; data_ptr < lock.data + size; data_ptr += item_size_) {
+			const titem& t = *(const titem*)data_ptr;
+			if (is_event_item(t)) {
+				std::pair<int, int> pair = disassemble_alert(t);
+				events.push_back(create_event(pair.first, t.time, pair.second));
+				continue;
+			}
+			lod_.append(t, item_size_, aggregated? calculate_value(t, gui2::twidget::npos): 0);
+		}
+		lod_.parsed_size += size;
+	}
+}
+
+void tplot_chart::generate(tfile& lock, int used_units, int zoom)
+{
 	VALIDATE(chart_data2, null_str);
 
-	release_vector();
+	// samples and events are kept in lod_, only new data in file is read.
+	unit_params.clear();
+	append_samples(lock);
 
 	// whether sample count < unit count or not. when slope = true, mean at least one unit hasn't sample, appear slope.
 	bool slope = true;
-	const int default_data_per_unit_size = 1024;
-	if (!data_per_unit_size) {
-		VALIDATE(!data_per_unit, null_str);
-		// initial 1024 data, it maybe extend when draw.
-		data_per_unit_size = default_data_per_unit_size;
-		data_per_unit = (titem*)malloc(data_per_unit_size * item_size_);
-	}
 	VALIDATE(used_units * zoom <= max_chart_data_size_, null_str);
 
 	int pixels_per_unit = zoom;
@@ -189,32 +332,11 @@ void tplot_chart::generate(tfile& lock, int used_units, int zoom)
 		slope = false;
 	}
 
-	int x = 0;
-
-	int64_t last_fread_byte = 0; // data pos, not file pos!
-
-	const int bytes_per_sample = item_size_;
-	const int one_read_bytes = 4096 * bytes_per_sample;
-	int last_unit_lack_samples = 0;
-
-	lock.resize_data(one_read_bytes);
-	posix_fseek(lock.fp, data_offset());
-
-	char* data_ptr = NULL;
-
-	const int items2 = items();
-	const int64_t data_size2 = data_size();
-	VALIDATE(items2 * item_size_ == data_size2, null_str);
-
+	const int samples = lod_.size();
 	int writable_pos = 0;
-	int start_samples = 0, temperature_samples, event_samples = 0, last_unit_value = 0;
-	int64_t parsed_size = 0;
-	int64_t last_parsed_size = parsed_size;
+	int start_samples = 0, temperature_samples, last_unit_value = 0;
 	int* chart_data2_ptr = chart_data2;
 	time_t base_time, end_time = first_time();
-	titem* t2 = create_item();
-	t2->time = gui2::twidget::npos;
-	std::vector<tevent*> events;
 	time_t* start_times = (time_t*)malloc(sizeof(time_t) * used_units);
 	for (int num = 0; num < used_units; num ++) {
 		int time_per_unit2 = time_per_unit;
@@ -228,57 +350,14 @@ void tplot_chart::generate(tfile& lock, int used_units, int zoom)
 		}
 		base_time = end_time;
 		end_time = base_time + time_per_unit2;
-		temperature_samples = 0;
-		
-		while (start_samples + temperature_samples + event_samples < items2) {
-			if (t2->time == gui2::twidget::npos) {
-				if (!data_ptr || data_ptr == lock.data + last_fread_byte) {
-					int size = one_read_bytes;
-					if (data_size2 - parsed_size < one_read_bytes) {
-						size = data_size2 - parsed_size;
-					}
-					last_fread_byte = posix_fread(lock.fp, lock.data, size);
-					data_ptr = lock.data;
-				}
-
-				const titem* t = (titem*)data_ptr;
-				parsed_size += bytes_per_sample;
-				data_ptr += bytes_per_sample;
-
-				if (is_event_item(*t)) {
-					std::pair<int, int> pair = disassemble_alert(*t);
-					events.push_back(create_event(pair.first, t->time, pair.second));
-					event_samples ++;
-					continue;
-				}
-
-				memcpy(t2, t, item_size_);
-			}
-
-			if (t2->time >= end_time) {
-				break;
-			}
-
-			memcpy((uint8_t*)data_per_unit + temperature_samples * item_size_, t2, item_size_);
-			temperature_samples ++;
+		temperature_samples = lod_.lower_bound(start_samples, samples, end_time) - start_samples;
 
-			if (temperature_samples == data_per_unit_size) {
-				resize_data_per_unit((data_per_unit_size + default_data_per_unit_size / 2) * item_size_);
-			}
-
-			t2->time = gui2::twidget::npos;
-		}
-
-		last_unit_value = calculate_pixel_temperature(slope, num, pixels_per_unit, last_unit_value, base_time, time_per_unit2, temperature_samples, data_per_unit, chart_data2, writable_pos);
+		last_unit_value = calculate_pixel_temperature(slope, num, pixels_per_unit, last_unit_value, base_time, time_per_unit2, start_samples, temperature_samples, chart_data2, writable_pos);
 		unit_params.push_back(tunit_param(base_time, time_per_unit2, start_samples, temperature_samples));
 		start_times[num] = base_time;
 		
 		start_samples += temperature_samples;
 		chart_data2_ptr += pixels_per_unit;
-		// last_unit_value = *(chart_data2_ptr - 1) & 0xffff;
-
-		x += pixels_per_unit;
-		last_parsed_size = parsed_size;
 	}
 
 	// timestamp of event maybe not sequence with data. special evalue.
@@ -293,27 +372,9 @@ void tplot_chart::generate(tfile& lock, int used_units, int zoom)
 		}
 	}
 
-	if (writable_pos != used_units * zoom) {
-		int remainer = used_units * zoom - writable_pos;
-/*
-		VALIDATE(slope && remainer < zoom, null_str);
-
-		int* result_ptr = chart_data2 + writable_pos;
-		last_unit_value = *(result_ptr - 1) & 0xffff;
-		while (remainer --) {
-			*result_ptr = last_unit_value;
-			result_ptr ++;
-		}
-*/
-	}
-
-	VALIDATE(parsed_size == data_size2, null_str);
+	VALIDATE(start_samples == samples, null_str);
 	VALIDATE(chart_data2_ptr == chart_data2 + (used_units * zoom), null_str);
 	VALIDATE(unit_params.size() == used_units, null_str);
 
-	free(t2);
 	free(start_times);
-	// rember this key.
-	// chart_data_key.first = used_units;
-	// chart_data_key.second = zoom;
 }
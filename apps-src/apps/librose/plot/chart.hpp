@@ -12,6 +12,59 @@ public:
 		int time;
 	};
 
+	// how samples within one pixel combine. fold is calculate_value over every sample,
+	// the others are answered from the lod pyramid without visiting samples.
+	enum {aggregate_fold, aggregate_min, aggregate_max, aggregate_avg};
+
+	struct tbucket {
+		int min;
+		int max;
+		int64_t sum;
+	};
+
+	// samples decoded from tfile, appended as the file grows.
+	// levels[k][i] aggregates samples [i << (k + 1), (i + 1) << (k + 1)), only complete buckets exist.
+	// values and levels are built only when aggregated, aggregate_fold has to visit samples anyway.
+	//
+	// every sample of the recording stays in memory: item_size + 4 bytes, and when aggregated,
+	// 4 bytes of value + about 16 bytes of buckets more. a day at one sample per second with
+	// 16 bytes item is about 1.7M (aggregate_fold) or 3.5M (min/max/avg).
+	class tlod
+	{
+	public:
+		tlod()
+			: parsed_size(0)
+			, data_offset(0)
+			, first_time(0)
+			, aggregated(false)
+			, monotonic(true)
+		{}
+
+		int size() const { return (int)times.size(); }
+		const titem& item(int at, int item_size) const { return *(const titem*)(&items[0] + at * item_size); }
+
+		void append(const titem& item, int item_size, int value);
+		void clear();
+
+		// first sample in [from, to) whose time >= time, to if none.
+		int lower_bound(int from, int to, time_t time) const;
+		tbucket aggregate(int from, int to) const;
+
+	public:
+		int64_t parsed_size;
+		int64_t data_offset;
+		time_t first_time;
+		// aggregate() != aggregate_fold when samples were appended.
+		bool aggregated;
+
+	private:
+		std::vector<int> times;
+		std::vector<uint8_t> items;
+		std::vector<int> values;
+		std::vector<std::vector<tbucket> > levels;
+		bool monotonic;
+	};
+
 	struct tevent {
 		tevent(int type, time_t time, int value)
 			: type(type)
@@ -68,6 +121,8 @@ public:
 	}
 
 	void generate(tfile& lock, int used_units, int zoom);
+	// drop decoded samples, next generate reads from beginning.
+	void reset_samples();
 
 protected:
 	void resize_data_per_unit(int size);
@@ -82,7 +137,10 @@ private:
 
 		unit_params.clear();
 	}
-	int calculate_pixel_temperature(bool slope, int number, const int pixels, const int last_unit_value, time_t base_time, int duration, int samples, const titem* chart_data, int* result, int& writable_pos);
+	void append_samples(tfile& lock);
+	int calculate_pixel_temperature(bool slope, int number, const int pixels, const int last_unit_value, time_t base_time, int duration, int first, int samples, int* result, int& writable_pos);
+
+	virtual int aggregate() const { return aggregate_fold; }
 
 	virtual int clip_value(int value) const { return value; }
 	virtual int calculate_value(const titem& item, const int history) = 0;
@@ -109,6 +167,7 @@ public:
 	int* chart_data2;
 
 protected:
+	tlod lod_;
 	int max_chart_data_size_;
 	int bytes_per_pixel_data_;
 	int item_size_;
@@ -36,6 +36,9 @@
 #include "gettext.hpp"
 #include "hero.hpp"
 #include "lobby.hpp"
+#include "thread.hpp"
+
+#include <list>
 
 // #include <sys/stat.h> // for setting the permissions of the preferences file
 
@@ -48,11 +51,188 @@ bool color_cursors = false;
 
 bool no_preferences_save = false;
 
-bool fps = false;
 
 int draw_delay_ = 20;
 
 config prefs;
+
+// write-behind store of preferences file.
+// changes in coalesce_ms are written once, serialize and write run in a background thread.
+class twriter
+{
+public:
+	static const Uint32 coalesce_ms = 500;
+	// continuous changes can not delay write more than this.
+	static const Uint32 max_delay_ms = 3000;
+
+	twriter()
+		: thread_(NULL)
+		, mutex_()
+		, cond_()
+		, done_()
+		, file_()
+		, pending_()
+		, retired_()
+		, dirty_(false)
+		, writing_(false)
+		, quit_(false)
+		, first_ticks_(0)
+		, due_ticks_(0)
+	{}
+
+	void schedule(const std::string& file, const config& snapshot);
+	void flush();
+	void stop();
+
+private:
+	static int run(void* param);
+	void loop();
+	void write_atomic(const std::string& file, const config& cfg) const;
+
+private:
+	SDL_Thread* thread_;
+	threading::mutex mutex_;
+	threading::condition cond_;
+	threading::condition done_;
+
+	// below are protected by mutex_
+	std::string file_;
+	config pending_;
+	// t_string is interned in a map that is not thread safe, so the writer thread
+	// never destroys a config. written snapshots queue here until main thread releases them.
+	// a list, so adding one never copies the others.
+	std::list<config> retired_;
+	bool dirty_;
+	bool writing_;
+	bool quit_;
+	Uint32 first_ticks_;
+	Uint32 due_ticks_;
+};
+
+void twriter::schedule(const std::string& file, const config& snapshot)
+{
+	threading::lock lock(mutex_);
+
+	const Uint32 now = SDL_GetTicks();
+	if (!dirty_) {
+		first_ticks_ = now;
+	}
+	retired_.clear();
+	file_ = file;
+	// copy shares subtrees with prefs, it costs little on main thread.
+	pending_ = snapshot;
+	dirty_ = true;
+	due_ticks_ = std::min(now + coalesce_ms, first_ticks_ + max_delay_ms);
+
+	if (!thread_) {
+		quit_ = false;
+		thread_ = SDL_CreateThread(run, "preferences", this);
+	}
+	cond_.notify_one();
+}
+
+void twriter::flush()
+{
+	threading::lock lock(mutex_);
+	if (!thread_) {
+		return;
+	}
+	due_ticks_ = SDL_GetTicks();
+	cond_.notify_one();
+	while (dirty_ || writing_) {
+		done_.wait(mutex_);
+	}
+}
+
+void twriter::stop()
+{
+	flush();
+
+	SDL_Thread* thread = NULL;
+	{
+		threading::lock lock(mutex_);
+		quit_ = true;
+		thread = thread_;
+		thread_ = NULL;
+		cond_.notify_one();
+	}
+	if (thread) {
+		SDL_WaitThread(thread, NULL);
+	}
+	retired_.clear();
+}
+
+int twriter::run(void* param)
+{
+	static_cast<twriter*>(param)->loop();
+	return 0;
+}
+
+void twriter::loop()
+{
+	SDL_LockMutex(mutex_.m_);
+	while (true) {
+		if (dirty_) {
+			const Uint32 now = SDL_GetTicks();
+			if (!quit_ && now < due_ticks_) {
+				cond_.wait_timeout(mutex_, due_ticks_ - now);
+				continue;
+			}
+
+			config snapshot;
+			snapshot.swap(pending_);
+			const std::string file = file_;
+			dirty_ = false;
+			writing_ = true;
+
+			SDL_UnlockMutex(mutex_.m_);
+			write_atomic(file, snapshot);
+			SDL_LockMutex(mutex_.m_);
+
+			// snapshot is left empty, destroying it here touches no t_string.
+			retired_.push_back(config());
+			retired_.back().swap(snapshot);
+			writing_ = false;
+			done_.notify_all();
+			continue;
+		}
+		if (quit_) {
+			break;
+		}
+		cond_.wait(mutex_);
+	}
+	SDL_UnlockMutex(mutex_.m_);
+}
+
+void twriter::write_atomic(const std::string& file, const config& cfg) const
+{
+	std::stringstream out;
+	write(out, cfg);
+	const std::string data = out.str();
+
+	// if killed while writing, the former file is still intact. rename replaces it in one step.
+	const std::string temp_file = file + ".tmp";
+	posix_file_t fp;
+	posix_fopen(temp_file.c_str(), GENERIC_WRITE, CREATE_ALWAYS, fp);
+	if (fp == INVALID_FILE) {
+		ERR_FS << "error writing to preferences file '" << temp_file << "'\n";
+		return;
+	}
+	const size_t written = posix_fwrite(fp, data.c_str(), data.size());
+	posix_fclose(fp);
+	if (written != data.size()) {
+		ERR_FS << "error writing to preferences file '" << temp_file << "'\n";
+		SDL_DeleteFiles(temp_file.c_str());
+		return;
+	}
+
+	if (!rename_file_over(temp_file, file)) {
+		ERR_FS << "error replacing preferences file '" << file << "'\n";
+		SDL_DeleteFiles(temp_file.c_str());
+	}
+}
+
+twriter writer;
 }
 
 namespace preferences {
@@ -89,24 +269,26 @@ base_manager::base_manager()
 
 base_manager::~base_manager()
 {
-	if (no_preferences_save) return;
+	if (no_preferences_save) {
+		writer.stop();
+		return;
+	}
 
 	// Set the 'hidden' preferences.
 	prefs["scroll_threshold"] = mouse_scroll_threshold();
 
 	write_preferences();
+	writer.stop();
 }
 
 void write_preferences()
 {
-	try {
-		std::stringstream out;
-		write(out, prefs);
-		write_file(get_prefs_file(), out.str().c_str(), out.str().size());
+	writer.schedule(get_prefs_file(), prefs);
+}
 
-	} catch(io_exception&) {
-		ERR_FS << "error writing to preferences file '" << get_prefs_file() << "'\n";
-	}
+void flush_preferences()
+{
+	writer.flush();
 }
 
 void set(const std::string &key, bool value)
@@ -910,12 +1092,13 @@ bool show_standing_animations()
 
 bool show_fps()
 {
-	return fps;
+	return preferences::get("show_fps", false);
 }
 
 void set_show_fps(bool value)
 {
-	fps = value;
+	preferences::set("show_fps", value);
+	get_frame_profiler().set_enabled(value);
 }
 
 int draw_delay()
@@ -39,7 +39,10 @@ namespace preferences {
 		~base_manager();
 	};
 
+	// preferences are written in background after changes settle, this returns at once.
 	void write_preferences();
+	// block until scheduled write is on disk.
+	void flush_preferences();
 
 	void set(const std::string& key, const std::string &value);
 	void set(const std::string& key, char const *value);
@@ -567,8 +567,6 @@ extern surface render_scale_surface(const surface &surf, int w, int h);
 // NOTE: Don't pass this function 0 scaling arguments.
 surface scale_surface(const surface &surf, int w, int h, bool optimize)
 {
-	Uint32 start_soft, stop_soft, start_gpu, stop_gpu;
-
 	if (surf == NULL) {
 		return NULL;
 	}
@@ -578,7 +576,6 @@ surface scale_surface(const surface &surf, int w, int h, bool optimize)
 	}
 	VALIDATE(w >= 0 && h >= 0 && is_neutral_surface(surf), null_str);
 
-	start_soft = SDL_GetTicks();
 /*	surface dst(create_neutral_surface(w,h));
 
 	// Now both surfaces are always in the "neutral" pixel format
@@ -720,12 +717,8 @@ surface scale_surface(const surface &surf, int w, int h, bool optimize)
 		}
 	}
 */
-	start_gpu = stop_soft = SDL_GetTicks();
-
+	tprofile_scope scope("scale_surface");
 	surface dst = render_scale_surface(surf, w, h);
-	stop_gpu = SDL_GetTicks();
-
-	posix_print("(%ix%i)==>(%ix%i), soft: %i, gup: %i\n", surf->w, surf->h, w, h, stop_soft - start_soft, stop_gpu - start_gpu);
 	return optimize ? create_optimized_surface(dst) : dst;
 }
 
@@ -153,6 +153,9 @@ void parser::operator()()
 				_("Missing closing tag for tag [$tag]"),
 				_("expected at $pos")), _("opened at $pos"));
 	}
+
+	// the elements stack was the only holder of child references.
+	cfg_.make_shareable();
 }
 
 void parser::parse_element()
@@ -22,6 +22,7 @@
 #include "serialization/string_utils.hpp"
 #include "sound.hpp"
 #include "sound_music_track.hpp"
+#include "thread.hpp"
 #include "util.hpp"
 #include "wml_exception.hpp"
 
@@ -29,6 +30,7 @@
 
 #include <boost/foreach.hpp>
 #include <list>
+#include <unordered_map>
 
 static lg::log_domain log_audio("audio");
 #define LOG_AUDIO LOG_STREAM(info, log_audio)
@@ -141,6 +143,8 @@ private:
 
 std::list< sound_cache_chunk > sound_cache;
 typedef std::list< sound_cache_chunk >::iterator sound_cache_iterator;
+// file => position in sound_cache, lookup needn't walk the list.
+std::unordered_map<std::string, sound_cache_iterator> sound_cache_index;
 std::map<std::string, Mix_Music*> music_cache;
 
 std::vector<std::string> played_before;
@@ -278,6 +282,156 @@ struct audio_lock
 	}
 };
 
+sound_cache_iterator erase_cache_chunk(sound_cache_iterator it)
+{
+	sound_cache_index.erase(it->file);
+	return sound_cache.erase(it);
+}
+
+// decodes missed sound file in background, so that playing sound never stalls caller on disk I/O.
+// when decoded, chunk is put into sound_cache and waiting plays start in pump().
+class chunk_decoder
+{
+public:
+	// play later than this is meaningless, drop it.
+	static const Uint32 max_wait_ms = 1000;
+
+	struct tplay {
+		std::string file;
+		sound::channel_group group;
+		unsigned int repeats;
+		unsigned int distance;
+		int id;
+		int loop_ticks;
+		int fadein_ticks;
+		Uint32 ticks;
+	};
+
+	chunk_decoder()
+		: thread_(NULL)
+		, mutex_()
+		, cond_()
+		, jobs_()
+		, decoded_()
+		, quit_(false)
+		, plays_()
+	{}
+
+	// below are called by main thread.
+	void decode(const std::string& filename, const tplay& play);
+	void drop(sound::channel_group group);
+	void pump();
+	void stop();
+
+private:
+	static int run(void* param);
+	void loop();
+
+private:
+	SDL_Thread* thread_;
+	threading::mutex mutex_;
+	threading::condition cond_;
+
+	// below are protected by mutex_
+	// first: file, second: filename to decode.
+	std::vector<std::pair<std::string, std::string> > jobs_;
+	// first: file, second: decoded chunk, NULL if fail.
+	std::vector<std::pair<std::string, Mix_Chunk*> > decoded_;
+	bool quit_;
+
+	// main thread only.
+	std::vector<tplay> plays_;
+};
+
+void chunk_decoder::decode(const std::string& filename, const tplay& play)
+{
+	bool decoding = false;
+	for (std::vector<tplay>::const_iterator it = plays_.begin(); it != plays_.end(); ++ it) {
+		if (it->file == play.file) {
+			decoding = true;
+			break;
+		}
+	}
+	plays_.push_back(play);
+	if (decoding) {
+		return;
+	}
+
+	threading::lock lock(mutex_);
+	jobs_.push_back(std::make_pair(play.file, filename));
+	if (!thread_) {
+		quit_ = false;
+		thread_ = SDL_CreateThread(run, "sound", this);
+	}
+	cond_.notify_one();
+}
+
+void chunk_decoder::drop(sound::channel_group group)
+{
+	for (std::vector<tplay>::iterator it = plays_.begin(); it != plays_.end(); ) {
+		if (it->group == group) {
+			it = plays_.erase(it);
+		} else {
+			++ it;
+		}
+	}
+}
+
+void chunk_decoder::stop()
+{
+	SDL_Thread* thread = NULL;
+	{
+		threading::lock lock(mutex_);
+		jobs_.clear();
+		quit_ = true;
+		thread = thread_;
+		thread_ = NULL;
+		cond_.notify_one();
+	}
+	if (thread) {
+		SDL_WaitThread(thread, NULL);
+	}
+
+	for (std::vector<std::pair<std::string, Mix_Chunk*> >::const_iterator it = decoded_.begin(); it != decoded_.end(); ++ it) {
+		if (it->second) {
+			Mix_FreeChunk(it->second);
+		}
+	}
+	decoded_.clear();
+	plays_.clear();
+}
+
+int chunk_decoder::run(void* param)
+{
+	static_cast<chunk_decoder*>(param)->loop();
+	return 0;
+}
+
+void chunk_decoder::loop()
+{
+	SDL_LockMutex(mutex_.m_);
+	while (true) {
+		if (!jobs_.empty()) {
+			const std::pair<std::string, std::string> job = jobs_.front();
+			jobs_.erase(jobs_.begin());
+
+			SDL_UnlockMutex(mutex_.m_);
+			Mix_Chunk* chunk = Mix_LoadWAV(job.second.c_str());
+			SDL_LockMutex(mutex_.m_);
+
+			decoded_.push_back(std::make_pair(job.first, chunk));
+			continue;
+		}
+		if (quit_) {
+			break;
+		}
+		cond_.wait(mutex_);
+	}
+	SDL_UnlockMutex(mutex_.m_);
+}
+
+chunk_decoder decoder;
+
 } // end of anonymous namespace
 
 
@@ -385,7 +539,9 @@ void close_sound()
 		stop_bell();
 		stop_UI_sound();
 		stop_sound();
+		decoder.stop();
 		sound_cache.clear();
+		sound_cache_index.clear();
 		stop_music();
 		mix_ok = false;
 
@@ -450,11 +606,13 @@ void stop_sound()
 	if (mix_ok) {
 		Mix_HaltGroup(SOUND_SOURCES);
 		Mix_HaltGroup(SOUND_FX);
+		decoder.drop(SOUND_SOURCES);
+		decoder.drop(SOUND_FX);
 		sound_cache_iterator itor = sound_cache.begin();
 		while(itor != sound_cache.end())
 		{
 			if(itor->group == SOUND_SOURCES || itor->group == SOUND_FX) {
-				itor = sound_cache.erase(itor);
+				itor = erase_cache_chunk(itor);
 			} else {
 				++itor;
 			}
@@ -470,11 +628,13 @@ void stop_bell()
 	if (mix_ok) {
 		Mix_HaltGroup(SOUND_BELL);
 		Mix_HaltGroup(SOUND_TIMER);
+		decoder.drop(SOUND_BELL);
+		decoder.drop(SOUND_TIMER);
 		sound_cache_iterator itor = sound_cache.begin();
 		while(itor != sound_cache.end())
 		{
 			if(itor->group == SOUND_BELL || itor->group == SOUND_TIMER) {
-				itor = sound_cache.erase(itor);
+				itor = erase_cache_chunk(itor);
 			} else {
 				++itor;
 			}
@@ -486,11 +646,12 @@ void stop_UI_sound()
 {
 	if (mix_ok) {
 		Mix_HaltGroup(SOUND_UI);
+		decoder.drop(SOUND_UI);
 		sound_cache_iterator itor = sound_cache.begin();
 		while(itor != sound_cache.end())
 		{
 			if(itor->group == SOUND_UI) {
-				itor = sound_cache.erase(itor);
+				itor = erase_cache_chunk(itor);
 			} else {
 				++itor;
 			}
@@ -617,6 +778,7 @@ void play_music_config(const config &music_node)
 
 void music_thinker::monitor_process() 
 {
+	decoder.pump();
 }
 
 void commit_music_changes()
@@ -694,86 +856,55 @@ void play_sound_positioned(const std::string &files, int id, int repeats, unsign
 
 struct chunk_load_exception { };
 
-static Mix_Chunk* load_chunk(const std::string& file, channel_group group)
+static Mix_Chunk* find_chunk(const std::string& file, channel_group group)
 {
-	sound_cache_iterator it_bgn, it_end;
-	sound_cache_iterator it;
-
-	sound_cache_chunk temp_chunk(file); // search the sound cache on this key
-	it_bgn = sound_cache.begin(), it_end = sound_cache.end();
-	it = std::find(it_bgn, it_end, temp_chunk);
-
-	if (it != it_end) {
-		if(it->group != group) {
-			// cached item has been used in multiple sound groups
-			it->group = NULL_CHANNEL;
-		}
-
-		//splice the most recently used chunk to the front of the cache
-		sound_cache.splice(it_bgn, sound_cache, it);
-	} else {
-		// remove the least recently used chunk from cache if it's full
-		bool cache_full = (sound_cache.size() == max_cached_chunks);
-		while( cache_full && it != it_bgn ) {
-			// make sure this chunk is not being played before freeing it
-			std::vector<Mix_Chunk*>::iterator ch_end = channel_chunks.end();
-			if(std::find(channel_chunks.begin(), ch_end, (--it)->get_data()) == ch_end) {
-				sound_cache.erase(it);
-				cache_full = false;
-			}
-		}
-		if(cache_full) {
-			LOG_AUDIO << "Maximum sound cache size reached and all are busy, skipping.\n";
-			throw chunk_load_exception();
-		}
-		temp_chunk.group = group;
-		std::string const &filename = get_binary_file_location("sounds", file);
-
-		if (!filename.empty()) {
-			temp_chunk.set_data(Mix_LoadWAV(filename.c_str()));
-		} else {
-			ERR_AUDIO << "Could not load sound file '" << file << "'.\n";
-			throw chunk_load_exception();
-		}
-
-		if (temp_chunk.get_data() == NULL) {
-			ERR_AUDIO << "Could not load sound file '" << filename << "': "
-				<< Mix_GetError() << "\n";
-			throw chunk_load_exception();
-		}
+	std::unordered_map<std::string, sound_cache_iterator>::iterator found = sound_cache_index.find(file);
+	if (found == sound_cache_index.end()) {
+		return NULL;
+	}
 
-		sound_cache.push_front(temp_chunk);
+	sound_cache_iterator it = found->second;
+	if (it->group != group) {
+		// cached item has been used in multiple sound groups
+		it->group = NULL_CHANNEL;
 	}
 
-	return sound_cache.begin()->get_data();
+	//splice the most recently used chunk to the front of the cache
+	sound_cache.splice(sound_cache.begin(), sound_cache, it);
+	return it->get_data();
 }
 
-void play_sound_internal(const std::string& files, channel_group group, unsigned int repeats,
-			unsigned int distance, int id, int loop_ticks, int fadein_ticks)
+static Mix_Chunk* insert_chunk(const std::string& file, channel_group group, Mix_Chunk* data)
 {
-	if(files.empty() || distance >= DISTANCE_SILENT || !mix_ok) {
-		return;
+	// if throw, temp_chunk will free data.
+	sound_cache_chunk temp_chunk(file);
+	temp_chunk.group = group;
+	temp_chunk.set_data(data);
+
+	// remove the least recently used chunk from cache if it's full
+	sound_cache_iterator it = sound_cache.end();
+	bool cache_full = (sound_cache.size() == max_cached_chunks);
+	while (cache_full && it != sound_cache.begin()) {
+		// make sure this chunk is not being played before freeing it
+		std::vector<Mix_Chunk*>::iterator ch_end = channel_chunks.end();
+		if (std::find(channel_chunks.begin(), ch_end, (--it)->get_data()) == ch_end) {
+			erase_cache_chunk(it);
+			cache_full = false;
+		}
 	}
-
-	audio_lock lock;
-
-	// find a free channel in the desired group
-	int channel = Mix_GroupAvailable(group);
-	if(channel == -1) {
-		LOG_AUDIO << "All channels dedicated to sound group(" << group << ") are busy, skipping.\n";
-		return;
+	if (cache_full) {
+		LOG_AUDIO << "Maximum sound cache size reached and all are busy, skipping.\n";
+		throw chunk_load_exception();
 	}
 
-	Mix_Chunk *chunk;
-	std::string file = pick_one(files);
-
-	try {
-		chunk = load_chunk(file, group);
-		assert(chunk);
-	} catch (const chunk_load_exception&) {
-		return;
-	}
+	sound_cache.push_front(temp_chunk);
+	sound_cache_index[file] = sound_cache.begin();
+	return data;
+}
 
+static void play_chunk(Mix_Chunk* chunk, int channel, channel_group group, unsigned int repeats,
+			unsigned int distance, int id, int loop_ticks, int fadein_ticks)
+{
 	/*
 	 * This check prevents SDL_Mixer from blowing up on Windows when UI sound is played
 	 * in response to toggling the checkbox which disables sound.
@@ -813,6 +944,121 @@ void play_sound_internal(const std::string& files, channel_group group, unsigned
 	channel_chunks[res] = chunk;
 }
 
+void play_sound_internal(const std::string& files, channel_group group, unsigned int repeats,
+			unsigned int distance, int id, int loop_ticks, int fadein_ticks)
+{
+	if(files.empty() || distance >= DISTANCE_SILENT || !mix_ok) {
+		return;
+	}
+
+	std::string file;
+	{
+		audio_lock lock;
+
+		// find a free channel in the desired group
+		int channel = Mix_GroupAvailable(group);
+		if(channel == -1) {
+			LOG_AUDIO << "All channels dedicated to sound group(" << group << ") are busy, skipping.\n";
+			return;
+		}
+
+		file = pick_one(files);
+		Mix_Chunk* chunk = find_chunk(file, group);
+		if (chunk) {
+			play_chunk(chunk, channel, group, repeats, distance, id, loop_ticks, fadein_ticks);
+			return;
+		}
+	}
+
+	std::string const &filename = get_binary_file_location("sounds", file);
+	if (filename.empty()) {
+		ERR_AUDIO << "Could not load sound file '" << file << "'.\n";
+		return;
+	}
+
+	const chunk_decoder::tplay play = {file, group, repeats, distance, id, loop_ticks, fadein_ticks, SDL_GetTicks()};
+	decoder.decode(filename, play);
+}
+
+}
+
+void chunk_decoder::pump()
+{
+	if (!thread_) {
+		return;
+	}
+	std::vector<std::pair<std::string, Mix_Chunk*> > decoded;
+	{
+		threading::lock lock(mutex_);
+		if (decoded_.empty()) {
+			return;
+		}
+		decoded.swap(decoded_);
+	}
+
+	const Uint32 now = SDL_GetTicks();
+	std::vector<tplay> plays;
+	for (std::vector<std::pair<std::string, Mix_Chunk*> >::const_iterator it = decoded.begin(); it != decoded.end(); ++ it) {
+		const std::string& file = it->first;
+		Mix_Chunk* chunk = it->second;
+
+		plays.clear();
+		for (std::vector<tplay>::iterator it2 = plays_.begin(); it2 != plays_.end(); ) {
+			if (it2->file == file) {
+				plays.push_back(*it2);
+				it2 = plays_.erase(it2);
+			} else {
+				++ it2;
+			}
+		}
+
+		if (!chunk) {
+			ERR_AUDIO << "Could not load sound file '" << file << "'.\n";
+			continue;
+		}
+		if (plays.empty()) {
+			// all plays were dropped.
+			Mix_FreeChunk(chunk);
+			continue;
+		}
+
+		sound::channel_group group = plays.front().group;
+		for (std::vector<tplay>::const_iterator it2 = plays.begin(); it2 != plays.end(); ++ it2) {
+			if (it2->group != group) {
+				group = sound::NULL_CHANNEL;
+			}
+		}
+
+		audio_lock lock;
+		Mix_Chunk* cached = sound::find_chunk(file, group);
+		if (cached) {
+			// decoded twice.
+			Mix_FreeChunk(chunk);
+			chunk = cached;
+		} else {
+			try {
+				chunk = sound::insert_chunk(file, group, chunk);
+			} catch (const sound::chunk_load_exception&) {
+				continue;
+			}
+		}
+
+		for (std::vector<tplay>::const_iterator it2 = plays.begin(); it2 != plays.end(); ++ it2) {
+			const tplay& play = *it2;
+			if (now - play.ticks > max_wait_ms) {
+				continue;
+			}
+			int channel = Mix_GroupAvailable(play.group);
+			if (channel == -1) {
+				continue;
+			}
+			sound::play_chunk(chunk, channel, play.group, play.repeats, play.distance, play.id, play.loop_ticks, play.fadein_ticks);
+		}
+	}
+}
+
+namespace sound {
+
 void play_sound(const std::string& files, channel_group group, unsigned int repeats)
 {
 	if (preferences::sound_on()) {
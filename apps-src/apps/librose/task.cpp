@@ -236,22 +236,16 @@ bool ttask::tsubtask_copy::do_copy(display& disp, const std::string& src_alias,
 				}
 
 				if (r.type == res_dir) {
+					// copy_files_verified will mirror it, needn't delete dst before copy.
 					resolve_res_2_rollback(r.type, dst);
-					// make sure system don't exsit dst! FO_COPY requrie it.
-					if (!SDL_DeleteFiles(dst.c_str())) {
-						symbols["type"] = _("Directory");
-						symbols["dst"] = dst;
-						gui2::show_message(disp.video(), null_str, vgettext2("Delete $type, from $dst fail!", symbols));
-						fok = false;
-						break;
-					}
 				}
 			}
-			if (r.type == res_file || r.type == res_dir) {
+			if (r.type == res_file) {
 				fok = SDL_CopyFiles(src.c_str(), dst.c_str());
-				if (fok && r.type == res_dir) {
-					fok = compare_directory(src, dst);
-				}
+
+			} else if (r.type == res_dir) {
+				fok = copy_files_verified(src, dst, true, true, NULL);
+
 			} else {
 				bool has_resolved = false;
 				if (!is_directory(dst)) {
@@ -261,7 +255,7 @@ bool ttask::tsubtask_copy::do_copy(display& disp, const std::string& src_alias,
 					SDL_MakeDirectory(dst.c_str());
 				}
 				std::set<std::string> files;
-				fok = copy_root_files(src, dst, &files);
+				fok = copy_files_verified(src, dst, false, false, &files);
 				if (!has_resolved) {
 					resolve_res_2_rollback(r.type, dst, &files);
 				}
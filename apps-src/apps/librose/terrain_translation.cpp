@@ -72,6 +72,7 @@ namespace t_translation {
 	 * @return          The converted layer.
 	 */
 	static t_layer string_to_layer_(const std::string& str);
+	static t_layer chars_to_layer_(const char* str, size_t size);
 
 	/**
 	 * Converts a terrain string to a number.
@@ -88,6 +89,12 @@ namespace t_translation {
 	static t_terrain string_to_number_(std::string str, int& start_position, const t_layer filler);
 	static t_terrain string_to_number_(const std::string& str, const t_layer filler = NO_LAYER);
 
+	/**
+	 * Same as string_to_number_ with NO_LAYER filler, but converts the chunk
+	 * [begin, end) of a map string without creating std::string.
+	 */
+	static t_terrain chars_to_map_number_(const char* begin, const char* end, int& start_position);
+
 	/**
 	 * Converts a terrain number to a string
 	 *
@@ -275,34 +282,36 @@ std::string write_list(const t_list& list)
 	return result.str();
 }
 
-t_map read_game_map(const std::string& str,	std::map<int, coordinate>& starting_positions)
+t_grid read_game_map(const char* data, size_t size, std::map<int, coordinate>& starting_positions)
 {
-	t_map result;
+	t_list tiles;
 
-	size_t offset = 0;
+	const char* offset = data;
+	const char* const last = data + size;
 	size_t x = 0, y = 0, width = 0;
 
 	// Skip the leading newlines
-	while(offset < str.length() && utils::isnewline(str[offset])) {
+	while(offset < last && utils::isnewline(*offset)) {
 		++offset;
 	}
 
 	// Did we get an empty map?
-	if((offset + 1) >= str.length()) {
-		return result;
+	if((offset + 1) >= last) {
+		return t_grid();
 	}
 
-	while(offset < str.length()) {
+	while(offset < last) {
 
 		// Get a terrain chunk
-		const std::string separators = ",\n\r";
-		const size_t pos_separator = str.find_first_of(separators, offset);
-		const std::string terrain = str.substr(offset, pos_separator - offset);
+		const char* separator = offset;
+		while(separator < last && *separator != ',' && !utils::isnewline(*separator)) {
+			++separator;
+		}
 
 		// Process the chunk
 		int starting_position = -1;
 		// The tmap never has a wildcard
-		const t_terrain tile = string_to_number_(terrain, starting_position, NO_LAYER);
+		const t_terrain tile = chars_to_map_number_(offset, separator, starting_position);
 
 		// Add to the resulting starting position
 		if(starting_position != -1) {
@@ -318,23 +327,20 @@ t_map read_game_map(const std::string& str,	std::map<int, coordinate>& starting_
 			}
 		}
 
-		// Make space for the new item
-		// NOTE we increase the vector every loop for every x and y.
-		// Profiling with an increase of y with 256 items didn't show
-		// an significant speed increase.
-		// So didn't rework the system to allocate larger vectors at once.
-		if(result.size() <= x) {
-			result.resize(x + 1);
-		}
-		if(result[x].size() <= y) {
-			result[x].resize(y + 1);
+		// rows are read in order, so row-major grid is filled by appending.
+		if(y == 0 && tiles.empty()) {
+			// reserve by length of first line, assume all lines are same.
+			const char* eol = separator;
+			while(eol < last && !utils::isnewline(*eol)) {
+				++eol;
+			}
+			const size_t line_size = eol - offset + 1;
+			tiles.reserve((last - offset) / line_size * (std::count(offset, eol, ',') + 1));
 		}
-
-		// Add the resulting terrain number
-		result[x][y] = tile;
+		tiles.push_back(tile);
 
 		// Evaluate the separator
-		if(pos_separator == std::string::npos || utils::isnewline(str[pos_separator])) {
+		if(separator == last || utils::isnewline(*separator)) {
 			// the first line we set the with the other lines we check the width
 			if(y == 0) {
 				// x contains the offset in the map
@@ -355,21 +361,21 @@ t_map read_game_map(const std::string& str,	std::map<int, coordinate>& starting_
 			x = 0;
 
 			// Avoid in infinite loop if the last line ends without an EOL
-			if(pos_separator == std::string::npos) {
-				offset = str.length();
+			if(separator == last) {
+				offset = last;
 
 			} else {
 
-				offset = pos_separator + 1;
+				offset = separator + 1;
 				// Skip the following newlines
-				while(offset < str.length() && utils::isnewline(str[offset])) {
+				while(offset < last && utils::isnewline(*offset)) {
 					++offset;
 				}
 			}
 
 		} else {
 			++x;
-			offset = pos_separator + 1;
+			offset = separator + 1;
 			if (x > max_map_size()) {
 				ERR_G << "Map size exceeds limit (x > " << max_map_size() << ")\n";
 				throw error("Map width limit exceeded.");
@@ -383,15 +389,31 @@ t_map read_game_map(const std::string& str,	std::map<int, coordinate>& starting_
 		throw error("Map not a rectangle.");
 	}
 
-	return result;
+	if(x != 0) {
+		// map ends with a separator, the last row is incomplete.
+		++y;
+		tiles.resize(width * y);
+	}
+	return t_grid(width, y, tiles);
 }
 
 std::string write_game_map(const t_map& map, std::map<int, coordinate> starting_positions)
+{
+	t_grid grid(map.size(), map.empty()? 0: map[0].size());
+	for(int y = 0; y < grid.h(); ++y) {
+		for(int x = 0; x < grid.w(); ++x) {
+			grid(x, y) = map[x][y];
+		}
+	}
+	return write_game_map(grid, starting_positions);
+}
+
+std::string write_game_map(const t_grid& map, std::map<int, coordinate> starting_positions)
 {
 	std::stringstream str;
 
-	for(size_t y = 0; y < map[0].size(); ++y) {
-		for(size_t x = 0; x < map.size(); ++x) {
+	for(int y = 0; y < map.h(); ++y) {
+		for(int x = 0; x < map.w(); ++x) {
 
 			// If the current location is a starting position,
 			// it needs to be added to the terrain.
@@ -400,7 +422,7 @@ std::string write_game_map(const t_map& map, std::map<int, coordinate> starting_
 			std::map<int, coordinate>::iterator itor = starting_positions.begin();
 			int starting_position = -1;
 			for(; itor != starting_positions.end(); ++itor) {
-				if(itor->second.x == x && itor->second.y == y) {
+				if(itor->second.x == (size_t)x && itor->second.y == (size_t)y) {
 					starting_position = itor->first;
 					starting_positions.erase(itor);
 					break;
@@ -411,7 +433,7 @@ std::string write_game_map(const t_map& map, std::map<int, coordinate> starting_
 			if(x != 0) {
 				str << ", ";
 			}
-			str << number_to_string_(map[x][y], starting_position, 12);
+			str << number_to_string_(map(x, y), starting_position, 12);
 		}
 
 		str << "\n";
@@ -711,21 +733,26 @@ static t_terrain get_mask_(const t_terrain& terrain)
 
 static t_layer string_to_layer_(const std::string& str)
 {
-	if (str.size() == 0)
+	return chars_to_layer_(str.c_str(), str.size());
+}
+
+static t_layer chars_to_layer_(const char* str, size_t size)
+{
+	if (size == 0)
 		return NO_LAYER;
 
 	t_layer result = 0;
 
 	// Validate the string
-	VALIDATE(str.size() <= 4, _("A terrain with a string with more "
-		"than 4 characters has been found, the affected terrain is :") + str);
+	VALIDATE(size <= 4, _("A terrain with a string with more "
+		"than 4 characters has been found, the affected terrain is :") + std::string(str, size));
 
 	// The conversion to int puts the first char
 	// in the highest part of the number.
 	// This will make the wildcard matching
 	// later on a bit easier.
 	for(size_t i = 0; i < 4; ++i) {
-		const unsigned char c = (i < str.length()) ? str[i] : 0;
+		const unsigned char c = (i < size) ? str[i] : 0;
 
 		// Clearing the lower area is a nop on i == 0
 		// so no need for if statement
@@ -790,6 +817,46 @@ static t_terrain string_to_number_(std::string str, int& start_position, const t
 	return result;
 }
 
+static t_terrain chars_to_map_number_(const char* begin, const char* end, int& start_position)
+{
+	// Strip the spaces around us
+	while(begin < end && (*begin == ' ' || *begin == '\t')) {
+		++begin;
+	}
+	while(end > begin && (end[-1] == ' ' || end[-1] == '\t')) {
+		--end;
+	}
+	if(begin == end) {
+		return t_terrain();
+	}
+
+	// Split if we have 1 space inside
+	const char* space = std::find(begin, end, ' ');
+	if(space != end) {
+		// same as lexical_cast<int>
+		char number[16];
+		const size_t size = space - begin;
+		if(size >= sizeof(number)) {
+			return VOID_TERRAIN;
+		}
+		memcpy(number, begin, size);
+		number[size] = '\0';
+		char* endptr;
+		const int value = strtol(number, &endptr, 10);
+		if(*endptr != '\0') {
+			return VOID_TERRAIN;
+		}
+		start_position = value;
+		begin = space + 1;
+	}
+
+	const char* caret = std::find(begin, end, '^');
+	if(caret != end) {
+		return t_terrain(chars_to_layer_(begin, caret - begin), chars_to_layer_(caret + 1, end - caret - 1));
+	}
+	return t_terrain(chars_to_layer_(begin, end - begin), NO_LAYER);
+}
+
 static std::string number_to_string_(t_terrain terrain, const int start_position)
 {
 	std::string result = "";
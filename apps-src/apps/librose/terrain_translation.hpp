@@ -74,6 +74,64 @@ namespace t_translation {
 	typedef std::vector<t_terrain> t_list;
 	typedef std::vector<std::vector<t_terrain> > t_map;
 
+	/**
+	 * Row-major contiguous terrain grid, tile (x, y) is stored at x + y * w.
+	 * border() sets an offset, board(x, y) then addresses (x + border, y + border).
+	 */
+	class t_grid
+	{
+	public:
+		t_grid()
+			: w_(0)
+			, h_(0)
+			, border_(0)
+			, tiles_()
+		{}
+		t_grid(int w, int h, const t_terrain& fill = t_terrain())
+			: w_(w)
+			, h_(h)
+			, border_(0)
+			, tiles_(w * h, fill)
+		{}
+		// take over tiles, they must be row-major and w * h.
+		t_grid(int w, int h, t_list& tiles)
+			: w_(w)
+			, h_(h)
+			, border_(0)
+			, tiles_()
+		{
+			tiles_.swap(tiles);
+		}
+
+		int w() const { return w_; }
+		int h() const { return h_; }
+		bool empty() const { return tiles_.empty(); }
+
+		void set_border(int border) { border_ = border; }
+
+		t_terrain& operator()(int x, int y) { return tiles_[x + y * w_]; }
+		const t_terrain& operator()(int x, int y) const { return tiles_[x + y * w_]; }
+
+		t_terrain& board(int x, int y) { return tiles_[(x + border_) + (y + border_) * w_]; }
+		const t_terrain& board(int x, int y) const { return tiles_[(x + border_) + (y + border_) * w_]; }
+
+		const t_list& tiles() const { return tiles_; }
+
+		void swap(t_grid& that)
+		{
+			std::swap(w_, that.w_);
+			std::swap(h_, that.h_);
+			std::swap(border_, that.border_);
+			tiles_.swap(that.tiles_);
+		}
+
+	private:
+		int w_;
+		int h_;
+		int border_;
+		t_list tiles_;
+	};
+
 	/**
 	 * This structure can be used for matching terrain strings.
 	 * It optimized for strings that need to be matched often,
@@ -208,9 +266,9 @@ namespace t_translation {
 	std::string write_list(const t_list& list);
 
 	/**
-	 * Reads a tmap string into a 2D vector
+	 * Reads a tmap string into a grid, in one pass without copying chunks.
 	 *
-	 * @param str		A string containing the tmap, the following rules
+	 * @param data, size	A string containing the tmap, the following rules
 	 *					are stated for a tmap:
 	 *					* The map is square
 	 *					* The map can be prefixed with one or more empty lines,
@@ -236,10 +294,10 @@ namespace t_translation {
 	 *					* first		the starting locations
 	 *					* second	a coordinate structure where the location was found
 	 *
-	 * @returns			A 2D vector with the terrains found the vector data is stored
-	 *					like result[x][y] where x the column number is and y the row number.
+	 * @returns			A grid with the terrains found, result(x, y) where x the
+	 *					column number is and y the row number.
 	 */
-	t_map read_game_map(const std::string& str, std::map<int, coordinate>& starting_positions);
+	t_grid read_game_map(const char* data, size_t size, std::map<int, coordinate>& starting_positions);
 
 	/**
 	 * Write a tmap in to a vector string.
@@ -252,6 +310,7 @@ namespace t_translation {
 	 *					followed by a comma and space.
 	 */
 	std::string write_game_map(const t_map& map, std::map<int, coordinate> starting_positions = std::map<int, coordinate>());
+	std::string write_game_map(const t_grid& map, std::map<int, coordinate> starting_positions = std::map<int, coordinate>());
 
 	/**
 	 * Tests whether a specific terrain matches a list of expressions.
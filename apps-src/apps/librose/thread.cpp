@@ -19,13 +19,143 @@
 
 #include "log.hpp"
 #include "thread.hpp"
+#include "base_instance.hpp"
 
 #define ERR_G LOG_STREAM(err, lg::general)
 
+ttask_queue::ttask_queue()
+	: posted_(NULL)
+	, pending_()
+	, coalesced_()
+{}
+
+ttask_queue::~ttask_queue()
+{
+	take_posted();
+	for (std::deque<ttask*>::const_iterator it = pending_.begin(); it != pending_.end(); ++ it) {
+		delete *it;
+	}
+}
+
+void ttask_queue::post(const void* owner, const boost::function<void ()>& func, int coalesce)
+{
+	ttask* task = new ttask(owner, func, coalesce);
+	ttask* head = rtc::AtomicOps::AcquireLoadPtr(&posted_);
+	while (true) {
+		task->next = head;
+		ttask* prev = rtc::AtomicOps::CompareAndSwapPtr(&posted_, head, task);
+		if (prev == head) {
+			break;
+		}
+		head = prev;
+	}
+}
+
+void ttask_queue::take_posted()
+{
+	ttask* head = rtc::AtomicOps::AcquireLoadPtr(&posted_);
+	while (head) {
+		ttask* prev = rtc::AtomicOps::CompareAndSwapPtr(&posted_, head, (ttask*)NULL);
+		if (prev == head) {
+			break;
+		}
+		head = prev;
+	}
+
+	// stack is lifo, reverse to post order.
+	ttask* first = NULL;
+	while (head) {
+		ttask* next = head->next;
+		head->next = first;
+		first = head;
+		head = next;
+	}
+
+	for (ttask* task = first; task; task = task->next) {
+		if (task->coalesce != no_coalesce) {
+			ttask*& latest = coalesced_[std::make_pair(task->owner, task->coalesce)];
+			if (latest) {
+				latest->dropped = true;
+			}
+			latest = task;
+		}
+		pending_.push_back(task);
+	}
+}
+
+void ttask_queue::release_coalesced(const ttask& task)
+{
+	if (task.coalesce == no_coalesce) {
+		return;
+	}
+	std::map<std::pair<const void*, int>, ttask*>::iterator it = coalesced_.find(std::make_pair(task.owner, task.coalesce));
+	if (it != coalesced_.end() && it->second == &task) {
+		coalesced_.erase(it);
+	}
+}
+
+void ttask_queue::pump()
+{
+	take_posted();
+
+	// func maybe pump again, so pop before run. tasks posted during this pump wait for next.
+	size_t max_tasks = pending_.size();
+	for (; max_tasks > 0 && !pending_.empty(); -- max_tasks) {
+		std::unique_ptr<ttask> task(pending_.front());
+		pending_.pop_front();
+		release_coalesced(*task);
+		if (!task->dropped) {
+			task->func();
+		}
+	}
+}
+
+void ttask_queue::cancel(const void* owner)
+{
+	take_posted();
+
+	for (std::deque<ttask*>::iterator it = pending_.begin(); it != pending_.end(); ) {
+		ttask* task = *it;
+		if (task->owner == owner) {
+			release_coalesced(*task);
+			delete task;
+			it = pending_.erase(it);
+		} else {
+			++ it;
+		}
+	}
+}
+
 namespace rtc {
 void worker_thread::DoWork() { worker_.DoWork(); }
 void worker_thread::OnWorkStart() { worker_.OnWorkStart(); }
-void worker_thread::OnWorkDone() { worker_.OnWorkDone(); }
+void worker_thread::OnWorkDone()
+{
+	// let tasks posted by DoWork run before done.
+	instance->tasks().pump();
+	worker_.OnWorkDone();
+}
+}
+
+tworker::~tworker()
+{
+	thread_->Destroy(true);
+	thread_ = NULL;
+
+	// thread is stopped, drop tasks that would call this destructed worker.
+	if (instance) {
+		main_tasks().cancel(this);
+	}
+}
+
+ttask_queue& tworker::main_tasks()
+{
+	return instance->tasks();
+}
+
+void tworker::post_main(const boost::function<void ()>& func, int coalesce)
+{
+	main_tasks().post(this, func, coalesce);
 }
 
 namespace threading {
@@ -20,12 +20,78 @@
 #include "SDL_thread.h"
 
 #include <list>
+#include <deque>
+#include <map>
+#include <future>
 
 #include <boost/scoped_ptr.hpp>
 #include <boost/smart_ptr.hpp>
+#include <boost/function.hpp>
+#include <boost/bind.hpp>
 
 #include "webrtc/base/signalthread.h"
 #include "webrtc/base/bind.h"
+#include "webrtc/base/atomicops.h"
+
+// closures posted by any thread, run by one consumer thread.
+// producers push to a lock-free stack, consumer takes the whole stack and runs them in post order.
+class ttask_queue
+{
+public:
+	enum {no_coalesce = 0};
+
+	ttask_queue();
+	~ttask_queue();
+
+	// any thread. when coalesce isn't no_coalesce, a not-yet-run task of same owner and coalesce
+	// is dropped, only the latest runs. fit for progress.
+	void post(const void* owner, const boost::function<void ()>& func, int coalesce = no_coalesce);
+
+	// any thread. future is ready after consumer runs func.
+	// if owner is cancelled before that, future's get throws broken_promise.
+	template <typename R>
+	std::future<R> invoke_async(const void* owner, const boost::function<R ()>& func)
+	{
+		std::shared_ptr<std::packaged_task<R ()> > task(new std::packaged_task<R ()>(func));
+		std::future<R> result = task->get_future();
+		post(owner, boost::bind(&ttask_queue::run_packaged<R>, task));
+		return result;
+	}
+
+	// below are consumer thread only.
+	void pump();
+	void cancel(const void* owner);
+
+private:
+	struct ttask
+	{
+		ttask(const void* owner, const boost::function<void ()>& func, int coalesce)
+			: owner(owner)
+			, func(func)
+			, coalesce(coalesce)
+			, dropped(false)
+			, next(NULL)
+		{}
+
+		const void* owner;
+		boost::function<void ()> func;
+		int coalesce;
+		bool dropped;
+		ttask* next;
+	};
+
+	template <typename R>
+	static void run_packaged(std::shared_ptr<std::packaged_task<R ()> > task) { (*task)(); }
+
+	void take_posted();
+	void release_coalesced(const ttask& task);
+
+private:
+	ttask* volatile posted_;
+	std::deque<ttask*> pending_;
+	// latest coalesced task of owner in pending_.
+	std::map<std::pair<const void*, int>, ttask*> coalesced_;
+};
 
 class tworker;
 
@@ -61,12 +127,21 @@ protected:
 		: main_(rtc::Thread::Current())
 		, thread_(new rtc::worker_thread(*this))
 	{}
-	virtual ~tworker()
+	virtual ~tworker();
+
+	// run func in main thread by base_instance::pump, worker thread doesn't wait for it.
+	void post_main(const boost::function<void ()>& func, int coalesce = ttask_queue::no_coalesce);
+
+	// like post_main, but worker can wait for result when it requires.
+	template <typename R>
+	std::future<R> invoke_main(const boost::function<R ()>& func)
 	{
-		thread_->Destroy(true);
-		thread_ = NULL;
+		return main_tasks().invoke_async<R>(this, func);
 	}
 
+private:
+	static ttask_queue& main_tasks();
+
 protected:
 	rtc::Thread* main_;
 	rtc::worker_thread* thread_;
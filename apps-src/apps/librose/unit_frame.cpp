@@ -21,59 +21,91 @@
 #include "serialization/string_utils.hpp"
 #include "unit_frame.hpp"
 
+progressive_timeline::progressive_timeline()
+	: starts_(1, 0)
+	, monotonic_(true)
+	, cursor_(0)
+{}
+
+void progressive_timeline::push(int duration)
+{
+	if (duration < 0) {
+		monotonic_ = false;
+	}
+	starts_.push_back(starts_.back() + duration);
+}
+
+bool progressive_timeline::is_boundary(size_t at, int time) const
+{
+	const size_t segments = starts_.size() - 1;
+	return (at == segments || starts_[at] >= time) && (at == 0 || starts_[at - 1] < time);
+}
+
+size_t progressive_timeline::segment(int time) const
+{
+	// at is the first boundary not before time, capped to the end.
+	const size_t segments = starts_.size() - 1;
+	size_t at;
+	if (!monotonic_) {
+		at = 0;
+		while (at < segments && starts_[at] < time) {
+			at ++;
+		}
+
+	} else if (cursor_ <= segments && is_boundary(cursor_, time)) {
+		at = cursor_;
+
+	} else if (cursor_ < segments && is_boundary(cursor_ + 1, time)) {
+		at = cursor_ + 1;
+
+	} else {
+		at = std::lower_bound(starts_.begin(), starts_.end(), time) - starts_.begin();
+		if (at > segments) {
+			at = segments;
+		}
+	}
+	cursor_ = at;
+	return at? at - 1: 0;
+}
+
 progressive_string::progressive_string(const std::string & data,int duration) :
-	data_(),
+	values_(),
+	timeline_(),
 	input_(data)
 {
 		const std::vector<std::string> first_pass = utils::split(data);
 		const int time_chunk = std::max<int>(duration / (first_pass.size()?first_pass.size():1),1);
 
+		values_.reserve(first_pass.size());
 		std::vector<std::string>::const_iterator tmp;
 		for(tmp=first_pass.begin();tmp != first_pass.end() ; ++tmp) {
 			std::vector<std::string> second_pass = utils::split(*tmp,':');
-			if(second_pass.size() > 1) {
-				data_.push_back(std::pair<std::string,int>(second_pass[0],atoi(second_pass[1].c_str())));
-			} else {
-				data_.push_back(std::pair<std::string,int>(second_pass[0],time_chunk));
-			}
+			values_.push_back(second_pass[0]);
+			timeline_.push(second_pass.size() > 1? atoi(second_pass[1].c_str()): time_chunk);
 		}
 }
-int progressive_string::duration() const
-{
-	int total =0;
-	std::vector<std::pair<std::string,int> >::const_iterator cur_halo;
-	for(cur_halo = data_.begin() ; cur_halo != data_.end() ; ++cur_halo) {
-		total += cur_halo->second;
-	}
-	return total;
-
-}
 
 static const std::string empty_string;
 
 const std::string& progressive_string::get_current_element(int current_time)const
 {
-	int time = 0;
-	unsigned int sub_halo = 0;
-	if(data_.empty()) return empty_string;
-	while(time < current_time&& sub_halo < data_.size()) {
-		time += data_[sub_halo].second;
-		++sub_halo;
-
-	}
-	if(sub_halo) sub_halo--;
-	return data_[sub_halo].first;
+	if(values_.empty()) return empty_string;
+	return values_[timeline_.segment(current_time)];
 }
 
 template <class T>
 progressive_<T>::progressive_(const std::string &data, int duration) :
-	data_(),
+	from_(),
+	to_(),
+	timeline_(),
 	input_(data)
 {
 	int split_flag = utils::REMOVE_EMPTY; // useless to strip spaces
 	const std::vector<std::string> comma_split = utils::split(data,',',split_flag);
 	const int time_chunk = std::max<int>(1, duration / std::max<int>(comma_split.size(),1));
 
+	from_.reserve(comma_split.size());
+	to_.reserve(comma_split.size());
 	std::vector<std::string>::const_iterator com_it = comma_split.begin();
 	for(; com_it != comma_split.end(); ++com_it) {
 		std::vector<std::string> colon_split = utils::split(*com_it,':',split_flag);
@@ -82,55 +114,36 @@ progressive_<T>::progressive_(const std::string &data, int duration) :
 		std::vector<std::string> range = utils::split(colon_split[0],'~',split_flag);
 		T range0 = lexical_cast<T>(range[0]);
 		T range1 = (range.size() > 1) ? lexical_cast<T>(range[1]) : range0;
-		typedef std::pair<T,T> range_pair;
-		data_.push_back(std::pair<range_pair,int>(range_pair(range0, range1), time));
+		from_.push_back(range0);
+		to_.push_back(range1);
+		timeline_.push(time);
 	}
 }
 
 template <class T>
 const T progressive_<T>::get_current_element(int current_time, T default_val) const
 {
-	int time = 0;
-	unsigned int sub_halo = 0;
 	int searched_time = current_time;
 	if(searched_time < 0) searched_time = 0;
 	if(searched_time > duration()) searched_time = duration();
-	if(data_.empty()) return default_val;
-	while(time < searched_time&& sub_halo < data_.size()) {
-		time += data_[sub_halo].second;
-		++sub_halo;
+	if(from_.empty()) return default_val;
 
-	}
-	if(sub_halo != 0) {
-		sub_halo--;
-		time -= data_[sub_halo].second;
-	}
+	const size_t sub_halo = timeline_.segment(searched_time);
+	const int time = timeline_.start(sub_halo);
 
-	const T first =  data_[sub_halo].first.first;
-	const T second =  data_[sub_halo].first.second;
+	const T first =  from_[sub_halo];
+	const T second =  to_[sub_halo];
 
 	return T((static_cast<double>(searched_time - time) /
-		static_cast<double>(data_[sub_halo].second)) *
+		static_cast<double>(timeline_.length(sub_halo))) *
 		(second - first) + first);
 }
 
-template<class T>
-int progressive_<T>::duration() const
-{
-	int total = 0;
-	typename std::vector<std::pair<std::pair<T, T>, int> >::const_iterator cur_halo;
-	for(cur_halo = data_.begin() ; cur_halo != data_.end() ; ++cur_halo) {
-		total += cur_halo->second;
-	}
-	return total;
-
-}
-
 template <class T>
 bool progressive_<T>::does_not_change() const
 {
-return data_.empty() ||
-	( data_.size() == 1 && data_[0].first.first == data_[0].first.second);
+return from_.empty() ||
+	( from_.size() == 1 && from_[0] == to_[0]);
 }
 
 // Force compilation of the following template instantiations
@@ -25,26 +25,51 @@
 
 class config;
 
+/**
+ * cumulative start times of a progressive parameter's segments.
+ * starts_[i] is when segment i begins, starts_.back() the total duration.
+ */
+class progressive_timeline {
+	public:
+		progressive_timeline();
+		void push(int duration);
+		int duration() const { return starts_.back(); }
+		int start(size_t segment) const { return starts_[segment]; }
+		int length(size_t segment) const { return starts_[segment + 1] - starts_[segment]; }
+		/** the last segment starting before time, or the first one */
+		size_t segment(int time) const;
+	private:
+		bool is_boundary(size_t at, int time) const;
+
+		std::vector<int> starts_;
+		bool monotonic_;
+		// boundary of the last query, playback usually asks the same or the next one.
+		mutable size_t cursor_;
+};
+
 class progressive_string {
 	public:
 		progressive_string(const std::string& data = "",int duration = 0);
-		int duration() const;
+		int duration() const { return timeline_.duration(); }
 		const std::string & get_current_element(int time) const;
-		bool does_not_change() const { return data_.size() <= 1; }
+		bool does_not_change() const { return values_.size() <= 1; }
 		std::string get_original() const { return input_; }
 	private:
-		std::vector<std::pair<std::string,int> > data_;
+		std::vector<std::string> values_;
+		progressive_timeline timeline_;
 		std::string input_;
 };
 
 template <class T>
 class progressive_
 {
-	std::vector<std::pair<std::pair<T, T>, int> > data_;
+	std::vector<T> from_;
+	std::vector<T> to_;
+	progressive_timeline timeline_;
 	std::string input_;
 public:
 	progressive_(const std::string& data = "", int duration = 0);
-	int duration() const;
+	int duration() const { return timeline_.duration(); }
 	const T get_current_element(int time,T default_val=0) const;
 	bool does_not_change() const;
 	std::string get_original() const { return input_; }
@@ -30,6 +30,9 @@
 #include "display.hpp"
 #include "gettext.hpp"
 #include "base_instance.hpp"
+#include "filesystem.hpp"
+#include "integrate.hpp"
+#include "gui/widgets/settings.hpp"
 #include <boost/foreach.hpp>
 #include <vector>
 #include <map>
@@ -95,6 +98,8 @@ SDL_Renderer* renderer = NULL;
 SDL_Window* window = NULL;
 texture frameTexture = NULL;
 texture whiteTexture;
+// scratch target reused by every scroll, size is at least requested.
+texture scrollTexture;
 int frame_width = 0;
 int frame_height = 0;
 }
@@ -114,6 +119,20 @@ texture& get_white_texture()
 	return whiteTexture;
 }
 
+texture& get_scroll_texture(int w, int h)
+{
+	int width = 0, height = 0;
+	if (scrollTexture.get()) {
+		SDL_QueryTexture(scrollTexture.get(), NULL, NULL, &width, &height);
+	}
+	if (width < w || height < h) {
+		// map area rarely changes, allocate once for it.
+		scrollTexture = SDL_CreateTexture(renderer, get_screen_format().format, SDL_TEXTUREACCESS_TARGET, std::max(width, w), std::max(height, h));
+		SDL_SetTextureBlendMode(scrollTexture.get(), SDL_BLENDMODE_NONE);
+	}
+	return scrollTexture;
+}
+
 int get_screen_width()
 {
 	return frame_width;
@@ -138,6 +157,7 @@ static void clear_textures()
 
 	frameTexture = NULL;
 	whiteTexture = NULL;
+	scrollTexture = NULL;
 }
 
 const SDL_PixelFormat& get_screen_format()
@@ -323,6 +343,26 @@ const SDL_PixelFormat& CVideo::getformat() const
 	return get_neutral_pixel_format();
 }
 
+static void draw_profile_overlay(SDL_Renderer* renderer, const tframe_profiler& profiler)
+{
+	// rendering text every frame is too slow, refresh it some frames.
+	static const int refresh_frames = 30;
+	static surface overlay;
+	static int frames = 0;
+	if (!overlay || ++ frames >= refresh_frames) {
+		// text differs every time, get_rendered_text2 would fill its layout cache with them.
+		tintegrate integrate(profiler.overlay_text(), gui2::settings::screen_width, -1, font::SIZE_SMALL, font::GOOD_COLOR);
+		overlay = integrate.get_surface();
+		frames = 0;
+	}
+	if (overlay) {
+		// overlay is rendered on screen only, frame buffer keeps clean.
+		SDL_Rect dst = ::create_rect(0, 0, overlay->w, overlay->h);
+		render_rect(renderer, dst, SDL_MapRGBA(&get_screen_format(), 0, 0, 0, 160));
+		render_surface(renderer, overlay, NULL, &dst);
+	}
+}
+
 void CVideo::flip()
 {
     // when enable background audio, will enter it during background.
@@ -330,10 +370,24 @@ void CVideo::flip()
         return;
     }
 
-	texture null_tex;
-	trender_target_lock lock(renderer, null_tex);
-	SDL_RenderCopy(renderer, frameTexture.get(), NULL, NULL);
-	SDL_RenderPresent(renderer);
+	tframe_profiler& profiler = get_frame_profiler();
+	{
+		texture null_tex;
+		trender_target_lock lock(renderer, null_tex);
+		{
+			tprofile_scope scope("flip");
+			SDL_RenderCopy(renderer, frameTexture.get(), NULL, NULL);
+		}
+		// out of any scope, profiler doesn't count its own drawing.
+		if (profiler.enabled()) {
+			draw_profile_overlay(renderer, profiler);
+		}
+		{
+			tprofile_scope scope("present");
+			SDL_RenderPresent(renderer);
+		}
+	}
+	profiler.frame_end();
 }
 
 void CVideo::lock_updates(bool value)
@@ -414,3 +468,201 @@ surface render_scale_surface(const surface &surf, int w, int h)
 
 	return dst;
 }
+
+tframe_profiler::tframe_profiler()
+	: enabled_(false)
+	, depth_(0)
+	, pending_end_(false)
+	, current_()
+	, frames_()
+	, next_frame_(0)
+	, worst_()
+{
+}
+
+tframe_profiler& get_frame_profiler()
+{
+	static tframe_profiler profiler;
+	return profiler;
+}
+
+uint64_t tframe_profiler::now_us()
+{
+	static const uint64_t frequency = SDL_GetPerformanceFrequency();
+	const uint64_t counter = SDL_GetPerformanceCounter();
+	// split to avoid overflow of counter * 1000000.
+	return counter / frequency * 1000000 + counter % frequency * 1000000 / frequency;
+}
+
+void tframe_profiler::set_enabled(bool value)
+{
+	if (value == enabled_) {
+		return;
+	}
+	if (!value) {
+		save_spike_trace();
+	}
+	enabled_ = value;
+	depth_ = 0;
+	pending_end_ = false;
+	current_ = tframe();
+	frames_.clear();
+	next_frame_ = 0;
+	worst_ = tframe();
+}
+
+int tframe_profiler::push(const char* name)
+{
+	const uint64_t now = now_us();
+	if (current_.scopes.empty()) {
+		current_.start_us = now;
+	}
+	current_.scopes.push_back(tscope(name, depth_ ++, now));
+	return current_.scopes.size() - 1;
+}
+
+void tframe_profiler::pop(int at)
+{
+	if (!enabled_ || at >= (int)current_.scopes.size() || !depth_) {
+		return;
+	}
+	tscope& scope = current_.scopes[at];
+	scope.duration_us = now_us() - scope.start_us;
+	depth_ --;
+	if (!depth_ && pending_end_) {
+		frame_end();
+	}
+}
+
+void tframe_profiler::count(const char* name, int value)
+{
+	if (enabled_) {
+		current_.counters.push_back(std::make_pair(name, value));
+	}
+}
+
+void tframe_profiler::frame_end()
+{
+	if (!enabled_ || current_.scopes.empty()) {
+		return;
+	}
+	if (depth_) {
+		// flip inside a scope, end frame when outermost scope exits.
+		pending_end_ = true;
+		return;
+	}
+	pending_end_ = false;
+	current_.duration_us = now_us() - current_.start_us;
+
+	bool spike = current_.duration_us >= (uint64_t)spike_threshold_us && current_.duration_us > worst_.duration_us;
+	if (spike) {
+		worst_ = current_;
+	}
+	if ((int)frames_.size() < max_frames) {
+		frames_.push_back(tframe());
+	}
+	frames_[next_frame_].swap(current_);
+	next_frame_ = (next_frame_ + 1) % max_frames;
+	current_ = tframe();
+}
+
+void tframe_profiler::save_spike_trace() const
+{
+	if (worst_.duration_us) {
+		export_trace(get_user_data_dir() + "/frame-trace.json");
+	}
+}
+
+std::string tframe_profiler::overlay_text() const
+{
+	struct tstat {
+		tstat() : depth(0), total_us(0), max_us(0) {}
+		int depth;
+		uint64_t total_us;
+		uint64_t max_us;
+	};
+	// keep stages in order of first appearance.
+	std::vector<std::string> names;
+	std::map<std::string, tstat> stats;
+	uint64_t frame_total_us = 0, frame_max_us = 0;
+
+	for (std::vector<tframe>::const_iterator it = frames_.begin(); it != frames_.end(); ++ it) {
+		const tframe& frame = *it;
+		frame_total_us += frame.duration_us;
+		frame_max_us = std::max(frame_max_us, frame.duration_us);
+
+		// sum up scopes with same name in one frame first.
+		std::map<std::string, uint64_t> frame_us;
+		for (std::vector<tscope>::const_iterator it2 = frame.scopes.begin(); it2 != frame.scopes.end(); ++ it2) {
+			const tscope& scope = *it2;
+			std::map<std::string, tstat>::iterator find_it = stats.find(scope.name);
+			if (find_it == stats.end()) {
+				names.push_back(scope.name);
+				find_it = stats.insert(std::make_pair(scope.name, tstat())).first;
+				find_it->second.depth = scope.depth;
+			}
+			frame_us[scope.name] += scope.duration_us;
+		}
+		for (std::map<std::string, uint64_t>::const_iterator it2 = frame_us.begin(); it2 != frame_us.end(); ++ it2) {
+			tstat& stat = stats.find(it2->first)->second;
+			stat.total_us += it2->second;
+			stat.max_us = std::max(stat.max_us, it2->second);
+		}
+	}
+
+	std::stringstream strstr;
+	const int frames = std::max<int>(frames_.size(), 1);
+	strstr << "frame(" << frames_.size() << "): avg " << frame_total_us / frames / 1000 << "ms, max " << frame_max_us / 1000 << "ms";
+	if (worst_.duration_us) {
+		strstr << ", spike " << worst_.duration_us / 1000 << "ms";
+	}
+	for (std::vector<std::string>::const_iterator it = names.begin(); it != names.end(); ++ it) {
+		const tstat& stat = stats.find(*it)->second;
+		strstr << "\n" << std::string(stat.depth * 2, ' ') << *it << ": avg " << stat.total_us / frames / 1000.0 << "ms, max " << stat.max_us / 1000.0 << "ms";
+	}
+	if (!frames_.empty()) {
+		const tframe& last = frames_[(next_frame_ + max_frames - 1) % max_frames];
+		for (std::vector<std::pair<const char*, int> >::const_iterator it = last.counters.begin(); it != last.counters.end(); ++ it) {
+			strstr << "\n" << it->first << ": " << it->second;
+		}
+	}
+	return strstr.str();
+}
+
+void tframe_profiler::write_frame(std::stringstream& strstr, const tframe& frame, bool& first) const
+{
+	for (std::vector<tscope>::const_iterator it = frame.scopes.begin(); it != frame.scopes.end(); ++ it) {
+		const tscope& scope = *it;
+		strstr << (first? "\n": ",\n");
+		strstr << "{\"name\":\"" << scope.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":" << scope.start_us << ",\"dur\":" << scope.duration_us << "}";
+		first = false;
+	}
+	for (std::vector<std::pair<const char*, int> >::const_iterator it = frame.counters.begin(); it != frame.counters.end(); ++ it) {
+		strstr << (first? "\n": ",\n");
+		strstr << "{\"name\":\"" << it->first << "\",\"ph\":\"C\",\"pid\":1,\"ts\":" << frame.start_us << ",\"args\":{\"value\":" << it->second << "}}";
+		first = false;
+	}
+}
+
+bool tframe_profiler::export_trace(const std::string& file) const
+{
+	// chrome trace event format, open it in chrome://tracing.
+	std::stringstream strstr;
+	bool first = true;
+	strstr << "{\"traceEvents\":[";
+	// oldest frame first.
+	const size_t size = frames_.size();
+	const size_t start = (int)size < max_frames? 0: next_frame_;
+	for (size_t n = 0; n < size; n ++) {
+		write_frame(strstr, frames_[(start + n) % size], first);
+	}
+	if (worst_.duration_us && (size == 0 || worst_.start_us < frames_[start].start_us)) {
+		// worst spike has left recent frames.
+		write_frame(strstr, worst_, first);
+	}
+	strstr << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+	const std::string str = strstr.str();
+	write_file(file, str.c_str(), str.size());
+	return file_exists(file);
+}
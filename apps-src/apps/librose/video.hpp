@@ -20,12 +20,15 @@
 #include "lua_jailbreak_exception.hpp"
 
 #include <boost/utility.hpp>
+#include <sstream>
 
 struct surface;
 struct texture;
 
 texture& get_screen_texture();
 texture& get_white_texture();
+// persistent render target for scroll, valid until renderer is recreated.
+texture& get_scroll_texture(int w, int h);
 int get_screen_width();
 int get_screen_height();
 SDL_Rect screen_area();
@@ -129,4 +132,107 @@ private:
 	bool unlock;
 };
 
+// hierarchical scope profiler of frames. scopes are recorded between two
+// CVideo::flip, nested by order of construction.
+class tframe_profiler: private boost::noncopyable
+{
+public:
+	// recent frames kept for overlay and trace.
+	static const int max_frames = 120;
+	// frame longer than it is a spike, and dumped to trace file.
+	static const int spike_threshold_us = 50000;
+
+	struct tscope {
+		tscope(const char* name, int depth, uint64_t start_us)
+			: name(name)
+			, depth(depth)
+			, start_us(start_us)
+			, duration_us(0)
+		{}
+
+		const char* name;
+		int depth;
+		uint64_t start_us;
+		uint64_t duration_us;
+	};
+
+	struct tframe {
+		tframe()
+			: start_us(0)
+			, duration_us(0)
+			, scopes()
+			, counters()
+		{}
+
+		void swap(tframe& that)
+		{
+			std::swap(start_us, that.start_us);
+			std::swap(duration_us, that.duration_us);
+			scopes.swap(that.scopes);
+			counters.swap(that.counters);
+		}
+
+		uint64_t start_us;
+		uint64_t duration_us;
+		std::vector<tscope> scopes;
+		std::vector<std::pair<const char*, int> > counters;
+	};
+
+	tframe_profiler();
+
+	void set_enabled(bool value);
+	bool enabled() const { return enabled_; }
+
+	int push(const char* name);
+	void pop(int at);
+	void count(const char* name, int value);
+	void frame_end();
+
+	// per-stage avg/max of recent frames, one line per stage.
+	std::string overlay_text() const;
+	bool export_trace(const std::string& file) const;
+	// write to <user data>/frame-trace.json when there was a spike, so device can be investigated later.
+	// file i/o, don't call it in frame loop. called when disabled and when app exits.
+	void save_spike_trace() const;
+
+private:
+	static uint64_t now_us();
+	void write_frame(std::stringstream& strstr, const tframe& frame, bool& first) const;
+
+private:
+	bool enabled_;
+	int depth_;
+	// flip happened when scopes were open.
+	bool pending_end_;
+	tframe current_;
+	// ring buffer of finished frames.
+	std::vector<tframe> frames_;
+	size_t next_frame_;
+	tframe worst_;
+};
+
+tframe_profiler& get_frame_profiler();
+
+class tprofile_scope
+{
+public:
+	explicit tprofile_scope(const char* name)
+		: at_(-1)
+	{
+		tframe_profiler& profiler = get_frame_profiler();
+		if (profiler.enabled()) {
+			at_ = profiler.push(name);
+		}
+	}
+	~tprofile_scope()
+	{
+		if (at_ != -1) {
+			get_frame_profiler().pop(at_);
+		}
+	}
+
+private:
+	int at_;
+};
+
 #endif
@@ -449,6 +449,8 @@ void wml_config_from_file(const std::string &fname, config &cfg, uint32_t* nfile
 	posix_fread(lock.fp, lock.data, data_len);
 
 	wml_config_from_data((uint8_t*)lock.data, data_len, namebuf, valbuf, tdomain, cfg);
+	// no reference to the children built above is held any longer.
+	cfg.make_shareable();
 
 	if (namebuf) {
 		free(namebuf);
@@ -530,478 +532,426 @@ wml_building_rules_from_fileֻ
 1ԹӦòwml_building_rules_from_filebuilding_rules_.clear⡣ʹһյruleswml_building_rules_from_fileЧʲûı䡣
 */
 
-// @size: ֵѾЧ
-#define t_list_to_fp(fp, list, idx, size)	do {	\
-	for (idx = 0; idx < size; idx ++) {	\
-		posix_fwrite(fp, &(list)[idx].base, sizeof(t_translation::t_layer));	\
-		posix_fwrite(fp, &(list)[idx].overlay, sizeof(t_translation::t_layer));	\
-	}	\
-} while (0)
-
-//   2.1.ַܵһ,hi8(hi16(u32))ֵӴĿ,0
-//   2.2.lo16(u32)Ӵַ
-#define vstr_to_fp(fp, vstr, idx, size, u32n, max_str_len) do {	\
-	size = (vstr).size();	\
-	posix_fwrite(fp, &size, sizeof(size));	\
-	for (idx = 0; idx < size; idx ++) {	\
-		u32n = (vstr)[idx].size();	\
-		posix_fwrite(fp, &u32n, sizeof(u32n));	\
-		posix_fwrite(fp, (vstr)[idx].c_str(), u32n);	\
-		max_str_len = posix_max(max_str_len, u32n);	\
-	}	\
-} while (0)
+// tb-*.dat, after 16 bytes checksum header is ttb_header, then sections in order:
+// rules, constraints, terrains, flags, images, variants, string offsets and chars.
+// records refer to each other by index, every field is 4 bytes, so one read restores all.
+// version is at where previous format saved max_str_len, stale file fails wml_building_rules_current.
+#define TB_DAT_VERSION		mmioFOURCC('T', 'B', '0', '2')
+
+struct ttb_header {
+	uint32_t version;
+	uint32_t rules;
+	uint32_t constraints;
+	uint32_t terrains;
+	uint32_t flags;
+	uint32_t images;
+	uint32_t variants;
+	uint32_t strings;
+	uint32_t chars;
+};
+
+struct ttb_rule {
+	int32_t precedence;
+	int32_t x, y;
+	int32_t probability;
+	uint32_t constraint, constraints;
+};
+
+struct ttb_constraint {
+	int32_t x, y;
+	// terrain, mask and masked_terrain are saved one after another, each has terrains items.
+	uint32_t terrain, terrains;
+	uint32_t has_wildcard, is_empty;
+	uint32_t set_flag, set_flags;
+	uint32_t no_flag, no_flags;
+	uint32_t has_flag, has_flags;
+	uint32_t image, images;
+};
+
+struct ttb_terrain {
+	uint32_t base;
+	uint32_t overlay;
+};
+
+struct ttb_image {
+	int32_t layer;
+	int32_t basex, basey;
+	uint32_t global_image;
+	int32_t center_x, center_y;
+	uint32_t variant, variants;
+};
+
+// strings are index of string offsets.
+struct ttb_variant {
+	uint32_t image_string;
+	uint32_t variations;
+	uint32_t random_start;
+};
+
+class ttb_writer
+{
+public:
+	ttb_writer()
+		: rules()
+		, constraints()
+		, terrains()
+		, flags()
+		, images()
+		, variants()
+		, offsets()
+		, chars()
+		, pool_()
+	{}
+
+	void add(const terrain_builder::building_rule& rule);
+
+	std::vector<ttb_rule> rules;
+	std::vector<ttb_constraint> constraints;
+	std::vector<ttb_terrain> terrains;
+	std::vector<uint32_t> flags;
+	std::vector<ttb_image> images;
+	std::vector<ttb_variant> variants;
+	std::vector<uint32_t> offsets;
+	std::string chars;
+
+private:
+	uint32_t add_string(const std::string& str);
+	void add_flags(const std::vector<std::string>& vstr, uint32_t& first, uint32_t& size);
+	void add_terrains(const t_translation::t_list& list);
+
+private:
+	// flag and image strings repeat a lot among rules, save every one once.
+	std::map<std::string, uint32_t> pool_;
+};
+
+uint32_t ttb_writer::add_string(const std::string& str)
+{
+	std::map<std::string, uint32_t>::const_iterator it = pool_.find(str);
+	if (it != pool_.end()) {
+		return it->second;
+	}
+	uint32_t id = offsets.size();
+	offsets.push_back(chars.size());
+	// include terminate 0, string can be used in place.
+	chars.append(str.c_str(), str.size() + 1);
+	pool_.insert(std::make_pair(str, id));
+	return id;
+}
 
-void wml_building_rules_to_file(const std::string& fname, terrain_builder::building_rule* rules, uint32_t rules_size, uint32_t nfiles, uint32_t sum_size, uint32_t modified)
+void ttb_writer::add_flags(const std::vector<std::string>& vstr, uint32_t& first, uint32_t& size)
+{
+	first = flags.size();
+	size = vstr.size();
+	for (std::vector<std::string>::const_iterator it = vstr.begin(); it != vstr.end(); ++ it) {
+		flags.push_back(add_string(*it));
+	}
+}
+
+void ttb_writer::add_terrains(const t_translation::t_list& list)
+{
+	for (t_translation::t_list::const_iterator it = list.begin(); it != list.end(); ++ it) {
+		ttb_terrain terrain = {it->base, it->overlay};
+		terrains.push_back(terrain);
+	}
+}
+
+void ttb_writer::add(const terrain_builder::building_rule& rule)
+{
+	ttb_rule r;
+	r.precedence = rule.precedence;
+	r.x = rule.location_constraints.x;
+	r.y = rule.location_constraints.y;
+	r.probability = rule.probability;
+	r.constraint = constraints.size();
+	r.constraints = rule.constraints.size();
+	rules.push_back(r);
+
+	for (terrain_builder::constraint_set::const_iterator constraint = rule.constraints.begin(); constraint != rule.constraints.end(); ++ constraint) {
+		const t_translation::t_match& match = constraint->terrain_types_match;
+		ttb_constraint c;
+		c.x = constraint->loc.x;
+		c.y = constraint->loc.y;
+
+		// terrain, mask and masked_terrain must be same size.
+		c.terrain = terrains.size();
+		c.terrains = match.terrain.size();
+		add_terrains(match.terrain);
+		add_terrains(match.mask);
+		add_terrains(match.masked_terrain);
+		c.has_wildcard = match.has_wildcard? 1: 0;
+		c.is_empty = match.is_empty? 1: 0;
+
+		add_flags(constraint->set_flag, c.set_flag, c.set_flags);
+		add_flags(constraint->no_flag, c.no_flag, c.no_flags);
+		add_flags(constraint->has_flag, c.has_flag, c.has_flags);
+
+		c.image = images.size();
+		c.images = constraint->images.size();
+		constraints.push_back(c);
+
+		for (terrain_builder::rule_imagelist::const_iterator ri = constraint->images.begin(); ri != constraint->images.end(); ++ ri) {
+			ttb_image i;
+			i.layer = ri->layer;
+			i.basex = ri->basex;
+			i.basey = ri->basey;
+			i.global_image = ri->global_image? 1: 0;
+			i.center_x = ri->center_x;
+			i.center_y = ri->center_y;
+			i.variant = variants.size();
+			i.variants = ri->variants.size();
+			images.push_back(i);
+
+			// animated<image::locator> isn't saved, load_images will construct it when rule matches.
+			for (std::vector<terrain_builder::rule_image_variant>::const_iterator v = ri->variants.begin(); v != ri->variants.end(); ++ v) {
+				ttb_variant variant;
+				variant.image_string = add_string(v->image_string);
+				variant.variations = add_string(v->variations);
+				variant.random_start = v->random_start? 1: 0;
+				variants.push_back(variant);
+			}
+		}
+	}
+}
+
+template <typename T>
+static void tb_section_to_fp(posix_file_t fp, const std::vector<T>& section)
 {
-	posix_file_t						fp = INVALID_FILE;
-	uint32_t							max_str_len, u32n, idx, size, size1; 
+	if (!section.empty()) {
+		posix_fwrite(fp, &section[0], section.size() * sizeof(T));
+	}
+}
 
+void wml_building_rules_to_file(const std::string& fname, terrain_builder::building_rule* rules, uint32_t rules_size, uint32_t nfiles, uint32_t sum_size, uint32_t modified)
+{
 	posix_print("<xwml.cpp>::wml_building_rules_to_file------fname: %s, will save %u rules\n", fname.c_str(), rules_size);
 
-	posix_fopen(fname.c_str(), GENERIC_WRITE, CREATE_ALWAYS, fp);
-	if (fp == INVALID_FILE) {
+	tfile lock(fname, GENERIC_WRITE, CREATE_ALWAYS);
+	if (!lock.valid()) {
 		posix_print("------<xwml.cpp>::wml_building_rules_to_file, cannot create %s for wrtie\n", fname.c_str());
 		return;
 	}
 
-	// max str len
-	max_str_len = 63;
+	ttb_writer writer;
+	for (uint32_t rule_index = 0; rule_index < rules_size; rule_index ++) {
+		writer.add(rules[rule_index]);
+	}
+	// keep total size align to 4 bytes.
+	writer.chars.resize(posix_align_ceil(writer.chars.size(), 4), '\0');
+
+	ttb_header header;
+	header.version = TB_DAT_VERSION;
+	header.rules = writer.rules.size();
+	header.constraints = writer.constraints.size();
+	header.terrains = writer.terrains.size();
+	header.flags = writer.flags.size();
+	header.images = writer.images.size();
+	header.variants = writer.variants.size();
+	header.strings = writer.offsets.size();
+	header.chars = writer.chars.size();
+
 	// 0--15
-	u32n = mmioFOURCC('X', 'W', 'M', 'L');
-	posix_fwrite(fp, &u32n, 4);
-	posix_fwrite(fp, &nfiles, 4);
-	posix_fwrite(fp, &sum_size, 4);
-	posix_fwrite(fp, &modified, 4);
+	uint32_t u32n = mmioFOURCC('X', 'W', 'M', 'L');
+	posix_fwrite(lock.fp, &u32n, 4);
+	posix_fwrite(lock.fp, &nfiles, 4);
+	posix_fwrite(lock.fp, &sum_size, 4);
+	posix_fwrite(lock.fp, &modified, 4);
 
-	posix_fseek(fp, 16 + sizeof(max_str_len));
-	// rules size
-	posix_fwrite(fp, &rules_size, sizeof(rules_size));
+	posix_fwrite(lock.fp, &header, sizeof(header));
+	tb_section_to_fp(lock.fp, writer.rules);
+	tb_section_to_fp(lock.fp, writer.constraints);
+	tb_section_to_fp(lock.fp, writer.terrains);
+	tb_section_to_fp(lock.fp, writer.flags);
+	tb_section_to_fp(lock.fp, writer.images);
+	tb_section_to_fp(lock.fp, writer.variants);
+	tb_section_to_fp(lock.fp, writer.offsets);
+	if (!writer.chars.empty()) {
+		posix_fwrite(lock.fp, writer.chars.c_str(), writer.chars.size());
+	}
 
-	uint32_t rule_index = 0;
+	posix_print("------<xwml.cpp>::wml_building_rules_to_file, %u strings, %u bytes, return\n", header.strings, header.chars);
+}
 
-	for (rule_index = 0; rule_index < rules_size; rule_index ++) {
+bool wml_building_rules_current(const std::string& fname)
+{
+	tfile lock(fname, GENERIC_READ, OPEN_EXISTING);
+	if (!lock.valid()) {
+		return false;
+	}
+	if (posix_fsize(lock.fp) < (int64_t)(16 + sizeof(ttb_header))) {
+		return false;
+	}
+	uint32_t version = 0;
+	posix_fseek(lock.fp, 16);
+	posix_fread(lock.fp, &version, sizeof(version));
+	return version == TB_DAT_VERSION;
+}
 
-		//
-		// typedef std::multiset<building_rule> building_ruleset;
-		//
+template <typename T>
+static const T* tb_section_from_data(const uint8_t*& rdpos, uint32_t size)
+{
+	const T* ret = (const T*)rdpos;
+	rdpos += size * sizeof(T);
+	return ret;
+}
 
-		// building_rule
-		const terrain_builder::building_rule& rule = rules[rule_index];
+static void tb_terrains_from_data(t_translation::t_list& list, const ttb_terrain* terrains, uint32_t size)
+{
+	list.reserve(size);
+	for (uint32_t n = 0; n < size; n ++) {
+		list.push_back(t_translation::t_terrain(terrains[n].base, terrains[n].overlay));
+	}
+}
 
-		// *int precedence
-		posix_fwrite(fp, &rule.precedence, sizeof(int));
-		
-		// *map_location location_constraints;
-		posix_fwrite(fp, &rule.location_constraints.x, sizeof(int));
-		posix_fwrite(fp, &rule.location_constraints.y, sizeof(int));
-
-		// *int probability
-		posix_fwrite(fp, &rule.probability, sizeof(int));
-
-		// size of constraints
-		size = rule.constraints.size();
-		posix_fwrite(fp, &size, sizeof(uint32_t));
-
-		// constraint_set constraints
-		for (terrain_builder::constraint_set::const_iterator constraint = rule.constraints.begin(); constraint != rule.constraints.end(); ++constraint) {
-			// typedef std::vector<terrain_constraint> constraint_set;
-			posix_fwrite(fp, &constraint->loc.x, sizeof(int));
-			posix_fwrite(fp, &constraint->loc.y, sizeof(int));
-
-			//
-			// terrain_constraint
-			//
-
-			// t_translation::t_match terrain_types_match;
-			const t_translation::t_match& match = constraint->terrain_types_match;
-
-//			struct t_match{
-//				......
-//				t_list terrain;
-//				t_list mask;
-//				t_list masked_terrain;
-//				bool has_wildcard;
-//				bool is_empty;
-//			};
-
-			// typedef std::vector<t_terrain> t_list;
-			// terrain, maskmasked_terrain϶һ, Ϊʡռ,ֻдһֵ
-			size = match.terrain.size();
-			posix_fwrite(fp, &size, sizeof(size));
-			t_list_to_fp(fp, match.terrain, idx, size);
-			t_list_to_fp(fp, match.mask, idx, size);
-			t_list_to_fp(fp, match.masked_terrain, idx, size);
-			u32n = match.has_wildcard? 1: 0;
-			posix_fwrite(fp, &u32n, sizeof(int));
-			u32n = match.is_empty? 1: 0;
-			posix_fwrite(fp, &u32n, sizeof(int));
-
-			// std::vector<std::string> set_flag;
-			vstr_to_fp(fp, constraint->set_flag, idx, size, u32n, max_str_len);
-			// std::vector<std::string> no_flag;
-			vstr_to_fp(fp, constraint->no_flag, idx, size, u32n, max_str_len);
-			// std::vector<std::string> has_flag;
-			vstr_to_fp(fp, constraint->has_flag, idx, size, u32n, max_str_len);
-
-			// (typedef std::vector<rule_image> rule_imagelist) rule_imagelist images
-			size = constraint->images.size();
-			posix_fwrite(fp, &size, sizeof(size));
-			for (idx = 0; idx < size; idx ++) {
-				const struct terrain_builder::rule_image& ri = constraint->images[idx];
-				// rule_image
-
-//				struct rule_image {
-//					......
-//					int layer;
-//					int basex, basey;
-//					bool global_image;
-//					int center_x, center_y;
-//					rule_image_variantlist variants;
-//				}
-
-				posix_fwrite(fp, &ri.layer, sizeof(int));
-				posix_fwrite(fp, &ri.basex, sizeof(int));
-				posix_fwrite(fp, &ri.basey, sizeof(int));
-				u32n = ri.global_image? 1: 0;
-				posix_fwrite(fp, &u32n, sizeof(int));
-				posix_fwrite(fp, &ri.center_x, sizeof(int));
-				posix_fwrite(fp, &ri.center_y, sizeof(int));
-
-				// (std::vector<rule_image_variant>) variants
-				size1 = ri.variants.size();
-				posix_fwrite(fp, &size1, sizeof(size));
-				for (std::vector<terrain_builder::rule_image_variant>::const_iterator imgitor = ri.variants.begin(); imgitor != ri.variants.end(); ++imgitor) {
-					// value: rule_image_variant
-
-//					struct rule_image_variant {
-//						......
-//						std::string image_string;
-//						std::string variations;
-//						std::string tod;
-//						animated<image::locator> image;
-//						bool random_start;
-//					}
-
-					u32n = imgitor->image_string.size();
-					posix_fwrite(fp, &u32n, sizeof(u32n));	
-					posix_fwrite(fp, imgitor->image_string.c_str(), u32n);
-					max_str_len = posix_max(max_str_len, u32n);
-
-					u32n = imgitor->variations.size();
-					posix_fwrite(fp, &u32n, sizeof(u32n));	
-					posix_fwrite(fp, imgitor->variations.c_str(), u32n);
-					max_str_len = posix_max(max_str_len, u32n);
-
-					u32n = imgitor->random_start? 1: 0;
-					posix_fwrite(fp, &u32n, sizeof(int));
-
-
-					//
-					// Ϊֹֻrule_image_variantеimageû
-					// image漰class animatedclass locatorprivateԱݣֱӸֵ
-					// ǵfromʱҲù캯Թ࣬Ϲ캯Ĳˡ
-					// ɹ캯animatedlocatorοbool terrain_builder::start_animation(building_rule &rule)
-					//
-
-					// class animated
-					// int starting_frame_time_;
-					// bool does_not_change_;
-					// bool started_;
-					// bool need_first_update_;
-					// int start_tick_;
-					// bool cycles_;
-					// double acceleration_;
-					// int last_update_tick_;
-					// int current_frame_key_;
-					// +std::vector<frame> frames_;
-					// int duration_;
-					// int start_time_;
-					// +T value_;
-					// +class locator
-					// static int last_index_;
-					// int index_;
-					// value val_;
-
-//					struct value {
-//						......
-//						type type_;
-//						std::string filename_;
-//						map_location loc_;
-//						std::string modifications_;
-//						int center_x_;
-//						int center_y_;
-//					}
+static void tb_flags_from_data(std::vector<std::string>& vstr, const uint32_t* flags, uint32_t size, const uint32_t* offsets, const char* chars)
+{
+	vstr.reserve(size);
+	for (uint32_t n = 0; n < size; n ++) {
+		vstr.push_back(chars + offsets[flags[n]]);
+	}
+}
 
-				}
-			}
+// every index in records must be in its section, and every string must end in chars.
+static bool tb_indexes_valid(const ttb_header& header, const ttb_rule* rules, const ttb_constraint* constraints, const uint32_t* flags,
+	const ttb_image* images, const ttb_variant* variants, const uint32_t* offsets, const char* chars)
+{
+	for (uint32_t n = 0; n < header.rules; n ++) {
+		const ttb_rule& r = rules[n];
+		if ((uint64_t)r.constraint + r.constraints > header.constraints) {
+			return false;
 		}
 	}
-
-	// Ĵ洢С
-	posix_fseek(fp, 16);
-	posix_fwrite(fp, &max_str_len, sizeof(max_str_len));
-
-	posix_fclose(fp);
-
-	posix_print("------<xwml.cpp>::wml_building_rules_to_file, return\n");
-	return;
+	for (uint32_t n = 0; n < header.constraints; n ++) {
+		const ttb_constraint& c = constraints[n];
+		if ((uint64_t)c.terrain + 3 * (uint64_t)c.terrains > header.terrains) {
+			return false;
+		}
+		if ((uint64_t)c.set_flag + c.set_flags > header.flags || (uint64_t)c.no_flag + c.no_flags > header.flags || (uint64_t)c.has_flag + c.has_flags > header.flags) {
+			return false;
+		}
+		if ((uint64_t)c.image + c.images > header.images) {
+			return false;
+		}
+	}
+	for (uint32_t n = 0; n < header.flags; n ++) {
+		if (flags[n] >= header.strings) {
+			return false;
+		}
+	}
+	for (uint32_t n = 0; n < header.images; n ++) {
+		const ttb_image& i = images[n];
+		if ((uint64_t)i.variant + i.variants > header.variants) {
+			return false;
+		}
+	}
+	for (uint32_t n = 0; n < header.variants; n ++) {
+		const ttb_variant& v = variants[n];
+		if (v.image_string >= header.strings || v.variations >= header.strings) {
+			return false;
+		}
+	}
+	for (uint32_t n = 0; n < header.strings; n ++) {
+		if (offsets[n] >= header.chars) {
+			return false;
+		}
+	}
+	// last string is terminated, so is every one before it.
+	return !header.strings || chars[header.chars - 1] == '\0';
 }
 
-#define MAXLEN_BR_STRPLUS1		270
-
-typedef struct {
-	int first;
-	int second;
-} tmp_pair;
-
 terrain_builder::building_rule* wml_building_rules_from_file(const std::string& fname, uint32_t* rules_size_ptr)
 {
-	posix_file_t fp = INVALID_FILE;
-	int64_t fsize;
-	uint32_t datalen, max_str_len, rules_size, idx, len, size, size1, idx1, size2, idx2;
-	uint8_t* data = NULL, *strbuf = NULL, *variations = NULL;
-	uint8_t* rdpos;
-	terrain_builder::building_rule * rules = NULL;
-	map_location loc;
-	tmp_pair tmppair;
-
-	posix_print("<xwml.cpp>::wml_config_from_file------fname: %s\n", fname.c_str());
+	posix_print("<xwml.cpp>::wml_building_rules_from_file------fname: %s\n", fname.c_str());
 
 	if (rules_size_ptr) {
 		*rules_size_ptr = 0;
 	}
 
-	posix_fopen(fname.c_str(), GENERIC_READ, OPEN_EXISTING, fp);
-	if (fp == INVALID_FILE) {
+	tfile lock(fname, GENERIC_READ, OPEN_EXISTING);
+	if (!lock.valid()) {
 		posix_print("------<xwml.cpp>::wml_building_rules_from_file, cannot create %s for read\n", fname.c_str());
 		return NULL;
 	}
-	fsize = posix_fsize(fp);
-	if (fsize <= 16 + sizeof(max_str_len) + sizeof(rules_size)) {
-		posix_fclose(fp);
+	int64_t fsize = posix_fsize(lock.fp);
+	if (fsize < (int64_t)(16 + sizeof(ttb_header))) {
 		return NULL;
 	}
-	posix_fseek(fp, 16);
-	posix_fread(fp, &max_str_len, sizeof(max_str_len));
-	posix_fread(fp, &rules_size, sizeof(rules_size));
-
-	datalen = fsize - 16 - sizeof(max_str_len) - sizeof(rules_size);
-	data = (uint8_t *)malloc(datalen);
-	strbuf = (uint8_t *)malloc(max_str_len + 1);
-	variations = (uint8_t *)malloc(max_str_len + 1);
-
-	// read file data to memory
-	posix_fread(fp, data, datalen);
-
-	posix_print("max_str_len: %u, fsize: %u, datalen: %u\n", max_str_len, (int)fsize, datalen);
-	
-	rdpos = data;
+	const int data_len = (int)(fsize - 16);
+	lock.resize_data(data_len);
+	posix_fseek(lock.fp, 16);
+	posix_fread(lock.fp, lock.data, data_len);
 
-	// allocate memory for rules pointer array
-	if (rules_size) {
-		// rules = (terrain_builder::building_rule**)malloc(rules_size * sizeof(terrain_builder::building_rule**));
-		rules = new terrain_builder::building_rule[rules_size];
-	} else {
-		rules = NULL;
+	const ttb_header& header = *(const ttb_header*)lock.data;
+	const int64_t require_len = sizeof(ttb_header) + (int64_t)header.rules * sizeof(ttb_rule) + (int64_t)header.constraints * sizeof(ttb_constraint)
+		+ (int64_t)header.terrains * sizeof(ttb_terrain) + (int64_t)header.flags * sizeof(uint32_t) + (int64_t)header.images * sizeof(ttb_image)
+		+ (int64_t)header.variants * sizeof(ttb_variant) + (int64_t)header.strings * sizeof(uint32_t) + header.chars;
+	if (header.version != TB_DAT_VERSION || require_len != data_len) {
+		posix_print("------<xwml.cpp>::wml_building_rules_from_file, %s isn't version 0x%08x, require regenerate\n", fname.c_str(), TB_DAT_VERSION);
+		return NULL;
 	}
 
-	uint32_t rule_index = 0;
-/*
-	uint32_t previous, current, start, stop = SDL_GetTicks();
-*/
-	while (rdpos < data + datalen) {
-		int x, y;
-/*
-		start = stop;
-		posix_print("#%04u, (", rule_index);
-*/
-		// building_ruleset::iterator 
-		// terrain_builder::building_rule& pbr = *rules.insert(terrain_builder::building_rule());
-		// rules.push_back(terrain_builder::building_rule());
-		// terrain_builder::building_rule& pbr = rules.back();
-		// rules[rule_index] = new terrain_builder::building_rule;
-		terrain_builder::building_rule& pbr = rules[rule_index];
-/*
-		previous = SDL_GetTicks();
-		posix_print("%u", previous - start);
-*/
-
-		// precedence
-		memcpy(&pbr.precedence, rdpos, sizeof(int));
-		rdpos = rdpos + sizeof(int);
+	const uint8_t* rdpos = (const uint8_t*)lock.data + sizeof(ttb_header);
+	const ttb_rule* rules = tb_section_from_data<ttb_rule>(rdpos, header.rules);
+	const ttb_constraint* constraints = tb_section_from_data<ttb_constraint>(rdpos, header.constraints);
+	const ttb_terrain* terrains = tb_section_from_data<ttb_terrain>(rdpos, header.terrains);
+	const uint32_t* flags = tb_section_from_data<uint32_t>(rdpos, header.flags);
+	const ttb_image* images = tb_section_from_data<ttb_image>(rdpos, header.images);
+	const ttb_variant* variants = tb_section_from_data<ttb_variant>(rdpos, header.variants);
+	const uint32_t* offsets = tb_section_from_data<uint32_t>(rdpos, header.strings);
+	const char* chars = (const char*)rdpos;
+	if (!tb_indexes_valid(header, rules, constraints, flags, images, variants, offsets, chars)) {
+		posix_print("------<xwml.cpp>::wml_building_rules_from_file, %s has invalid index, require regenerate\n", fname.c_str());
+		return NULL;
+	}
 
-		// *map_location location_constraints;
-		memcpy(&x, rdpos, sizeof(int));
-		memcpy(&y, rdpos + sizeof(int), sizeof(int));
-		rdpos = rdpos + 2 * sizeof(int);
-		pbr.location_constraints = map_location(x, y);
+	terrain_builder::building_rule* result = header.rules? new terrain_builder::building_rule[header.rules]: NULL;
 
-		// *int probability
-		memcpy(&pbr.probability, rdpos, sizeof(int));
-		rdpos = rdpos + sizeof(int);
+	for (uint32_t rule_index = 0; rule_index < header.rules; rule_index ++) {
+		const ttb_rule& r = rules[rule_index];
+		terrain_builder::building_rule& pbr = result[rule_index];
 
-		// local
+		pbr.precedence = r.precedence;
+		pbr.location_constraints = map_location(r.x, r.y);
+		pbr.probability = r.probability;
 		pbr.local = false;
 
-		// size of constraints
-		memcpy(&size, rdpos, sizeof(int));
-		rdpos = rdpos + sizeof(int);
-/*
-		current = SDL_GetTicks();
-		posix_print(" + %u", current - previous);
-		previous = current;
-*/
-		for (idx = 0; idx < size; idx ++) {
-			// terrain_constraint
-			memcpy(&tmppair, rdpos, 8);
-			rdpos = rdpos + 8;
-			loc = map_location(tmppair.first, tmppair.second);
-
-			// pbr.constraints[loc] = terrain_builder::terrain_constraint(loc);
-			// constraint = pbr.constraints.find(loc);
-			pbr.constraints.push_back(terrain_builder::terrain_constraint(loc));
+		pbr.constraints.reserve(r.constraints);
+		for (uint32_t n = r.constraint; n < r.constraint + r.constraints; n ++) {
+			const ttb_constraint& c = constraints[n];
+			pbr.constraints.push_back(terrain_builder::terrain_constraint(map_location(c.x, c.y)));
 			terrain_builder::terrain_constraint& constraint = pbr.constraints.back();
 
-			//
-			// t_mach
-			//
 			t_translation::t_match& match = constraint.terrain_types_match;
-
-			// memcpy(&x, rdpos, sizeof(int));
-			// memcpy(&y, rdpos, sizeof(int));
-			// rdpos = rdpos + 2 * sizeof(int);
-
-			// size of terrain in t_mach
-			// constraints[loc].terrain_types_match = t_translation::t_terrain(x, y);
-
-			memcpy(&size1, rdpos, sizeof(uint32_t));
-			rdpos = rdpos + sizeof(uint32_t);
-			for (idx1 = 0; idx1 < size1; idx1 ++) {
-				memcpy(&tmppair, rdpos, 8);
-				match.terrain.push_back(t_translation::t_terrain(tmppair.first, tmppair.second));
-				rdpos = rdpos + 8;
-			}
-			for (idx1 = 0; idx1 < size1; idx1 ++) {
-				memcpy(&tmppair, rdpos, 8);
-				match.mask.push_back(t_translation::t_terrain(tmppair.first, tmppair.second));
-				rdpos = rdpos + 8;
-			}
-			for (idx1 = 0; idx1 < size1; idx1 ++) {
-				memcpy(&tmppair, rdpos, 8);
-				match.masked_terrain.push_back(t_translation::t_terrain(tmppair.first, tmppair.second));
-				rdpos = rdpos + 8;
-			}
-			memcpy(&tmppair, rdpos, 8);
-			match.has_wildcard = tmppair.first? true: false;
-			match.is_empty = tmppair.second? true: false;
-			rdpos = rdpos + 8;
-
-			// size of flags in set_flag
-			memcpy(&size1, rdpos, sizeof(uint32_t));
-			rdpos = rdpos + sizeof(uint32_t);
-			for (idx1 = 0; idx1 < size1; idx1 ++) {
-				memcpy(&len, rdpos, sizeof(uint32_t));
-				memcpy(strbuf, rdpos + sizeof(uint32_t), len);
-				strbuf[len] = 0;
-				constraint.set_flag.push_back((char*)strbuf);
-				rdpos = rdpos + sizeof(uint32_t) + len;				
-			}
-			// size of flags in no_flag
-			memcpy(&size1, rdpos, sizeof(uint32_t));
-			rdpos = rdpos + sizeof(uint32_t);
-			for (idx1 = 0; idx1 < size1; idx1 ++) {
-				memcpy(&len, rdpos, sizeof(uint32_t));
-				memcpy(strbuf, rdpos + sizeof(uint32_t), len);
-				strbuf[len] = 0;
-				constraint.no_flag.push_back((char*)strbuf);
-				rdpos = rdpos + sizeof(uint32_t) + len;				
-			}
-			// size of flags in has_flag
-			memcpy(&size1, rdpos, sizeof(uint32_t));
-			rdpos = rdpos + sizeof(uint32_t);
-			for (idx1 = 0; idx1 < size1; idx1 ++) {
-				memcpy(&len, rdpos, sizeof(uint32_t));
-				memcpy(strbuf, rdpos + sizeof(uint32_t), len);
-				strbuf[len] = 0;
-				constraint.has_flag.push_back((char*)strbuf);
-				rdpos = rdpos + sizeof(uint32_t) + len;				
-			}
-
-			// size of rule_image in rule_imagelist
-			memcpy(&size1, rdpos, sizeof(uint32_t));
-			rdpos = rdpos + sizeof(uint32_t);
-			for (idx1 = 0; idx1 < size1; idx1 ++) {
-				// struct terrain_builder::rule_image& ri = constraint->second.images[idx1];
-				// rule_image
-				int layer, center_x, center_y;
-				bool global_image;
-
-				memcpy(&layer, rdpos, sizeof(int));
-				memcpy(&x, rdpos + 4, sizeof(int));
-				memcpy(&y, rdpos + 8, sizeof(int));
-				memcpy(&len, rdpos + 12, sizeof(int));
-				global_image = len? true: false;
-				memcpy(&center_x, rdpos + 16, sizeof(int));
-				memcpy(&center_y, rdpos + 20, sizeof(int));
-				rdpos = rdpos + 24;
-
-				constraint.images.push_back(terrain_builder::rule_image(layer, x, y, global_image, center_x, center_y));
-
-				// size of rule_image in rule_imagelist
-				memcpy(&size2, rdpos, sizeof(uint32_t));
-				rdpos = rdpos + sizeof(uint32_t);
-				for (idx2 = 0; idx2 < size2; idx2 ++) {
-					bool random_start;
-
-					memcpy(&len, rdpos, sizeof(uint32_t));
-					memcpy(strbuf, rdpos + sizeof(uint32_t), len);
-					strbuf[len] = 0;
-					rdpos = rdpos + sizeof(uint32_t) + len;
-
-					// Adds the main (default) variant of the image, if present
-					memcpy(&len, rdpos, sizeof(uint32_t));
-					memcpy(variations, rdpos + sizeof(uint32_t), len);
-					variations[len] = 0;
-					rdpos = rdpos + sizeof(uint32_t) + len;
-
-					memcpy(&len, rdpos, sizeof(int));
-					random_start = len? true: false;
-					rdpos = rdpos + sizeof(int);
-					constraint.images.back().variants.push_back(terrain_builder::rule_image_variant((char*)strbuf, (char*)variations, random_start));
+			tb_terrains_from_data(match.terrain, terrains + c.terrain, c.terrains);
+			tb_terrains_from_data(match.mask, terrains + c.terrain + c.terrains, c.terrains);
+			tb_terrains_from_data(match.masked_terrain, terrains + c.terrain + 2 * c.terrains, c.terrains);
+			match.has_wildcard = c.has_wildcard? true: false;
+			match.is_empty = c.is_empty? true: false;
+
+			tb_flags_from_data(constraint.set_flag, flags + c.set_flag, c.set_flags, offsets, chars);
+			tb_flags_from_data(constraint.no_flag, flags + c.no_flag, c.no_flags, offsets, chars);
+			tb_flags_from_data(constraint.has_flag, flags + c.has_flag, c.has_flags, offsets, chars);
+
+			constraint.images.reserve(c.images);
+			for (uint32_t n2 = c.image; n2 < c.image + c.images; n2 ++) {
+				const ttb_image& i = images[n2];
+				constraint.images.push_back(terrain_builder::rule_image(i.layer, i.basex, i.basey, i.global_image? true: false, i.center_x, i.center_y));
+				std::vector<terrain_builder::rule_image_variant>& image_variants = constraint.images.back().variants;
+
+				image_variants.reserve(i.variants);
+				for (uint32_t n3 = i.variant; n3 < i.variant + i.variants; n3 ++) {
+					const ttb_variant& v = variants[n3];
+					image_variants.push_back(terrain_builder::rule_image_variant(chars + offsets[v.image_string], chars + offsets[v.variations], v.random_start? true: false));
 				}
 			}
-/*
-			current = SDL_GetTicks();
-			posix_print(" + %u", current - previous);
-			previous = current;
-*/
 		}
-/*
-		stop = SDL_GetTicks();
-		posix_print("), expend %u ms\n", stop - start);
-*/
-		rule_index ++;
-	}
-
-	if (fp != INVALID_FILE) {
-		posix_fclose(fp);
-	}
-	if (data) {
-		free(data);
-	}
-	if (strbuf) {
-		free(strbuf);
-	}
-	if (variations) {
-		free(variations);
 	}
 
 	if (rules_size_ptr) {
-		*rules_size_ptr = rule_index;
+		*rules_size_ptr = header.rules;
 	}
 
-	posix_print("------<xwml.cpp>::wml_building_rules_from_file, restore %u rules, return\n", rule_index);
-	return rules;
+	posix_print("------<xwml.cpp>::wml_building_rules_from_file, restore %u rules, return\n", header.rules);
+	return result;
 }
 
 // @short_res_path: if null, dir in dirs will save directly. else prefix of res_path will replace by short_res_path.
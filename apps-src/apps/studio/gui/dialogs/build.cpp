@@ -46,11 +46,17 @@ void tbuild::pre_show(gui2::ttrack& track)
 	task_status_ = &track;
 }
 
+void tbuild::tbuild_ctx::progress(const std::string& _name)
+{
+	// this is in thread. only the latest progress is required to draw.
+	thread_nfiles ++;
+	owner.post_main(boost::bind(&tbuild::handle_progress, &owner, _name, thread_nfiles), coalesce_progress);
+}
+
 static void increment_progress_cb2(std::string const &name, uint32_t param1, void* param2)
 {
 	tbuild::tbuild_ctx* ctx = (tbuild::tbuild_ctx*)param2;
-	ctx->name = name;
-	ctx->nfiles ++;
+	ctx->progress(name);
 }
 
 void tbuild::do_build2()
@@ -70,7 +76,8 @@ void tbuild::DoWork()
 		if (!desc.second.require_build) {
 			continue;
 		}
-		main_->Invoke<void>(RTC_FROM_HERE, rtc::Bind(&tbuild::handle_desc, this, desc, true, at, true));
+		build_ctx_.thread_nfiles = 0;
+		post_main(rtc::Bind(&tbuild::handle_desc, this, desc, true, at, true));
 
 		bool ret = false;
 		try {
@@ -78,7 +85,7 @@ void tbuild::DoWork()
 		} catch (twml_exception& e) {
 			e.show();
 		}
-		main_->Invoke<void>(RTC_FROM_HERE, rtc::Bind(&tbuild::handle_desc, this, desc, false, at, ret));
+		post_main(rtc::Bind(&tbuild::handle_desc, this, desc, false, at, ret));
 	}
 }
 
@@ -96,6 +103,12 @@ void tbuild::OnWorkDone()
 	task_status_->set_dirty();
 }
 
+void tbuild::handle_progress(const std::string& name, const size_t nfiles)
+{
+	build_ctx_.name = name;
+	build_ctx_.nfiles = nfiles;
+}
+
 void tbuild::handle_desc(const std::pair<teditor_::BIN_TYPE, teditor_::wml2bin_desc>& desc, const bool started, const int at, const bool ret)
 {
 	if (started) {
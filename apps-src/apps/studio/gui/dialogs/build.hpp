@@ -22,6 +22,7 @@ public:
 			: owner(owner)
 			, nfiles(0)
 			, desc_at(gui2::twidget::npos)
+			, thread_nfiles(0)
 		{}
 		void reset(int _desc_at)
 		{
@@ -29,11 +30,14 @@ public:
 			name.clear();
 			desc_at = _desc_at;
 		}
+		void progress(const std::string& _name);
 
 		size_t nfiles;
 		std::string name;
 		int desc_at;
 		tbuild& owner;
+		// counted in thread, nfiles gets it when main thread runs progress.
+		size_t thread_nfiles;
 	};
 
 protected:
@@ -46,6 +50,8 @@ protected:
 	void OnWorkDone() override;
 
 private:
+	enum {coalesce_progress = 1};
+	void handle_progress(const std::string& name, const size_t nfiles);
 	void handle_desc(const std::pair<teditor_::BIN_TYPE, teditor_::wml2bin_desc>& desc, const bool started, const int at, const bool ret);
 	void did_task_status(gui2::ttrack& widget, const SDL_Rect& widget_rect, const bool bg_drawn);
 
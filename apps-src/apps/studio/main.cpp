@@ -16,6 +16,7 @@
 #include "version.hpp"
 #include "mkwin_controller.hpp"
 #include "help.hpp"
+#include "benchmark.hpp"
 
 #include <errno.h>
 #include <iostream>
@@ -71,6 +72,24 @@ void game_instance::app_load_app_config(const config& cfg)
 	}
 }
 
+// "--benchmark" runs every benchmark, "--benchmark=name" the ones whose name starts with name.
+static bool benchmark_requested(int argc, char** argv, std::string& filter)
+{
+	const std::string key = "--benchmark";
+	for (int arg_ = 1; arg_ < argc; ++ arg_) {
+		const std::string option(argv[arg_]);
+		if (option == key) {
+			filter.clear();
+			return true;
+		}
+		if (option.size() > key.size() && option.compare(0, key.size() + 1, key + "=") == 0) {
+			filter = option.substr(key.size() + 1);
+			return true;
+		}
+	}
+	return false;
+}
+
 /**
  * Setups the game environment and enters
  * the titlescreen or game loops.
@@ -80,6 +99,14 @@ static int do_gameloop(int argc, char** argv)
 	instance_manager<game_instance> manager(argc, argv, "studio", _("Rose Studio"), "#rose", true);
 	game_instance& game = manager.get();
 
+	std::string filter;
+	if (benchmark_requested(argc, argv, filter)) {
+		if (!benchmark::run(filter)) {
+			posix_print("no benchmark matches %s\n", filter.c_str());
+		}
+		return 0;
+	}
+
 	try {
 		std::map<std::string, std::string> app_tdomains;
 		for (;;) {
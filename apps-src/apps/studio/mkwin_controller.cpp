@@ -331,6 +331,8 @@ mkwin_controller::mkwin_controller(const config &top_config, CVideo& video, cons
 
 mkwin_controller::~mkwin_controller()
 {
+	clear_journal();
+
 	if (gui_) {
 		delete gui_;
 		gui_ = NULL;
@@ -412,6 +414,12 @@ void mkwin_controller::app_execute_command(int command, const std::string& spara
 		case HOTKEY_PASTE:
 			paste_widget();
 			break;
+		case HOTKEY_UNDO:
+			undo();
+			break;
+		case HOTKEY_REDO:
+			redo();
+			break;
 		case tmkwin_scene::HOTKEY_ERASE:
 			erase_widget();
 			break;
@@ -424,6 +432,8 @@ void mkwin_controller::app_execute_command(int command, const std::string& spara
 			gui_->show_context_menu();
 			break;
 		case tmkwin_scene::HOTKEY_ERASE_CHILD:
+			// page erased deletes its units, journal may refer to them.
+			clear_journal();
 			u->parent().u->erase_child(u->parent().number);
 			if (!in_theme_top()) {
 				layout_dirty();
@@ -463,7 +473,7 @@ void mkwin_controller::app_execute_command(int command, const std::string& spara
 
 void mkwin_controller::insert_row(unit* u, bool top)
 {
-	const unit::tparent& parent = u->parent();
+	const unit::tparent parent = u->parent();
 	unit::tchild& child = parent.u? parent.u->child(parent.number): top_;
 
 	int row = u->get_location().y - child.window->get_location().y - 1;
@@ -471,21 +481,12 @@ void mkwin_controller::insert_row(unit* u, bool top)
 		row ++;
 	}
 	int w = (int)child.cols.size();
-	std::vector<unit*> v;
+	tjournal_item* item = new tjournal_item;
 	for (int x = 0; x < w; x ++) {
-		v.push_back(new unit(*this, *gui_, units_, gui_->spacer, parent.u, parent.number));
-	}
-	std::vector<unit*>::iterator it = child.units.begin();
-	if (row) {
-		std::advance(it, row * w);
+		item->push(parent.u, parent.number, tjournal_item::UNITS, row * w + x, nullptr, new unit(*this, *gui_, units_, gui_->spacer, parent.u, parent.number));
 	}
-	child.units.insert(it, v.begin(), v.end());
-
-	it = child.rows.begin();
-	if (row) {
-		std::advance(it, row);
-	}
-	child.rows.insert(it, new unit(*this, *gui_, units_, unit::ROW, parent.u, parent.number));
+	item->push(parent.u, parent.number, tjournal_item::ROWS, row, nullptr, new unit(*this, *gui_, units_, unit::ROW, parent.u, parent.number));
+	journal_execute(item);
 
 	layout_dirty();
 	gui_->show_context_menu();
@@ -493,27 +494,17 @@ void mkwin_controller::insert_row(unit* u, bool top)
 
 void mkwin_controller::erase_row(unit* u)
 {
-	const unit::tparent& parent = u->parent();
+	const unit::tparent parent = u->parent();
 	unit::tchild& child = parent.u? parent.u->child(parent.number): top_;
 
 	int row = u->get_location().y - child.window->get_location().y - 1;
 	int w = (int)child.cols.size();
-	std::vector<unit*>::iterator it;
+	tjournal_item* item = new tjournal_item;
 	for (int x = 0; x < w; x ++) {
-		unit* u = child.units[row * w];
-		units_.erase(u->get_location());
-
-		it = child.units.begin();
-		std::advance(it, row * w);
-		child.units.erase(it);
-	}
-	units_.erase(u->get_location());
-
-	it = child.rows.begin();
-	if (row) {
-		std::advance(it, row);
+		item->push(parent.u, parent.number, tjournal_item::UNITS, row * w, child.units[row * w + x], nullptr);
 	}
-	child.rows.erase(it);
+	item->push(parent.u, parent.number, tjournal_item::ROWS, row, u, nullptr);
+	journal_execute(item);
 
 	layout_dirty();
 
@@ -525,7 +516,7 @@ void mkwin_controller::erase_row(unit* u)
 
 void mkwin_controller::insert_column(unit* u, bool left)
 {
-	const unit::tparent& parent = u->parent();
+	const unit::tparent parent = u->parent();
 	unit::tchild& child = parent.u? parent.u->child(parent.number): top_;
 
 	int col = u->get_location().x - child.window->get_location().x - 1;
@@ -535,20 +526,12 @@ void mkwin_controller::insert_column(unit* u, bool left)
 	int w = (int)child.cols.size();
 	int h = (int)child.rows.size();
 	
-	std::vector<unit*>::iterator it;
+	tjournal_item* item = new tjournal_item;
 	for (int y = 0; y < h; y ++) {
-		unit* u = new unit(*this, *gui_, units_, gui_->spacer, parent.u, parent.number);
-
-		it = child.units.begin();
-		std::advance(it, y * w + col + y);
-		child.units.insert(it, u);
-	}
-	
-	it = child.cols.begin();
-	if (col) {
-		std::advance(it, col);
+		item->push(parent.u, parent.number, tjournal_item::UNITS, y * w + col + y, nullptr, new unit(*this, *gui_, units_, gui_->spacer, parent.u, parent.number));
 	}
-	child.cols.insert(it, new unit(*this, *gui_, units_, unit::COLUMN, parent.u, parent.number));
+	item->push(parent.u, parent.number, tjournal_item::COLS, col, nullptr, new unit(*this, *gui_, units_, unit::COLUMN, parent.u, parent.number));
+	journal_execute(item);
 
 	layout_dirty();
 	gui_->show_context_menu();
@@ -556,28 +539,18 @@ void mkwin_controller::insert_column(unit* u, bool left)
 
 void mkwin_controller::erase_column(unit* u)
 {
-	const unit::tparent& parent = u->parent();
+	const unit::tparent parent = u->parent();
 	unit::tchild& child = parent.u? parent.u->child(parent.number): top_;
 
 	int col = u->get_location().x - child.window->get_location().x - 1;
 	int w = (int)child.cols.size();
 	int h = (int)child.rows.size();
-	std::vector<unit*>::iterator it;
+	tjournal_item* item = new tjournal_item;
 	for (int y = 0; y < h; y ++) {
-		unit* u = child.units[y * w + col - y];
-		units_.erase(u->get_location());
-
-		it = child.units.begin();
-		std::advance(it, y * w + col - y);
-		child.units.erase(it);
+		item->push(parent.u, parent.number, tjournal_item::UNITS, y * w + col - y, child.units[y * w + col], nullptr);
 	}
-	units_.erase(u->get_location());
-
-	it = child.cols.begin();
-	if (col) {
-		std::advance(it, col);
-	}
-	child.cols.erase(it);
+	item->push(parent.u, parent.number, tjournal_item::COLS, col, u, nullptr);
+	journal_execute(item);
 
 	layout_dirty();
 	if (col >= (int)child.cols.size()) {
@@ -631,6 +604,7 @@ void mkwin_controller::generate_theme_top(unit::tchild& top, const int xdim, con
 
 void mkwin_controller::theme_into_widget(unit* u)
 {
+	clear_journal();
 	gui_->set_grid(false);
 
 	preview_ = false;
@@ -664,6 +638,7 @@ void mkwin_controller::theme_goto_top(bool auto_select)
 
 	gui_->set_grid(true);
 
+	clear_journal();
 	current_unit_ = NULL;
 	units_.zero_map();
 
@@ -757,24 +732,16 @@ void mkwin_controller::copy_widget(unit* u, bool cut)
 	gui_->show_context_menu();
 }
 
-bool mkwin_controller::paste_widget2(const unit& from, const map_location to_loc)
+bool mkwin_controller::paste_widget2(tjournal_item& item, const unit& from, const map_location to_loc)
 {
-	bool require_layout_dirty = false;
-
 	unit* to = units_.find_unit(to_loc);
 	unit::tparent parent = to->parent();
-	units_.erase(to_loc);
 	unit* clone = new unit(from);
 	// from and to maybe in different page.
 	clone->set_parent(parent.u, parent.number);	
-	units_.insert(to_loc, clone);
+	replace_unit(item, to_loc, clone);
 
-	to = units_.find_unit(to_loc);
-	replace_child_unit(to);
-	if (to->has_child()) {
-		require_layout_dirty = true;
-	}
-	return require_layout_dirty;
+	return clone->has_child();
 }
 
 void mkwin_controller::paste_widget()
@@ -786,9 +753,10 @@ void mkwin_controller::paste_widget()
 	unit* u = units_.find_unit(selected_hex_);
 	bool require_layout_dirty = false;
 	std::vector<const unit*> require_cut_widgets;
+	tjournal_item* item = new tjournal_item;
 
 	if (copied_unit_->type() == unit::WIDGET) {
-		require_layout_dirty = paste_widget2(*copied_unit_, selected_hex_);
+		require_layout_dirty = paste_widget2(*item, *copied_unit_, selected_hex_);
 		require_cut_widgets.push_back(copied_unit_);
 
 	} else if (copied_unit_->type() == unit::ROW) {
@@ -804,7 +772,7 @@ void mkwin_controller::paste_widget()
 		for (int x = 0; x < w; x ++) {
 			const unit* from = from_child.units[from_row * w + x];
 			const unit* to = to_child.units[to_row * w + x];
-			require_layout_dirty |= paste_widget2(*from, to->get_location());
+			require_layout_dirty |= paste_widget2(*item, *from, to->get_location());
 			require_cut_widgets.push_back(from);
 		}
 
@@ -823,7 +791,7 @@ void mkwin_controller::paste_widget()
 		for (int y = 0; y < h; y ++) {
 			const unit* from = from_child.units[y * from_w + from_col];
 			const unit* to = to_child.units[y * to_w + to_col];
-			require_layout_dirty |= paste_widget2(*from, to->get_location());
+			require_layout_dirty |= paste_widget2(*item, *from, to->get_location());
 			require_cut_widgets.push_back(from);
 		}
 
@@ -833,14 +801,12 @@ void mkwin_controller::paste_widget()
 			const unit* erasing = *it;
 			const map_location loc = erasing->get_location();
 			unit::tparent parent = erasing->parent();
-			units_.erase(loc);
+			replace_unit(*item, loc, new unit(*this, *gui_, units_, gui_->spacer, parent.u, parent.number));
 			VALIDATE(!copied_unit_ || copied_unit_->type() != unit::WIDGET, null_str);
-
-			units_.insert(loc, new unit(*this, *gui_, units_, gui_->spacer, parent.u, parent.number));
-			unit* u = units_.find_unit(loc);
-			replace_child_unit(u);
 		}
 	}
+	journal_commit(item);
+
 	if (require_layout_dirty) {
 		layout_dirty();
 	}
@@ -885,14 +851,14 @@ void mkwin_controller::erase_widget()
 			}
 		}
 	}
-	units_.erase(selected_hex_);
 	if (in_theme_top()) {
+		units_.erase(selected_hex_);
 		selected_hex_ = map_location();
 
 	} else {
-		units_.insert(selected_hex_, new unit(*this, *gui_, units_, gui_->spacer, parent.u, parent.number));
-		unit* u = units_.find_unit(selected_hex_);
-		replace_child_unit(u);
+		tjournal_item* item = new tjournal_item;
+		replace_unit(*item, selected_hex_, new unit(*this, *gui_, units_, gui_->spacer, parent.u, parent.number));
+		journal_commit(item);
 
 		if (has_child) {
 			layout_dirty();
@@ -941,7 +907,12 @@ void mkwin_controller::layout_dirty(bool force_change_map)
 		reload_map(w, h);
 	}
 
-	units_.layout(top_);
+	if (require_change || preview_) {
+		units_.layout(top_);
+	} else {
+		// map is kept, only units whose location changed are moved.
+		units_.relayout(top_);
+	}
 	if (require_change) {
 		gui_->recalculate_minimap();
 	} else {
@@ -1368,6 +1339,7 @@ void mkwin_controller::load_window()
 			return;
 		}
 
+		clear_journal();
 		top_.erase(units_);
 		
 		top_.from(*this, *gui_, units_, NULL, -1, top_grid);
@@ -1537,7 +1509,7 @@ void mkwin_controller::mouse_motion(int x, int y, const bool browse)
 	if (mouse_handler_base::mouse_motion_default(x, y)) return;
 	map_location hex_clicked = gui_->screen_2_loc(x, y);
 	last_hex_ = hex_clicked;
-	last_unit_ = units_.unit_clicked_on(x, y, last_hex_);
+	last_unit_ = units_.unit_clicked_on(x, y);
 
 	gui_->highlight_hex(hex_clicked);
 
@@ -1608,6 +1580,7 @@ void mkwin_controller::unpack_widget_tpl(unit* u)
 		}
 	}
 
+	clear_journal();
 	units_.erase(selected_hex_);
 
 	BOOST_FOREACH (const config& linked, linked_group_cfg.child_range("linked_group")) {
@@ -1672,6 +1645,130 @@ void mkwin_controller::replace_child_unit(unit* u)
 	child.units[at] = u;
 }
 
+tjournal_item::~tjournal_item()
+{
+	for (std::vector<tslot>::const_iterator it = slots.begin(); it != slots.end(); ++ it) {
+		unit* owned = done? it->before: it->after;
+		if (owned) {
+			delete owned;
+		}
+	}
+}
+
+void mkwin_controller::detach_unit(unit* u)
+{
+	for (const unit* it = copied_unit_; it; it = it->parent().u) {
+		if (it == u) {
+			set_copied_unit(nullptr);
+			break;
+		}
+	}
+	units_.detach(u);
+}
+
+// put u at loc, original unit is detached and kept by item.
+void mkwin_controller::replace_unit(tjournal_item& item, const map_location& loc, unit* u)
+{
+	unit* original = units_.find_unit(loc);
+	const unit::tparent parent = original->parent();
+	unit::tchild& child = parent.u? parent.u->child(parent.number): top_;
+
+	const map_location& window_loc = child.window->get_location();
+	int at = (loc.y - 1 - window_loc.y) * child.cols.size() + loc.x - 1 - window_loc.x;
+	VALIDATE(child.units[at] == original, null_str);
+	item.push(parent.u, parent.number, tjournal_item::UNITS, at, original, u);
+
+	detach_unit(original);
+	units_.insert(loc, u);
+	child.units[at] = u;
+}
+
+void mkwin_controller::journal_apply(tjournal_item& item, bool forward)
+{
+	const int slots = (int)item.slots.size();
+	for (int n = 0; n < slots; n ++) {
+		const tjournal_item::tslot& slot = item.slots[forward? n: slots - 1 - n];
+		unit::tchild& child = slot.parent? slot.parent->child(slot.number): top_;
+		std::vector<unit*>& line = slot.line == tjournal_item::ROWS? child.rows: (slot.line == tjournal_item::COLS? child.cols: child.units);
+		unit* leaving = forward? slot.before: slot.after;
+		unit* entering = forward? slot.after: slot.before;
+
+		if (leaving) {
+			VALIDATE(line[slot.at] == leaving, null_str);
+			detach_unit(leaving);
+			if (entering) {
+				line[slot.at] = entering;
+			} else {
+				line.erase(line.begin() + slot.at);
+			}
+		} else {
+			line.insert(line.begin() + slot.at, entering);
+		}
+	}
+	item.done = forward;
+}
+
+void mkwin_controller::journal_execute(tjournal_item* item)
+{
+	journal_apply(*item, true);
+	journal_commit(item);
+}
+
+void mkwin_controller::journal_commit(tjournal_item* item)
+{
+	const size_t max_journal_items = 64;
+
+	if (preview_ || item->slots.empty()) {
+		// theme isn't journaled, units that left are deleted now.
+		delete item;
+		return;
+	}
+	redo_.clear();
+	undo_.push_back(std::unique_ptr<tjournal_item>(item));
+	if (undo_.size() > max_journal_items) {
+		undo_.erase(undo_.begin());
+	}
+}
+
+void mkwin_controller::clear_journal()
+{
+	// items only delete units out of tree, order isn't matter.
+	redo_.clear();
+	undo_.clear();
+}
+
+void mkwin_controller::undo()
+{
+	if (undo_.empty()) {
+		return;
+	}
+	std::unique_ptr<tjournal_item> item(std::move(undo_.back()));
+	undo_.pop_back();
+	journal_apply(*item, false);
+	redo_.push_back(std::move(item));
+
+	selected_hex_ = map_location();
+	layout_dirty();
+	fill_object_list();
+	gui_->show_context_menu();
+}
+
+void mkwin_controller::redo()
+{
+	if (redo_.empty()) {
+		return;
+	}
+	std::unique_ptr<tjournal_item> item(std::move(redo_.back()));
+	redo_.pop_back();
+	journal_apply(*item, true);
+	undo_.push_back(std::move(item));
+
+	selected_hex_ = map_location();
+	layout_dirty();
+	fill_object_list();
+	gui_->show_context_menu();
+}
+
 bool mkwin_controller::left_mouse_down(int x, int y, const bool browse)
 {
 	if (mouse_handler_base::left_mouse_down(x, y, browse)) {
@@ -1697,17 +1794,17 @@ bool mkwin_controller::left_mouse_down(int x, int y, const bool browse)
 		u = units_.find_unit(selected_hex_);
 		if (!preview_ && u && gui_->selected_widget() != gui_->spacer && u->is_spacer()) {
 			unit::tparent parent = u->parent();
-			units_.erase(selected_hex_);
+			tjournal_item* item = new tjournal_item;
 
-			units_.insert(selected_hex_, new unit(*this, *gui_, units_, gui_->selected_widget(), parent.u, parent.number));
-			u = units_.find_unit(selected_hex_);
+			u = new unit(*this, *gui_, units_, gui_->selected_widget(), parent.u, parent.number);
+			replace_unit(*item, selected_hex_, u);
 			derive_create(u);
 			
 			if (u->is_tpl()) {
 				u->cell().id = unit::form_tpl_widget_id(unit::extract_from_widget_tpl(u->widget().first));
 			}
 
-			replace_child_unit(u);
+			journal_commit(item);
 			if (u->has_child()) {
 				layout_dirty();
 			}
@@ -2153,6 +2250,10 @@ bool mkwin_controller::in_context_menu(const std::string& id) const
 		return can_copy(u, true);
 	case HOTKEY_PASTE:
 		return can_paste(u);
+	case HOTKEY_UNDO:
+		return !preview_ && !undo_.empty();
+	case HOTKEY_REDO:
+		return !preview_ && !redo_.empty();
 
 	// unit
 	case tmkwin_scene::HOTKEY_ERASE: // erase
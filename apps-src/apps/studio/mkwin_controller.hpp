@@ -78,6 +78,50 @@ struct tfloat_widget
 	std::unique_ptr<unit> u;
 };
 
+/**
+ * one designer edit, as slot changes of grid lines. a unit leaving the tree is kept
+ * by its item instead of deleted, so undo and redo only relink pointers.
+ */
+struct tjournal_item
+{
+	enum {UNITS, ROWS, COLS};
+
+	struct tslot
+	{
+		tslot(unit* parent, int number, int line, int at, unit* before, unit* after)
+			: parent(parent)
+			, number(number)
+			, line(line)
+			, at(at)
+			, before(before)
+			, after(after)
+		{}
+
+		unit* parent;
+		int number;
+		int line;
+		int at;
+		// before null: insert at, after null: erase at.
+		unit* before;
+		unit* after;
+	};
+
+	tjournal_item()
+		: slots()
+		, done(true)
+	{}
+	~tjournal_item();
+
+	void push(unit* parent, int number, int line, int at, unit* before, unit* after)
+	{
+		slots.push_back(tslot(parent, number, line, at, before, after));
+	}
+
+	std::vector<tslot> slots;
+	// done: before units are out of tree and owned here. else after units are.
+	bool done;
+};
+
 /**
  * The editor_controller class containts the mouse and keyboard event handling
  * routines for the editor. It also serves as the main editor class with the
@@ -260,7 +304,16 @@ private:
 	void form_context_menu(tmenu2& menu, const config& cfg, const std::string& menu_id);
 
 	void fill_object_list();
-	bool paste_widget2(const unit& from, const map_location to_loc);
+	bool paste_widget2(tjournal_item& item, const unit& from, const map_location to_loc);
+
+	void detach_unit(unit* u);
+	void replace_unit(tjournal_item& item, const map_location& loc, unit* u);
+	void journal_apply(tjournal_item& item, bool forward);
+	void journal_execute(tjournal_item* item);
+	void journal_commit(tjournal_item* item);
+	void clear_journal();
+	void undo();
+	void redo();
 
 	std::vector<std::string> generate_textdomains(const std::string& file, bool scene) const;
 
@@ -299,6 +352,9 @@ private:
 	std::set<const config*> used_widget_tpl_;
 
 	std::map<std::string, std::string> app_tdomains_;
+
+	std::vector<std::unique_ptr<tjournal_item> > undo_;
+	std::vector<std::unique_ptr<tjournal_item> > redo_;
 };
 
 #endif
@@ -25,6 +25,7 @@
 unit_map::unit_map(mkwin_controller& controller, const tmap& gmap, bool consistent)
 	: base_map(controller, gmap, consistent)
 	, controller_(controller)
+	, placements_(nullptr)
 {
 }
 
@@ -58,6 +59,7 @@ void unit_map::create_coor_map(int w, int h)
 			} else {
 				coor_map_[pitch + loc.x].overlay = n;
 			}
+			click_index_insert(*n);
 		}
 	}
 }
@@ -99,6 +101,36 @@ bool unit_map::erase(const map_location& loc, bool overlay)
 	return erase2(u, true);
 }
 
+bool unit_map::in_map(const unit* u) const
+{
+	// copied units carry map index of their source, so check the slot too.
+	const int index = u->get_map_index();
+	return index != UNIT_NO_INDEX && index < map_vsize_ && map_[index] == u;
+}
+
+void unit_map::detach(unit* u)
+{
+	if (u->consistent()) {
+		const std::vector<unit::tchild>& children = u->children();
+		for (std::vector<unit::tchild>::const_iterator it = children.begin(); it != children.end(); ++ it) {
+			const unit::tchild& child = *it;
+			for (std::vector<unit*>::const_iterator it2 = child.units.begin(); it2 != child.units.end(); ++ it2) {
+				detach(*it2);
+			}
+			for (std::vector<unit*>::const_iterator it2 = child.rows.begin(); it2 != child.rows.end(); ++ it2) {
+				detach(*it2);
+			}
+			for (std::vector<unit*>::const_iterator it2 = child.cols.begin(); it2 != child.cols.end(); ++ it2) {
+				detach(*it2);
+			}
+			detach(child.window);
+		}
+	}
+	if (in_map(u)) {
+		erase2(u, false);
+	}
+}
+
 void unit_map::save_map_to(unit::tchild& child, bool clear)
 {
 	child.clear(false);
@@ -171,7 +203,7 @@ std::vector<unit*> unit_map::form_units() const
 void unit_map::restore_map_from(const unit::tchild& child, const int xstart, const int ystart, bool create)
 {
 	const int serial_gap = 1;
-	if (create) {
+	if (create && !placements_) {
 		VALIDATE(xstart || ystart || !map_vsize_, "map_vsize_ must be 0.");
 	}
 
@@ -183,12 +215,12 @@ void unit_map::restore_map_from(const unit::tchild& child, const int xstart, con
 		int h = (int)child.rows.size();
 		
 		if (create) {
-			insert(map_location(xstart, ystart), window);
+			place_unit(map_location(xstart, ystart), window);
 			for (int x = 0; x < w; x ++) {
-				insert(map_location(xstart + x + 1, ystart), child.cols[x]);
+				place_unit(map_location(xstart + x + 1, ystart), child.cols[x]);
 			}
 			for (int y = 0; y < h; y ++) {
-				insert(map_location(xstart, ystart + y + 1), child.rows[y]);
+				place_unit(map_location(xstart, ystart + y + 1), child.rows[y]);
 			}
 		}
 		int uindex = 0;
@@ -199,7 +231,7 @@ void unit_map::restore_map_from(const unit::tchild& child, const int xstart, con
 			for (int x = 1; x <= w; x ++) {
 				unit* u = child.units[uindex ++];
 				if (create) {
-					insert(map_location(xstart + x, ystart + y), u);
+					place_unit(map_location(xstart + x, ystart + y), u);
 				}
 				const std::vector<unit::tchild>& children = u->children();
 				
@@ -282,14 +314,7 @@ void unit_map::zero_map()
 	// attention! if map_vsize_ != 0, means has unit in base_map, you maybe call display::invalidate_all to redraw them.
 	// don't delete unit during here. only set map_vsize to 0.
 	// unit is saved by tmkwin_controller::top_.
-
-	if (map_) {
-		memset(map_, 0, map_size_ * sizeof(base_unit*));
-		map_vsize_ = 0;
-	}
-	if (coor_map_) {
-		memset(coor_map_, 0, w_ * h_ * sizeof(loc_cookie));
-	}
+	zero_units();
 }
 
 void unit_map::layout(const unit::tchild& child)
@@ -302,6 +327,45 @@ void unit_map::layout(const unit::tchild& child)
 	}
 }
 
+void unit_map::place_unit(const map_location& loc, unit* u)
+{
+	if (placements_) {
+		placements_->push_back(std::make_pair(u, loc));
+	} else {
+		insert(loc, u);
+	}
+}
+
+void unit_map::relayout(const unit::tchild& child)
+{
+	// same result as layout, but units that keep their location stay in map.
+	std::vector<std::pair<unit*, map_location> > placements;
+	placements_ = &placements;
+	restore_map_from(child, 0, 0, true);
+	placements_ = nullptr;
+
+	for (std::vector<std::pair<unit*, map_location> >::iterator it = placements.begin(); it != placements.end(); ++ it) {
+		unit* u = it->first;
+		if (in_map(u)) {
+			if (u->get_location() == it->second) {
+				it->first = nullptr;
+				continue;
+			}
+			erase2(u, false);
+		}
+	}
+
+	display& disp = controller_.get_display();
+	for (std::vector<std::pair<unit*, map_location> >::const_iterator it = placements.begin(); it != placements.end(); ++ it) {
+		unit* u = it->first;
+		if (u) {
+			insert(it->second, u);
+			disp.invalidate(u->get_draw_locations());
+		}
+	}
+	VALIDATE(map_vsize_ == (int)placements.size(), null_str);
+}
+
 bool unit_map::line_is_spacer(bool row, int index) const
 {
 	if (row) {
@@ -35,6 +35,8 @@ public:
 	void clear();
 	void add(const map_location& loc, const base_unit* base_u);
 	bool erase(const map_location& loc, bool overlay = true);
+	// like erase, but u and its children are kept, caller owns them.
+	void detach(unit* u);
 
 	void zero_map();
 	void save_map_to(unit::tchild& child, bool clear);
@@ -44,11 +46,18 @@ public:
 	tpoint restore_map_from(const std::vector<unit::tchild>& children, bool create);
 	void recalculate_size(const unit::tchild& child);
 	void layout(const unit::tchild& child);
+	void relayout(const unit::tchild& child);
 
 	bool line_is_spacer(bool row, int index) const;
 
+private:
+	bool in_map(const unit* u) const;
+	void place_unit(const map_location& loc, unit* u);
+
 private:
 	mkwin_controller& controller_;
+	// when not null, restore_map_from collects locations here instead of inserting.
+	std::vector<std::pair<unit*, map_location> >* placements_;
 };
 
 #endif